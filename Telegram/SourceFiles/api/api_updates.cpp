@@ -15,8 +15,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "api/api_user_privacy.h"
 #include "api/api_unread_things.h"
 #include "api/api_transcribes.h"
+#include "api/api_updates_recorder.h"
+#include "core/core_trace.h"
 #include "main/main_session.h"
 #include "main/main_account.h"
+#include "main/main_domain.h"
 #include "mtproto/mtp_instance.h"
 #include "mtproto/mtproto_config.h"
 #include "mtproto/mtproto_dc_options.h"
@@ -102,6 +105,26 @@ bool IsForceLogoutNotification(const MTPDupdateServiceNotification &data) {
 	return qs(data.vtype()).startsWith(u"AUTH_KEY_DROP_"_q);
 }
 
+[[nodiscard]] bool IsAppliedWithoutPtsCheck(mtpTypeId type) {
+	switch (type) {
+	case mtpc_updateNewMessage:
+	case mtpc_updateReadMessagesContents:
+	case mtpc_updateReadHistoryInbox:
+	case mtpc_updateReadHistoryOutbox:
+	case mtpc_updateWebPage:
+	case mtpc_updateFolderPeers:
+	case mtpc_updateDeleteMessages:
+	case mtpc_updateNewChannelMessage:
+	case mtpc_updateEditChannelMessage:
+	case mtpc_updatePinnedChannelMessages:
+	case mtpc_updateEditMessage:
+	case mtpc_updateChannelWebPage:
+	case mtpc_updateDeleteChannelMessages:
+	case mtpc_updatePinnedMessages: return true;
+	}
+	return false;
+}
+
 bool HasForceLogoutNotification(const MTPUpdates &updates) {
 	const auto checkUpdate = [](const MTPUpdate &update) {
 		if (update.type() != mtpc_updateServiceNotification) {
@@ -275,6 +298,8 @@ Updates::Updates(not_null<Main::Session*> session)
 	}, _lifetime);
 }
 
+Updates::~Updates() = default;
+
 Main::Session &Updates::session() const {
 	return *_session;
 }
@@ -355,7 +380,7 @@ void Updates::setState(int32 pts, int32 date, int32 qts, int32 seq) {
 				const auto v = _bySeqUpdates.front().second;
 				_bySeqUpdates.erase(_bySeqUpdates.begin());
 				if (s == seq + 1) {
-					return applyUpdates(v);
+					return applyUpdatesWithPtsCheck(v, 0);
 				}
 			} else {
 				if (!_bySeqTimer.isActive()) {
@@ -370,6 +395,9 @@ void Updates::setState(int32 pts, int32 date, int32 qts, int32 seq) {
 void Updates::channelDifferenceDone(
 		not_null<ChannelData*> channel,
 		const MTPupdates_ChannelDifference &difference) {
+	if (_recorder) {
+		_recorder->write(difference);
+	}
 	_channelFailDifferenceTimeout.remove(channel);
 
 	const auto timeout = difference.match([&](const auto &data) {
@@ -463,6 +491,9 @@ void Updates::stateDone(const MTPupdates_State &state) {
 }
 
 void Updates::differenceDone(const MTPupdates_Difference &result) {
+	if (_recorder) {
+		_recorder->write(result);
+	}
 	_failDifferenceTimeout = 1;
 
 	switch (result.type()) {
@@ -797,6 +828,9 @@ void Updates::channelRangeDifferenceDone(
 		not_null<ChannelData*> channel,
 		MsgRange range,
 		const MTPupdates_ChannelDifference &result) {
+	if (_recorder) {
+		_recorder->write(result);
+	}
 	auto nextRequestPts = int32(0);
 	auto isFinal = true;
 
@@ -860,6 +894,163 @@ void Updates::mtpUpdateReceived(const MTPUpdates &updates) {
 	}
 }
 
+bool Updates::startRecording(const QString &path) {
+	auto recorder = std::make_unique<UpdatesRecorder>(
+		path,
+		session().userId());
+	if (!recorder->valid()) {
+		return false;
+	}
+	_recorder = std::move(recorder);
+	LOG(("Updates Recorder: Started to '%1'.").arg(path));
+	return true;
+}
+
+void Updates::stopRecording() {
+	if (const auto recorder = base::take(_recorder)) {
+		LOG(("Updates Recorder: Written %1 records to '%2'."
+			).arg(recorder->count()
+			).arg(recorder->path()));
+	}
+}
+
+bool Updates::recording() const {
+	return (_recorder != nullptr);
+}
+
+QString Updates::replayRecorded(const UpdatesRecording &recording) {
+	// Never apply recorded updates to one of the real accounts.
+	Expects(!ranges::contains(
+		Core::App().domain().accounts(),
+		&session().account(),
+		[](const Main::Domain::AccountWithIndex &value) {
+			return value.account.get();
+		}));
+
+	auto stats = UpdatesReplayStats();
+	for (const auto &record : recording.list) {
+		v::match(record, [&](const auto &data) {
+			replayOne(data, stats);
+		});
+	}
+	return stats.report();
+}
+
+void Updates::replayUpdate(
+		const MTPUpdate &update,
+		UpdatesReplayStats &stats) {
+	const auto start = ReplayTimestamp();
+	if (IsAppliedWithoutPtsCheck(update.type())) {
+		applyUpdateNoPtsCheck(update);
+	} else {
+		feedUpdate(update);
+	}
+	stats.add(update, ReplayTimestamp() - start);
+}
+
+void Updates::replayOne(
+		const MTPUpdates &updates,
+		UpdatesReplayStats &stats) {
+	const auto feedVector = [&](
+			const MTPVector<MTPUser> &users,
+			const MTPVector<MTPChat> &chats,
+			const MTPVector<MTPUpdate> &list) {
+		const auto start = ReplayTimestamp();
+		session().data().processUsers(users);
+		session().data().processChats(chats);
+		stats.add(updates, ReplayTimestamp() - start);
+		for (const auto &update : list.v) {
+			replayUpdate(update, stats);
+		}
+	};
+	switch (updates.type()) {
+	case mtpc_updates: {
+		const auto &d = updates.c_updates();
+		feedVector(d.vusers(), d.vchats(), d.vupdates());
+	} break;
+
+	case mtpc_updatesCombined: {
+		const auto &d = updates.c_updatesCombined();
+		feedVector(d.vusers(), d.vchats(), d.vupdates());
+	} break;
+
+	case mtpc_updateShort: {
+		replayUpdate(updates.c_updateShort().vupdate(), stats);
+	} break;
+
+	case mtpc_updateShortMessage:
+	case mtpc_updateShortChatMessage:
+	case mtpc_updateShortSentMessage: {
+		const auto start = ReplayTimestamp();
+		applyUpdatesNoPtsCheck(updates);
+		stats.add(updates, ReplayTimestamp() - start);
+	} break;
+	}
+
+	// Attribute the notifications to the envelope type.
+	const auto start = ReplayTimestamp();
+	session().data().sendHistoryChangeNotifications();
+	stats.add(updates, ReplayTimestamp() - start);
+}
+
+void Updates::replayOne(
+		const MTPupdates_Difference &difference,
+		UpdatesReplayStats &stats) {
+	const auto feed = [&](const auto &data) {
+		const auto start = ReplayTimestamp();
+		session().data().processUsers(data.vusers());
+		session().data().processChats(data.vchats());
+		session().data().processMessages(
+			data.vnew_messages(),
+			NewMessageType::Unread);
+		stats.add(difference, ReplayTimestamp() - start);
+		for (const auto &update : data.vother_updates().v) {
+			replayUpdate(update, stats);
+		}
+	};
+	difference.match([&](const MTPDupdates_difference &data) {
+		feed(data);
+	}, [&](const MTPDupdates_differenceSlice &data) {
+		feed(data);
+	}, [](const auto &) {
+	});
+
+	const auto start = ReplayTimestamp();
+	session().data().sendHistoryChangeNotifications();
+	stats.add(difference, ReplayTimestamp() - start);
+}
+
+void Updates::replayOne(
+		const MTPupdates_ChannelDifference &difference,
+		UpdatesReplayStats &stats) {
+	difference.match([&](const MTPDupdates_channelDifference &data) {
+		const auto start = ReplayTimestamp();
+		session().data().processUsers(data.vusers());
+		session().data().processChats(data.vchats());
+		session().data().processMessages(
+			data.vnew_messages(),
+			NewMessageType::Unread);
+		stats.add(difference, ReplayTimestamp() - start);
+		for (const auto &update : data.vother_updates().v) {
+			replayUpdate(update, stats);
+		}
+	}, [&](const MTPDupdates_channelDifferenceTooLong &data) {
+		const auto start = ReplayTimestamp();
+		session().data().processUsers(data.vusers());
+		session().data().processChats(data.vchats());
+		session().data().applyDialogs(
+			nullptr,
+			data.vmessages().v,
+			QVector<MTPDialog>(1, data.vdialog()));
+		stats.add(difference, ReplayTimestamp() - start);
+	}, [](const MTPDupdates_channelDifferenceEmpty &) {
+	});
+
+	const auto start = ReplayTimestamp();
+	session().data().sendHistoryChangeNotifications();
+	stats.add(difference, ReplayTimestamp() - start);
+}
+
 void Updates::applyGroupCallParticipantUpdates(const MTPUpdates &updates) {
 	updates.match([&](const MTPDupdates &data) {
 		session().data().processUsers(data.vusers());
@@ -1353,6 +1544,16 @@ void Updates::applyUpdateNoPtsCheck(const MTPUpdate &update) {
 void Updates::applyUpdates(
 		const MTPUpdates &updates,
 		uint64 sentMessageRandomId) {
+	if (_recorder) {
+		_recorder->write(updates);
+	}
+	applyUpdatesWithPtsCheck(updates, sentMessageRandomId);
+}
+
+void Updates::applyUpdatesWithPtsCheck(
+		const MTPUpdates &updates,
+		uint64 sentMessageRandomId) {
+	const auto trace = Core::Trace::Scope("Api::Updates::applyUpdates");
 	const auto randomId = sentMessageRandomId;
 
 	switch (updates.type()) {
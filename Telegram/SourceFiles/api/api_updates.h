@@ -27,9 +27,14 @@ struct EmojiInteractionsBunch;
 
 namespace Api {
 
+class UpdatesRecorder;
+class UpdatesReplayStats;
+struct UpdatesRecording;
+
 class Updates final {
 public:
 	explicit Updates(not_null<Main::Session*> session);
+	~Updates();
 
 	[[nodiscard]] Main::Session &session() const;
 	[[nodiscard]] ApiWrap &api() const;
@@ -64,6 +69,15 @@ public:
 
 	void addActiveChat(rpl::producer<PeerData*> chat);
 
+	// Record received updates and differences to a file.
+	bool startRecording(const QString &path);
+	void stopRecording();
+	[[nodiscard]] bool recording() const;
+
+	// Applies a recording bypassing the pts checks, to profile update
+	// storms. Only for a throwaway session, see ReplayInThrowawaySession.
+	[[nodiscard]] QString replayRecorded(const UpdatesRecording &recording);
+
 private:
 	enum class ChannelDifferenceRequest {
 		Unknown,
@@ -130,8 +144,20 @@ private:
 	// Doesn't call sendHistoryChangeNotifications itself.
 	void feedUpdate(const MTPUpdate &update);
 
+	void applyUpdatesWithPtsCheck(
+		const MTPUpdates &updates,
+		uint64 sentMessageRandomId);
 	void applyGroupCallParticipantUpdates(const MTPUpdates &updates);
 
+	void replayUpdate(const MTPUpdate &update, UpdatesReplayStats &stats);
+	void replayOne(const MTPUpdates &updates, UpdatesReplayStats &stats);
+	void replayOne(
+		const MTPupdates_Difference &difference,
+		UpdatesReplayStats &stats);
+	void replayOne(
+		const MTPupdates_ChannelDifference &difference,
+		UpdatesReplayStats &stats);
+
 	bool whenGetDiffChanged(
 		ChannelData *channel,
 		int32 ms,
@@ -207,6 +233,8 @@ private:
 	bool _lastWasOnline = false;
 	rpl::variable<bool> _isIdle = false;
 
+	std::unique_ptr<UpdatesRecorder> _recorder;
+
 	rpl::lifetime _lifetime;
 
 };
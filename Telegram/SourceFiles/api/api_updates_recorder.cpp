@@ -0,0 +1,312 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "api/api_updates_recorder.h"
+
+#include "api/api_updates.h"
+#include "base/random.h"
+#include "core/application.h"
+#include "main/main_account.h"
+#include "main/main_domain.h"
+#include "main/main_session.h"
+#include "main/main_session_settings.h"
+#include "mtproto/details/mtproto_dump_to_text.h"
+#include "mtproto/mtproto_auth_key.h"
+#include "mtproto/mtproto_config.h"
+#include "mtproto/mtproto_dc_options.h"
+#include "storage/storage_account.h"
+
+#include <chrono>
+
+namespace Api {
+namespace {
+
+constexpr auto kRecordMagic = quint32(0x52445554); // "TUDR"
+constexpr auto kRecordVersion = qint32(2);
+constexpr auto kMaxRecordPrimes = qint32(16 * 1024 * 1024);
+constexpr auto kThrowawayDcId = MTP::DcId(2);
+constexpr auto kThrowawayPort = 1;
+
+enum class RecordKind : qint32 {
+	Updates = 0,
+	Difference = 1,
+	ChannelDifference = 2,
+};
+
+template <typename Type>
+[[nodiscard]] mtpBuffer Serialize(const Type &data) {
+	auto result = mtpBuffer();
+	data.write(result);
+	return result;
+}
+
+template <typename Type>
+[[nodiscard]] QString NameFromDump(const Type &data) {
+	const auto buffer = Serialize(data);
+	auto from = buffer.constData();
+	const auto text = MTP::details::DumpToText(
+		from,
+		from + buffer.size());
+	return text.section(QChar('\n'), 0, 0).remove('{').trimmed();
+}
+
+template <typename Type>
+[[nodiscard]] std::optional<RecordedUpdate> Parse(const mtpBuffer &buffer) {
+	auto from = buffer.constData();
+	auto result = Type();
+	if (!result.read(from, from + buffer.size())) {
+		return std::nullopt;
+	}
+	return RecordedUpdate(std::move(result));
+}
+
+[[nodiscard]] std::unique_ptr<MTP::Config> ThrowawayConfig() {
+	auto result = std::make_unique<MTP::Config>(MTP::Environment::Test);
+
+	// The only endpoint is a closed local port, so the requests
+	// of the throwaway session never leave this machine.
+	result->dcOptions().setFromList(MTP_vector<MTPDcOption>(
+		1,
+		MTP_dcOption(
+			MTP_flags(MTPDdcOption::Flags(0)),
+			MTP_int(kThrowawayDcId),
+			MTP_string("127.0.0.1"),
+			MTP_int(kThrowawayPort),
+			MTPbytes())));
+	return result;
+}
+
+[[nodiscard]] MTP::AuthKeyPtr ThrowawayLocalKey() {
+	auto key = MTP::AuthKey::Data{ { gsl::byte{} } };
+	base::RandomFill(key.data(), key.size());
+	return std::make_shared<MTP::AuthKey>(key);
+}
+
+void RemoveThrowawayData(const std::vector<QString> &paths) {
+	for (const auto &path : paths) {
+		QDir(path).removeRecursively();
+	}
+}
+
+} // namespace
+
+UpdatesRecorder::UpdatesRecorder(const QString &path, UserId self)
+: _file(path) {
+	if (!_file.open(QIODevice::WriteOnly)) {
+		LOG(("Updates Recorder Error: Could not open '%1'.").arg(path));
+		return;
+	}
+	auto stream = QDataStream(&_file);
+	stream << kRecordMagic << kRecordVersion << quint64(self.bare);
+}
+
+bool UpdatesRecorder::valid() const {
+	return _file.isOpen();
+}
+
+QString UpdatesRecorder::path() const {
+	return _file.fileName();
+}
+
+int UpdatesRecorder::count() const {
+	return _count;
+}
+
+void UpdatesRecorder::write(const MTPUpdates &updates) {
+	writeRecord(qint32(RecordKind::Updates), Serialize(updates));
+}
+
+void UpdatesRecorder::write(const MTPupdates_Difference &difference) {
+	writeRecord(qint32(RecordKind::Difference), Serialize(difference));
+}
+
+void UpdatesRecorder::write(const MTPupdates_ChannelDifference &difference) {
+	writeRecord(
+		qint32(RecordKind::ChannelDifference),
+		Serialize(difference));
+}
+
+void UpdatesRecorder::writeRecord(qint32 kind, const mtpBuffer &buffer) {
+	if (!valid()) {
+		return;
+	}
+	auto stream = QDataStream(&_file);
+	stream << kind << qint32(buffer.size());
+	stream.writeRawData(
+		reinterpret_cast<const char*>(buffer.constData()),
+		buffer.size() * sizeof(mtpPrime));
+	++_count;
+}
+
+UpdatesRecording ReadRecordedUpdates(const QString &path) {
+	auto file = QFile(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		LOG(("Updates Replay Error: Could not open '%1'.").arg(path));
+		return {};
+	}
+	auto stream = QDataStream(&file);
+	auto magic = quint32();
+	auto version = qint32();
+	auto self = quint64();
+	stream >> magic >> version >> self;
+	if (magic != kRecordMagic || version != kRecordVersion || !self) {
+		LOG(("Updates Replay Error: Bad header in '%1'.").arg(path));
+		return {};
+	}
+	auto result = UpdatesRecording{ .self = UserId(self) };
+	auto buffer = mtpBuffer();
+	while (!stream.atEnd()) {
+		auto kind = qint32();
+		auto size = qint32();
+		stream >> kind >> size;
+		if (stream.status() != QDataStream::Ok
+			|| size <= 0
+			|| size > kMaxRecordPrimes) {
+			LOG(("Updates Replay Error: Bad record size %1.").arg(size));
+			break;
+		}
+		buffer.resize(size);
+		const auto bytes = int(size * sizeof(mtpPrime));
+		if (stream.readRawData(
+				reinterpret_cast<char*>(buffer.data()),
+				bytes) != bytes) {
+			LOG(("Updates Replay Error: Unexpected end of file."));
+			break;
+		}
+		auto parsed = [&]() -> std::optional<RecordedUpdate> {
+			switch (RecordKind(kind)) {
+			case RecordKind::Updates:
+				return Parse<MTPUpdates>(buffer);
+			case RecordKind::Difference:
+				return Parse<MTPupdates_Difference>(buffer);
+			case RecordKind::ChannelDifference:
+				return Parse<MTPupdates_ChannelDifference>(buffer);
+			}
+			return std::nullopt;
+		}();
+		if (!parsed) {
+			LOG(("Updates Replay Error: Could not parse a record."));
+			break;
+		}
+		result.list.push_back(std::move(*parsed));
+	}
+	return result;
+}
+
+void UpdatesReplayStats::add(const MTPUpdate &update, int64 time) {
+	addEntry(update.type(), [&] { return NameFromDump(update); }, time);
+}
+
+void UpdatesReplayStats::add(const MTPUpdates &updates, int64 time) {
+	addEntry(updates.type(), [&] { return NameFromDump(updates); }, time);
+}
+
+void UpdatesReplayStats::add(
+		const MTPupdates_Difference &difference,
+		int64 time) {
+	addEntry(difference.type(), [&] {
+		return NameFromDump(difference);
+	}, time);
+}
+
+void UpdatesReplayStats::add(
+		const MTPupdates_ChannelDifference &difference,
+		int64 time) {
+	addEntry(difference.type(), [&] {
+		return NameFromDump(difference);
+	}, time);
+}
+
+void UpdatesReplayStats::addEntry(
+		mtpTypeId type,
+		Fn<QString()> name,
+		int64 time) {
+	auto i = _types.find(type);
+	if (i == end(_types)) {
+		auto entry = Entry{ .name = name() };
+		if (entry.name.isEmpty()) {
+			entry.name = u"0x"_q + QString::number(uint32(type), 16);
+		}
+		i = _types.emplace(type, std::move(entry)).first;
+	}
+	auto &entry = i->second;
+	++entry.count;
+	entry.total += time;
+	entry.max = std::max(entry.max, time);
+	_total += time;
+	++_count;
+}
+
+QString UpdatesReplayStats::report() const {
+	auto sorted = std::vector<Entry>();
+	sorted.reserve(_types.size());
+	for (const auto &[type, entry] : _types) {
+		sorted.push_back(entry);
+	}
+	ranges::sort(sorted, ranges::greater(), &Entry::total);
+
+	auto result = QStringList();
+	result.push_back(u"Replayed %1 updates in %2 ms."_q
+		.arg(_count)
+		.arg(_total / 1000.));
+	for (const auto &entry : sorted) {
+		result.push_back(u"%1: %2 x, total %3 ms, avg %4 us, max %5 us"_q
+			.arg(entry.name)
+			.arg(entry.count)
+			.arg(entry.total / 1000.)
+			.arg(entry.total / std::max(entry.count, 1))
+			.arg(entry.max));
+	}
+	return result.join('\n');
+}
+
+int64 ReplayTimestamp() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+QString ReplayInThrowawaySession(const QString &path) {
+	const auto recording = ReadRecordedUpdates(path);
+	if (!recording.self) {
+		return u"Could not read recorded updates from '%1'."_q.arg(path);
+	}
+
+	// Not added to Main::Domain, so it has no window, isn't saved in
+	// the accounts list and can't become active.
+	auto account = std::make_unique<Main::Account>(
+		&Core::App().domain(),
+		u"updates_replay"_q,
+		0);
+
+	// The media cache is encrypted with the random local key and
+	// is cleared on the next open with a different key.
+	const auto paths = std::vector<QString>{
+		account->local().basePath(),
+		account->local().tempDirectory(),
+	};
+	RemoveThrowawayData(paths);
+
+	account->setMtpMainDcId(kThrowawayDcId);
+	account->prepareToStartAdded(ThrowawayLocalKey());
+	account->start(ThrowawayConfig());
+	account->setSessionUserId(recording.self);
+	account->createSession(
+		recording.self,
+		QByteArray(),
+		0,
+		std::make_unique<Main::SessionSettings>());
+
+	const auto result = account->session().updates().replayRecorded(
+		recording);
+
+	account = nullptr;
+	RemoveThrowawayData(paths);
+	return result;
+}
+
+} // namespace Api
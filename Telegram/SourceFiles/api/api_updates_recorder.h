@@ -0,0 +1,77 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Api {
+
+using RecordedUpdate = std::variant<
+	MTPUpdates,
+	MTPupdates_Difference,
+	MTPupdates_ChannelDifference>;
+
+struct UpdatesRecording {
+	UserId self = 0;
+	std::vector<RecordedUpdate> list;
+};
+
+// Writes received updates and differences in their TL serialization.
+class UpdatesRecorder final {
+public:
+	UpdatesRecorder(const QString &path, UserId self);
+
+	[[nodiscard]] bool valid() const;
+	[[nodiscard]] QString path() const;
+	[[nodiscard]] int count() const;
+
+	void write(const MTPUpdates &updates);
+	void write(const MTPupdates_Difference &difference);
+	void write(const MTPupdates_ChannelDifference &difference);
+
+private:
+	void writeRecord(qint32 kind, const mtpBuffer &buffer);
+
+	QFile _file;
+	int _count = 0;
+
+};
+
+[[nodiscard]] UpdatesRecording ReadRecordedUpdates(const QString &path);
+
+class UpdatesReplayStats final {
+public:
+	// Time in microseconds.
+	void add(const MTPUpdate &update, int64 time);
+	void add(const MTPUpdates &updates, int64 time);
+	void add(const MTPupdates_Difference &difference, int64 time);
+	void add(const MTPupdates_ChannelDifference &difference, int64 time);
+
+	[[nodiscard]] QString report() const;
+
+private:
+	struct Entry {
+		QString name;
+		int count = 0;
+		int64 total = 0;
+		int64 max = 0;
+	};
+	void addEntry(mtpTypeId type, Fn<QString()> name, int64 time);
+
+	base::flat_map<mtpTypeId, Entry> _types;
+	int64 _total = 0;
+	int _count = 0;
+
+};
+
+[[nodiscard]] int64 ReplayTimestamp();
+
+// Replays a recording into a throwaway test mode session. It has no
+// reachable DC and its local data is removed afterwards, so none of
+// the real accounts is touched.
+[[nodiscard]] QString ReplayInThrowawaySession(const QString &path);
+
+} // namespace Api
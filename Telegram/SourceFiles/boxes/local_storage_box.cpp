@@ -26,6 +26,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "styles/style_layers.h"
 #include "styles/style_boxes.h"
 
+#include <QtCore/QDirIterator>
+
 namespace {
 
 constexpr auto kMegabyte = int64(1024 * 1024);
@@ -36,6 +38,16 @@ constexpr auto kTimeLimitsCount = 16;
 constexpr auto kMaxTimeLimitValue = std::numeric_limits<size_type>::max();
 constexpr auto kFakeMediaCacheTag = uint16(0xFFFF);
 
+[[nodiscard]] int64 DirectorySize(const QString &path) {
+	auto result = int64();
+	auto i = QDirIterator(path, QDir::Files, QDirIterator::Subdirectories);
+	while (i.hasNext()) {
+		i.next();
+		result += i.fileInfo().size();
+	}
+	return result;
+}
+
 int64 TotalSizeLimitInMB(int index) {
 	if (index < 8) {
 		return int64(index + 2) * 100;
@@ -130,6 +142,7 @@ public:
 		const Database::TaggedSummary &data);
 
 	void update(const Database::TaggedSummary &data);
+	void setDiskSize(int64 size);
 	void toggleProgress(bool shown);
 
 	rpl::producer<> clearRequests() const;
@@ -144,6 +157,8 @@ private:
 	void radialAnimationCallback();
 
 	Fn<QString(size_type)> _titleFactory;
+	Database::TaggedSummary _data;
+	int64 _diskSize = 0;
 	object_ptr<Ui::FlatLabel> _title;
 	object_ptr<Ui::FlatLabel> _description;
 	object_ptr<Ui::FlatLabel> _clearing = { nullptr };
@@ -159,6 +174,7 @@ LocalStorageBox::Row::Row(
 	const Database::TaggedSummary &data)
 : RpWidget(parent)
 , _titleFactory(std::move(title))
+, _data(data)
 , _title(
 	this,
 	titleText(data),
@@ -173,6 +189,7 @@ LocalStorageBox::Row::Row(
 }
 
 void LocalStorageBox::Row::update(const Database::TaggedSummary &data) {
+	_data = data;
 	if (data.count != 0) {
 		_title->setText(titleText(data));
 	}
@@ -180,6 +197,11 @@ void LocalStorageBox::Row::update(const Database::TaggedSummary &data) {
 	_clear->setVisible(data.count != 0);
 }
 
+void LocalStorageBox::Row::setDiskSize(int64 size) {
+	_diskSize = size;
+	_description->setText(sizeText(_data));
+}
+
 void LocalStorageBox::Row::toggleProgress(bool shown) {
 	if (!shown) {
 		_progress = nullptr;
@@ -261,9 +283,18 @@ QString LocalStorageBox::Row::titleText(const Database::TaggedSummary &data) con
 }
 
 QString LocalStorageBox::Row::sizeText(const Database::TaggedSummary &data) const {
-	return data.totalSize
-		? Ui::FormatSizeText(data.totalSize)
-		: tr::lng_local_storage_empty(tr::now);
+	if (!data.totalSize) {
+		return tr::lng_local_storage_empty(tr::now);
+	} else if (!_diskSize) {
+		return Ui::FormatSizeText(data.totalSize);
+	}
+	// Binlogs also keep removed and rewritten entries until compacted.
+	return tr::lng_local_storage_on_disk(
+		tr::now,
+		lt_size,
+		Ui::FormatSizeText(data.totalSize),
+		lt_disk,
+		Ui::FormatSizeText(_diskSize));
 }
 
 LocalStorageBox::LocalStorageBox(
@@ -303,6 +334,25 @@ void LocalStorageBox::prepare() {
 	addButton(tr::lng_box_ok(), [this] { closeBox(); });
 
 	setupControls();
+	measureDiskSize();
+}
+
+void LocalStorageBox::measureDiskSize() {
+	const auto path = _session->local().cachePath();
+	const auto pathBig = _session->local().cacheBigFilePath();
+	crl::async([=, weak = Ui::MakeWeak(this)] {
+		const auto size = DirectorySize(path);
+		const auto sizeBig = DirectorySize(pathBig);
+		crl::on_main(weak, [=] {
+			if (const auto i = _rows.find(0); i != end(_rows)) {
+				i->second->entity()->setDiskSize(size + sizeBig);
+			}
+			const auto media = _rows.find(kFakeMediaCacheTag);
+			if (media != end(_rows)) {
+				media->second->entity()->setDiskSize(sizeBig);
+			}
+		});
+	});
 }
 
 void LocalStorageBox::updateRow(
@@ -319,11 +369,15 @@ void LocalStorageBox::updateRow(
 void LocalStorageBox::update(
 		Database::Stats &&stats,
 		Database::Stats &&statsBig) {
+	const auto wasClearing = _stats.clearing || _statsBig.clearing;
 	_stats = std::move(stats);
 	_statsBig = std::move(statsBig);
+	const auto clearing = _stats.clearing || _statsBig.clearing;
 	if (const auto i = _rows.find(0); i != end(_rows)) {
-		i->second->entity()->toggleProgress(
-			_stats.clearing || _statsBig.clearing);
+		i->second->entity()->toggleProgress(clearing);
+	}
+	if (wasClearing && !clearing) {
+		measureDiskSize();
 	}
 	for (const auto &entry : _rows) {
 		if (entry.first == kFakeMediaCacheTag) {
@@ -49,6 +49,7 @@ private:
 	class Row;
 
 	void clearByTag(uint16 tag);
+	void measureDiskSize();
 	void update(Database::Stats &&stats, Database::Stats &&statsBig);
 	void updateRow(
 		not_null<Ui::SlideWrap<Row>*> row,
@@ -287,7 +287,7 @@ std::unique_ptr<Lottie::SinglePlayer> EmojiPack::effectPlayer(
 	const auto weak = base::make_weak(&document->session());
 	const auto put = [=](int i, QByteArray &&cached) {
 		crl::on_main(weak, [=, data = std::move(cached)]() mutable {
-			weak->data().cacheBigFile().put(
+			weak->data().cacheBigFilePut(
 				{ key.high, key.low + i },
 				std::move(data));
 		});
@@ -64,6 +64,7 @@ constexpr auto kPreloadOfficialPages = 4;
 constexpr auto kOfficialLoadLimit = 40;
 constexpr auto kMinRepaintDelay = crl::time(33);
 constexpr auto kMinAfterScrollDelay = crl::time(33);
+constexpr auto kStartAnimationsDelay = crl::time(150);
 
 using Data::StickersSet;
 using Data::StickersPack;
@@ -193,6 +194,7 @@ StickersListWidget::StickersListWidget(
 , _isMasks(_mode == Mode::Masks)
 , _updateItemsTimer([=] { updateItems(); })
 , _updateSetsTimer([=] { updateSets(); })
+, _startAnimationsTimer([=] { update(); })
 , _trendingAddBgOver(
 	ImageRoundRadius::Large,
 	st::stickersTrendingAdd.textBgOver)
@@ -332,6 +334,7 @@ void StickersListWidget::visibleTopBottomUpdated(
 	if (top != getVisibleTop()) {
 		_lastScrolledAt = crl::now();
 		_repaintSetsIds.clear();
+		delayAnimationsStart();
 		update();
 	}
 	if (_section == Section::Featured) {
@@ -1067,6 +1070,26 @@ void StickersListWidget::checkVisibleLottie() {
 	});
 }
 
+void StickersListWidget::showEvent(QShowEvent *e) {
+	delayAnimationsStart();
+	Inner::showEvent(e);
+}
+
+void StickersListWidget::delayAnimationsStart() {
+	// Paint from the posters while scrolling or right after showing,
+	// set up animations only for the stickers that stay visible.
+	_animationsStartAt = crl::now() + kStartAnimationsDelay;
+}
+
+bool StickersListWidget::canStartAnimations(crl::time now) {
+	if (now >= _animationsStartAt) {
+		return true;
+	} else if (!_startAnimationsTimer.isActive()) {
+		_startAnimationsTimer.callOnce(_animationsStartAt - now);
+	}
+	return false;
+}
+
 void StickersListWidget::clearHeavyIn(Set &set, bool clearSavedFrames) {
 	const auto player = base::take(set.lottiePlayer);
 	const auto lifetime = base::take(set.lottieLifetime);
@@ -1360,11 +1383,23 @@ void StickersListWidget::paintSticker(
 	const auto isWebm = document->sticker()->isWebm();
 	if (isLottie
 		&& !sticker.lottie
-		&& media->loaded()) {
+		&& media->loaded()
+		&& canStartAnimations(now)) {
 		setupLottie(set, section, index);
-	} else if (isWebm && !sticker.webm && media->loaded()) {
+	} else if (isWebm
+		&& !sticker.webm
+		&& media->loaded()
+		&& canStartAnimations(now)) {
 		setupWebm(set, section, index);
 	}
+	const auto posterBox = boundingBoxSize() * style::DevicePixelRatio();
+	const auto rememberPoster = [&] {
+		RememberStickerPoster(
+			document,
+			StickerLottieSize::StickersPanel,
+			posterBox,
+			sticker.savedFrame);
+	};
 
 	int row = (index / _columnCount), col = (index % _columnCount);
 
@@ -1394,6 +1429,7 @@ void StickersListWidget::paintSticker(
 			sticker.savedFrame = lottieFrame;
 			sticker.savedFrame.setDevicePixelRatio(style::DevicePixelRatio());
 			sticker.savedFrameFor = _singleSize;
+			rememberPoster();
 		}
 		set.lottiePlayer->unpause(sticker.lottie);
 	} else if (sticker.webm && sticker.webm->started()) {
@@ -1404,10 +1440,24 @@ void StickersListWidget::paintSticker(
 			sticker.savedFrame = frame;
 			sticker.savedFrame.setDevicePixelRatio(style::DevicePixelRatio());
 			sticker.savedFrameFor = _singleSize;
+			rememberPoster();
 		}
 		p.drawImage(ppos, frame);
 	} else {
 		const auto image = media->getStickerSmall();
+		if ((isLottie || isWebm)
+			&& (sticker.savedFrame.isNull()
+				|| sticker.savedFrameFor != _singleSize)) {
+			auto poster = StickerPoster(
+				document,
+				StickerLottieSize::StickersPanel,
+				posterBox,
+				crl::guard(this, [=] { update(); }));
+			if (!poster.isNull()) {
+				sticker.savedFrame = std::move(poster);
+				sticker.savedFrameFor = _singleSize;
+			}
+		}
 		const auto useSavedFrame = !sticker.savedFrame.isNull()
 			&& (sticker.savedFrameFor == _singleSize);
 		if (useSavedFrame) {
@@ -131,6 +131,7 @@ protected:
 	void mouseMoveEvent(QMouseEvent *e) override;
 	void resizeEvent(QResizeEvent *e) override;
 	void paintEvent(QPaintEvent *e) override;
+	void showEvent(QShowEvent *e) override;
 	void leaveEventHook(QEvent *e) override;
 	void leaveToChildEvent(QEvent *e, QWidget *child) override;
 	void enterFromChildEvent(QEvent *e, QWidget *child) override;
@@ -290,6 +291,8 @@ private:
 	void takeHeavyData(Set &to, Set &from);
 	void takeHeavyData(Sticker &to, Sticker &from);
 	void clearHeavyIn(Set &set, bool clearSavedFrames = true);
+	void delayAnimationsStart();
+	[[nodiscard]] bool canStartAnimations(crl::time now);
 	void clearHeavyData();
 	void updateItems();
 	void updateSets();
@@ -373,6 +376,8 @@ private:
 
 	bool _showingSetById = false;
 	crl::time _lastScrolledAt = 0;
+	crl::time _animationsStartAt = 0;
+	base::Timer _startAnimationsTimer;
 	crl::time _lastFullUpdatedAt = 0;
 
 	mtpRequestId _officialRequestId = 0;
@@ -21,10 +21,102 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/painter.h"
 #include "main/main_session.h"
 
+#include <QtCore/QBuffer>
+#include <crl/crl_async.h>
+
 namespace ChatHelpers {
 namespace {
 
 constexpr auto kDontCacheLottieAfterArea = 512 * 512;
+constexpr auto kPosterKeyShift = 0x200;
+constexpr auto kPostersMemoryLimit = 24 * 1024 * 1024;
+
+struct PosterKey {
+	DocumentId id = 0;
+	int width = 0;
+	int height = 0;
+	StickerLottieSize sizeTag = StickerLottieSize();
+
+	friend inline auto operator<=>(PosterKey, PosterKey) = default;
+	friend inline bool operator==(PosterKey, PosterKey) = default;
+};
+
+struct Poster {
+	QImage image;
+	uint64 lastUsed = 0;
+};
+
+struct Posters {
+	base::flat_map<PosterKey, Poster> images;
+	base::flat_set<PosterKey> requested;
+	int64 bytes = 0;
+	uint64 counter = 0;
+};
+
+[[nodiscard]] Posters &PostersCache() {
+	static auto result = Posters();
+	return result;
+}
+
+[[nodiscard]] Storage::Cache::Key PosterCacheKey(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag) {
+	const auto baseKey = document->bigFileBaseCacheKey();
+	return baseKey
+		? Storage::Cache::Key{
+			baseKey.high,
+			baseKey.low + kPosterKeyShift + uint8(sizeTag),
+		}
+		: Storage::Cache::Key();
+}
+
+void StorePoster(PosterKey key, QImage image) {
+	auto &cache = PostersCache();
+	const auto bytes = image.sizeInBytes();
+	auto &poster = cache.images[key];
+	cache.bytes += bytes - poster.image.sizeInBytes();
+	poster = { std::move(image), ++cache.counter };
+	while (cache.bytes > kPostersMemoryLimit && cache.images.size() > 1) {
+		const auto oldest = ranges::min_element(
+			cache.images,
+			ranges::less(),
+			[](const auto &pair) { return pair.second.lastUsed; });
+		cache.bytes -= oldest->second.image.sizeInBytes();
+		cache.requested.remove(oldest->first);
+		cache.images.erase(oldest);
+	}
+}
+
+[[nodiscard]] QByteArray SerializePoster(QSize box, const QImage &frame) {
+	auto png = QByteArray();
+	auto buffer = QBuffer(&png);
+	if (!frame.save(&buffer, "PNG")) {
+		return QByteArray();
+	}
+	auto result = QByteArray();
+	auto stream = QDataStream(&result, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream << qint32(box.width()) << qint32(box.height()) << png;
+	return result;
+}
+
+[[nodiscard]] QImage DeserializePoster(
+		QSize box,
+		const QByteArray &serialized) {
+	auto stream = QDataStream(serialized);
+	stream.setVersion(QDataStream::Qt_5_1);
+	auto width = qint32(), height = qint32();
+	auto png = QByteArray();
+	stream >> width >> height >> png;
+	if (stream.status() != QDataStream::Ok
+		|| QSize(width, height) != box) {
+		return QImage();
+	}
+	auto result = QImage::fromData(png, "PNG");
+	return result.isNull()
+		? QImage()
+		: result.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
 
 } // namespace
 
@@ -52,7 +144,7 @@ auto LottieCachedFromContent(
 	const auto weak = base::make_weak(session);
 	const auto put = [=](QByteArray &&cached) {
 		crl::on_main(weak, [=, data = std::move(cached)]() mutable {
-			weak->data().cacheBigFile().put(key, std::move(data));
+			weak->data().cacheBigFilePut(key, std::move(data));
 		});
 	};
 	return method(
@@ -312,4 +404,81 @@ QSize ComputeStickerSize(not_null<DocumentData*> document, QSize box) {
 	return HistoryView::NonEmptySize(request.size(dimensions, 8) / ratio);
 }
 
+QImage StickerPoster(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag,
+		QSize box,
+		Fn<void()> loaded) {
+	const auto key = PosterKey{
+		document->id,
+		box.width(),
+		box.height(),
+		sizeTag,
+	};
+	auto &cache = PostersCache();
+	const auto i = cache.images.find(key);
+	if (i != end(cache.images)) {
+		i->second.lastUsed = ++cache.counter;
+		return i->second.image;
+	}
+	const auto cacheKey = PosterCacheKey(document, sizeTag);
+	if (!cacheKey || !cache.requested.emplace(key).second) {
+		return QImage();
+	}
+	const auto weak = base::make_weak(&document->session());
+	document->owner().cacheBigFile().get(cacheKey, [=](
+			QByteArray &&serialized) {
+		auto image = serialized.isEmpty()
+			? QImage()
+			: DeserializePoster(box, serialized);
+		crl::on_main([=, image = std::move(image)]() mutable {
+			// Allow reading it again if it is not there or gets evicted.
+			PostersCache().requested.remove(key);
+			if (image.isNull() || !weak) {
+				return;
+			}
+			image.setDevicePixelRatio(style::DevicePixelRatio());
+			StorePoster(key, std::move(image));
+			if (loaded) {
+				loaded();
+			}
+		});
+	});
+	return QImage();
+}
+
+void RememberStickerPoster(
+		not_null<DocumentData*> document,
+		StickerLottieSize sizeTag,
+		QSize box,
+		const QImage &frame) {
+	const auto key = PosterKey{
+		document->id,
+		box.width(),
+		box.height(),
+		sizeTag,
+	};
+	auto &cache = PostersCache();
+	if (frame.isNull() || cache.images.contains(key)) {
+		return;
+	}
+	StorePoster(key, frame);
+
+	const auto cacheKey = PosterCacheKey(document, sizeTag);
+	if (!cacheKey) {
+		return;
+	}
+	cache.requested.emplace(key);
+	const auto weak = base::make_weak(&document->session());
+	crl::async([=] {
+		auto serialized = SerializePoster(box, frame);
+		if (serialized.isEmpty()) {
+			return;
+		}
+		crl::on_main(weak, [=, data = std::move(serialized)]() mutable {
+			weak->data().cacheBigFilePut(cacheKey, std::move(data));
+		});
+	});
+}
+
 } // namespace ChatHelpers
@@ -130,4 +130,19 @@ bool PaintStickerThumbnailPath(
 	not_null<DocumentData*> document,
 	QSize box);
 
+// First frames of animated stickers, kept in memory and in the local cache,
+// so that a panel is painted at once while its animations are set up.
+// If the poster is not in memory it is looked up in the cache and
+// 'loaded' is called if it was found there.
+[[nodiscard]] QImage StickerPoster(
+	not_null<DocumentData*> document,
+	StickerLottieSize sizeTag,
+	QSize box,
+	Fn<void()> loaded);
+void RememberStickerPoster(
+	not_null<DocumentData*> document,
+	StickerLottieSize sizeTag,
+	QSize box,
+	const QImage &frame);
+
 } // namespace ChatHelpers
@@ -0,0 +1,216 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/core_trace.h"
+
+#include "base/options.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <chrono>
+
+namespace Core::Trace {
+namespace {
+
+constexpr auto kEventsCount = uint64(1 << 15); // Must be a power of two.
+constexpr auto kStallThreshold = int64(300'000); // 300 ms.
+constexpr auto kStallDumpDelay = crl::time(60'000);
+
+base::options::toggle OptionTraceMainThreadStalls({
+	.id = kOptionTraceMainThreadStalls,
+	.name = "Trace main thread stalls",
+	.description = "Record hot paths to a ring buffer and dump a "
+		"Chrome trace to DebugLogs/ when the main thread stalls.",
+});
+
+struct Event {
+	const char *name = nullptr;
+	int64 start = 0;
+	int64 duration = 0;
+	int thread = 0;
+};
+
+// Slots are written from any thread and read from the main thread, so
+// each one is guarded by a sequence number: odd while it is written,
+// 2 * (index + 1) after the event with that index was stored.
+struct Slot {
+	std::atomic<uint64> sequence = 0;
+	std::atomic<const char*> name = nullptr;
+	std::atomic<int64> start = 0;
+	std::atomic<int64> duration = 0;
+	std::atomic<int> thread = 0;
+};
+
+struct Events {
+	std::vector<Slot> list = std::vector<Slot>(kEventsCount);
+	std::atomic<uint64> written = 0;
+	std::atomic<crl::time> lastStallDump = 0;
+};
+
+std::atomic<int> ThreadCounter/* = 0*/;
+thread_local int Depth/* = 0*/;
+
+[[nodiscard]] Events &AllEvents() {
+	static auto result = Events();
+	return result;
+}
+
+[[nodiscard]] int ThreadIndex() {
+	static thread_local const auto result = ThreadCounter++;
+	return result;
+}
+
+[[nodiscard]] int64 Now() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+void Record(const char *name, int64 start, int64 duration) {
+	auto &events = AllEvents();
+	const auto index = events.written.fetch_add(1);
+	auto &slot = events.list[index & (kEventsCount - 1)];
+	slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(duration, std::memory_order_relaxed);
+	slot.thread.store(ThreadIndex(), std::memory_order_relaxed);
+	slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+// Skips the events that are being overwritten while they are copied.
+[[nodiscard]] std::vector<Event> Snapshot() {
+	auto &events = AllEvents();
+	const auto written = events.written.load();
+	const auto count = std::min(written, kEventsCount);
+
+	auto result = std::vector<Event>();
+	result.reserve(count);
+	for (auto i = written - count; i != written; ++i) {
+		const auto &slot = events.list[i & (kEventsCount - 1)];
+		const auto sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != 2 * (i + 1)) {
+			continue;
+		}
+		auto event = Event{
+			.name = slot.name.load(std::memory_order_relaxed),
+			.start = slot.start.load(std::memory_order_relaxed),
+			.duration = slot.duration.load(std::memory_order_relaxed),
+			.thread = slot.thread.load(std::memory_order_relaxed),
+		};
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == sequence
+			&& event.name) {
+			result.push_back(event);
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] QByteArray Serialize(const std::vector<Event> &events) {
+	auto list = QJsonArray();
+	for (const auto &event : events) {
+		list.push_back(QJsonObject{
+			{ "name", QString::fromLatin1(event.name) },
+			{ "ph", "X" },
+			{ "ts", double(event.start) },
+			{ "dur", double(event.duration) },
+			{ "pid", 1 },
+			{ "tid", event.thread },
+		});
+	}
+	return QJsonDocument(QJsonObject{
+		{ "traceEvents", list },
+		{ "displayTimeUnit", "ms" },
+	}).toJson(QJsonDocument::Compact);
+}
+
+[[nodiscard]] bool IsMainThread() {
+	const auto app = QCoreApplication::instance();
+	return app && (QThread::currentThread() == app->thread());
+}
+
+[[nodiscard]] QString GenerateDumpPath() {
+	return cWorkingDir()
+		+ u"DebugLogs/trace_%1.json"_q.arg(
+			QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+}
+
+bool WriteDump(const QString &path, const QByteArray &content) {
+	if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+		return false;
+	}
+	auto f = QFile(path);
+	if (!f.open(QIODevice::WriteOnly)) {
+		LOG(("Trace: Could not open '%1' for writing.").arg(path));
+		return false;
+	}
+	f.write(content);
+	return true;
+}
+
+void StallDetected(const char *name, int64 duration) {
+	auto &events = AllEvents();
+	const auto now = crl::now();
+	auto was = events.lastStallDump.load();
+	if (was && now - was < kStallDumpDelay) {
+		return;
+	} else if (!events.lastStallDump.compare_exchange_strong(was, now)) {
+		return;
+	}
+	LOG(("Trace: Main thread stall in %1 for %2 ms."
+		).arg(name
+		).arg(duration / 1000));
+
+	// Only copy the ring on the main thread, serialize it in background.
+	crl::async([path = GenerateDumpPath(), events = Snapshot()] {
+		if (WriteDump(path, Serialize(events))) {
+			LOG(("Trace: Written to '%1'.").arg(path));
+		}
+	});
+}
+
+} // namespace
+
+const char kOptionTraceMainThreadStalls[] = "trace-main-thread-stalls";
+
+bool Enabled() {
+	return OptionTraceMainThreadStalls.value();
+}
+
+Scope::Scope(const char *name) {
+	if (Enabled()) {
+		_name = name;
+		_start = Now();
+		++Depth;
+	}
+}
+
+Scope::~Scope() {
+	if (!_name) {
+		return;
+	}
+	const auto duration = Now() - _start;
+	Record(_name, _start, duration);
+	if (!--Depth && duration >= kStallThreshold && IsMainThread()) {
+		StallDetected(_name, duration);
+	}
+}
+
+QByteArray SerializeChromeTrace() {
+	return Serialize(Snapshot());
+}
+
+QString Dump() {
+	const auto path = GenerateDumpPath();
+	return WriteDump(path, SerializeChromeTrace()) ? path : QString();
+}
+
+} // namespace Core::Trace
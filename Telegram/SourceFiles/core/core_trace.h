@@ -0,0 +1,37 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Core::Trace {
+
+extern const char kOptionTraceMainThreadStalls[];
+
+[[nodiscard]] bool Enabled();
+
+// Records a complete event in a ring buffer while tracing is enabled.
+// The name must be a string literal, it is stored as a pointer.
+class Scope final {
+public:
+	explicit Scope(const char *name);
+	Scope(const Scope &other) = delete;
+	Scope &operator=(const Scope &other) = delete;
+	~Scope();
+
+private:
+	const char *_name = nullptr;
+	int64 _start = 0;
+
+};
+
+// Chrome trace event format, can be opened in chrome://tracing.
+[[nodiscard]] QByteArray SerializeChromeTrace();
+
+// Writes the trace to DebugLogs/ and returns the file path.
+QString Dump();
+
+} // namespace Core::Trace
@@ -249,6 +249,7 @@ void SignalHandler(int signum, siginfo_t *info, void *ucontext) {
 	const auto thread = QThread::currentThreadId();
 
 	if (ReportingThreadId.compare_exchange_strong(expected, thread)) {
+		Logs::writePendingOnCrash();
 		WriteReportInfo(signum, name);
 		ReportingThreadId = nullptr;
 	}
@@ -501,7 +501,7 @@ void DocumentData::setDataAndCache(const QByteArray &data) {
 		media->setBytes(data);
 	}
 	if (saveToCache() && data.size() <= Storage::kMaxFileInMemory) {
-		owner().cache().put(
+		owner().cachePut(
 			cacheKey(),
 			Storage::Cache::Database::TaggedValue(
 				base::duplicate(data),
@@ -455,7 +455,7 @@ void DocumentMedia::GenerateGoodThumbnail(
 			if (const auto active = document->activeMediaView()) {
 				active->setGoodThumbnail(result);
 			}
-			document->owner().cache().put(
+			document->owner().cachePut(
 				document->goodThumbnailCacheKey(),
 				Storage::Cache::Database::TaggedValue{
 					base::duplicate(cache),
@@ -337,12 +337,20 @@ void PeerData::paintUserpic(
 		int size) const {
 	const auto cloud = userpicCloudImage(view);
 	const auto ratio = style::DevicePixelRatio();
-	Ui::ValidateUserpicCache(
-		view,
-		cloud,
-		cloud ? nullptr : ensureEmptyUserpic().get(),
-		size * ratio,
-		isForum());
+	const auto empty = cloud ? nullptr : ensureEmptyUserpic().get();
+
+	// Frames painted off screen are kept, they can't show a draft.
+	const auto device = p.device();
+	if (device && device->devType() == QInternal::Widget) {
+		Ui::ValidateUserpicCacheDraft(
+			view,
+			cloud,
+			empty,
+			size * ratio,
+			isForum());
+	} else {
+		Ui::ValidateUserpicCache(view, cloud, empty, size * ratio, isForum());
+	}
 	p.drawImage(QRect(x, y, size, size), view.cached);
 }
 
@@ -382,24 +390,19 @@ QImage PeerData::generateUserpicImage(
 		int size,
 		std::optional<int> radius) const {
 	if (const auto userpic = userpicCloudImage(view)) {
+		if (!radius) {
+			return Ui::SharedUserpicImage(*userpic, size, isForum());
+		}
 		auto image = userpic->scaled(
 			{ size, size },
 			Qt::IgnoreAspectRatio,
 			Qt::SmoothTransformation);
-		const auto round = [&](int radius) {
-			return Images::Round(
-				std::move(image),
-				Images::CornersMask(radius / style::DevicePixelRatio()));
-		};
-		if (radius == 0) {
+		if (*radius == 0) {
 			return image;
-		} else if (radius) {
-			return round(*radius);
-		} else if (isForum()) {
-			return round(size * Ui::ForumUserpicRadiusMultiplier());
-		} else {
-			return Images::Circle(std::move(image));
 		}
+		return Images::Round(
+			std::move(image),
+			Images::CornersMask(*radius / style::DevicePixelRatio()));
 	}
 	auto result = QImage(
 		QSize(size, size),
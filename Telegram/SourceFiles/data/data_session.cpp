@@ -17,6 +17,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "api/api_user_names.h"
 #include "core/application.h"
 #include "core/core_settings.h"
+#include "core/core_trace.h"
 #include "core/mime_type.h" // Core::IsMimeSticker
 #include "ui/image/image_location_factory.h" // Images::FromPhotoSize
 #include "ui/text/format_values.h" // Ui::FormatPhone
@@ -30,6 +31,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_element.h"
 #include "inline_bots/inline_bot_layout_item.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_dedup.h"
 #include "storage/storage_encrypted_file.h"
 #include "media/player/media_player_instance.h" // instance()->play()
 #include "media/audio/media_audio.h"
@@ -241,6 +243,9 @@ Session::Session(not_null<Main::Session*> session)
 , _bigFileCache(Core::App().databases().get(
 	_session->local().cacheBigFilePath(),
 	_session->local().cacheBigFileSettings()))
+, _cacheDedup(std::make_unique<Storage::CacheDeduplicator>(u"Cache"_q))
+, _bigFileCacheDedup(
+	std::make_unique<Storage::CacheDeduplicator>(u"Big File Cache"_q))
 , _groupFreeTranscribeLevel(session->appConfig().value(
 ) | rpl::map([limits = Data::LevelLimits(session)] {
 	return limits.groupTranscribeLevelMin();
@@ -1350,6 +1355,19 @@ Storage::Cache::Database &Session::cacheBigFile() {
 	return *_bigFileCache;
 }
 
+void Session::cachePut(
+		Storage::Cache::Key key,
+		Storage::Cache::Database::TaggedValue &&value) {
+	_cacheDedup->put(*_cache, key, std::move(value));
+}
+
+void Session::cacheBigFilePut(Storage::Cache::Key key, QByteArray &&value) {
+	_bigFileCacheDedup->put(
+		*_bigFileCache,
+		key,
+		Storage::Cache::Database::TaggedValue(std::move(value), 0));
+}
+
 void Session::suggestStartExport(TimeId availableAt) {
 	_exportAvailableAt = availableAt;
 	suggestStartExport();
@@ -2331,6 +2349,7 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 void Session::processMessages(
 		const QVector<MTPMessage> &data,
 		NewMessageType type) {
+	const auto trace = Core::Trace::Scope("Data::Session::processMessages");
 	auto indices = base::flat_map<uint64, int>();
 	for (int i = 0, l = data.size(); i != l; ++i) {
 		const auto &message = data[i];
@@ -2664,6 +2683,7 @@ HistoryItem *Session::addNewMessage(
 		const MTPMessage &data,
 		MessageFlags localFlags,
 		NewMessageType type) {
+	const auto trace = Core::Trace::Scope("Data::Session::addNewMessage");
 	const auto peerId = PeerFromMessage(data);
 	if (!peerId) {
 		return nullptr;
@@ -43,6 +43,10 @@ namespace Iv {
 class Data;
 } // namespace Iv
 
+namespace Storage {
+class CacheDeduplicator;
+} // namespace Storage
+
 namespace Data {
 
 class Folder;
@@ -186,6 +190,12 @@ public:
 	[[nodiscard]] Storage::Cache::Database &cache();
 	[[nodiscard]] Storage::Cache::Database &cacheBigFile();
 
+	// Same as put(), but skips rewriting bytes already stored by key.
+	void cachePut(
+		Storage::Cache::Key key,
+		Storage::Cache::Database::TaggedValue &&value);
+	void cacheBigFilePut(Storage::Cache::Key key, QByteArray &&value);
+
 	[[nodiscard]] not_null<PeerData*> peer(PeerId id);
 	[[nodiscard]] not_null<PeerData*> peer(UserId id) = delete;
 	[[nodiscard]] not_null<UserData*> user(UserId id);
@@ -906,6 +916,8 @@ private:
 
 	Storage::DatabasePointer _cache;
 	Storage::DatabasePointer _bigFileCache;
+	const std::unique_ptr<Storage::CacheDeduplicator> _cacheDedup;
+	const std::unique_ptr<Storage::CacheDeduplicator> _bigFileCacheDedup;
 
 	TimeId _exportAvailableAt = 0;
 	QPointer<Ui::BoxContent> _exportSuggestion;
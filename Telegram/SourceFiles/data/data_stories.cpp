@@ -39,6 +39,10 @@ constexpr auto kSavedFirstPerPage = 30;
 constexpr auto kSavedPerPage = 100;
 constexpr auto kMaxPreloadSources = 10;
 constexpr auto kStillPreloadFromFirst = 3;
+constexpr auto kMaxPreloadingTogether = 4;
+
+// Each story preloaded in parallel should get at least that much.
+constexpr auto kPreloadBandwidthPerStory = int64(256 * 1024);
 constexpr auto kMaxSegmentsCount = 180;
 constexpr auto kPollingIntervalChat = 5 * TimeId(60);
 constexpr auto kPollingIntervalViewer = 1 * TimeId(60);
@@ -449,8 +453,7 @@ Story *Stories::parseAndApply(
 		}
 		if (mediaChanged) {
 			_preloaded.remove(fullId);
-			if (_preloading && _preloading->id() == fullId) {
-				_preloading = nullptr;
+			if (_preloading.remove(fullId)) {
 				rebuildPreloadSources(StorySourcesList::NotHidden);
 				rebuildPreloadSources(StorySourcesList::Hidden);
 				continuePreloading();
@@ -805,8 +808,7 @@ void Stories::applyDeleted(not_null<PeerData*> peer, StoryId id) {
 					}
 				}
 			}
-			if (_preloading && _preloading->id() == fullId) {
-				_preloading = nullptr;
+			if (_preloading.remove(fullId)) {
 				preloadFinished(fullId);
 			}
 			_owner->refreshStoryItemViews(fullId);
@@ -2066,40 +2068,52 @@ bool Stories::rebuildPreloadSources(StorySourcesList list) {
 }
 
 void Stories::continuePreloading() {
-	const auto now = _preloading ? _preloading->id() : FullStoryId();
-	if (now) {
-		if (shouldContinuePreload(now)) {
-			return;
+	for (auto i = begin(_preloading); i != end(_preloading);) {
+		if (shouldContinuePreload(i->first)) {
+			++i;
+		} else {
+			i = _preloading.erase(i);
 		}
-		_preloading = nullptr;
 	}
-	const auto id = nextPreloadId();
-	if (!id) {
-		return;
-	} else if (const auto maybeStory = lookup(id)) {
-		startPreloading(*maybeStory);
+	const auto depth = preloadDepth();
+	while (int(_preloading.size()) < depth) {
+		const auto id = nextPreloadId();
+		if (!id) {
+			return;
+		} else if (const auto maybeStory = lookup(id)) {
+			startPreloading(*maybeStory);
+		} else {
+			return;
+		}
 	}
 }
 
+int Stories::preloadDepth() const {
+	// Until the first measurement we preload one story at a time.
+	const auto count = _preloadBandwidth / kPreloadBandwidthPerStory;
+	return int(std::clamp(count, int64(1), int64(kMaxPreloadingTogether)));
+}
+
 bool Stories::shouldContinuePreload(FullStoryId id) const {
 	const auto first = ranges::views::concat(
 		_toPreloadViewer,
 		_toPreloadSources[static_cast<int>(StorySourcesList::Hidden)],
 		_toPreloadSources[static_cast<int>(StorySourcesList::NotHidden)]
-	) | ranges::views::take(kStillPreloadFromFirst);
+	) | ranges::views::take(kStillPreloadFromFirst + preloadDepth() - 1);
 	return ranges::contains(first, id);
 }
 
 FullStoryId Stories::nextPreloadId() const {
 	const auto hidden = static_cast<int>(StorySourcesList::Hidden);
 	const auto main = static_cast<int>(StorySourcesList::NotHidden);
-	const auto result = !_toPreloadViewer.empty()
-		? _toPreloadViewer.front()
-		: !_toPreloadSources[hidden].empty()
-		? _toPreloadSources[hidden].front()
-		: !_toPreloadSources[main].empty()
-		? _toPreloadSources[main].front()
-		: FullStoryId();
+	const auto all = ranges::views::concat(
+		_toPreloadViewer,
+		_toPreloadSources[hidden],
+		_toPreloadSources[main]);
+	const auto i = ranges::find_if(all, [&](FullStoryId id) {
+		return !_preloading.contains(id);
+	});
+	const auto result = (i != ranges::end(all)) ? *i : FullStoryId();
 
 	Ensures(!_preloaded.contains(result));
 	return result;
@@ -2110,12 +2124,29 @@ void Stories::startPreloading(not_null<Story*> story) {
 
 	const auto id = story->fullId();
 	auto preloading = std::make_unique<StoryPreload>(story, [=] {
-		_preloading = nullptr;
+		if (const auto i = _preloading.find(id); i != end(_preloading)) {
+			preloadMeasured(
+				i->second->loadedBytes(),
+				i->second->loadDuration());
+			_preloading.erase(i);
+		}
 		preloadFinished(id, true);
 	});
 	if (!_preloaded.contains(id)) {
-		_preloading = std::move(preloading);
+		_preloading.emplace(id, std::move(preloading));
+	}
+}
+
+void Stories::preloadMeasured(int64 bytes, crl::time duration) {
+	if (bytes <= 0 || duration <= 0) {
+		return;
 	}
+	// All preloads share the bandwidth, so count it for all of them.
+	const auto together = std::max(int(_preloading.size()), 1);
+	const auto bandwidth = bytes * together * 1000 / duration;
+	_preloadBandwidth = _preloadBandwidth
+		? ((_preloadBandwidth * 3 + bandwidth) / 4)
+		: bandwidth;
 }
 
 void Stories::preloadFinished(FullStoryId id, bool markAsPreloaded) {
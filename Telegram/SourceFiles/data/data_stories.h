@@ -304,9 +304,11 @@ private:
 	void preloadSourcesChanged(StorySourcesList list);
 	bool rebuildPreloadSources(StorySourcesList list);
 	void continuePreloading();
+	[[nodiscard]] int preloadDepth() const;
 	[[nodiscard]] bool shouldContinuePreload(FullStoryId id) const;
 	[[nodiscard]] FullStoryId nextPreloadId() const;
 	void startPreloading(not_null<Story*> story);
+	void preloadMeasured(int64 bytes, crl::time duration);
 	void preloadFinished(FullStoryId id, bool markAsPreloaded = false);
 	void preloadListsMore();
 
@@ -393,7 +395,8 @@ private:
 	base::flat_set<FullStoryId> _preloaded;
 	std::vector<FullStoryId> _toPreloadSources[kStorySourcesListCount];
 	std::vector<FullStoryId> _toPreloadViewer;
-	std::unique_ptr<StoryPreload> _preloading;
+	base::flat_map<FullStoryId, std::unique_ptr<StoryPreload>> _preloading;
+	int64 _preloadBandwidth = 0;
 	int _preloadingHiddenSourcesCounter = 0;
 	int _preloadingMainSourcesCounter = 0;
 
@@ -217,7 +217,7 @@ StoryPreload::LoadTask::LoadTask(
 	for (auto i = 0; i != parts; ++i) {
 		_parts.emplace(i * part, QByteArray());
 	}
-	addToQueue();
+	addToQueue(Storage::kBackgroundDownloadPriority);
 }
 
 StoryPreload::LoadTask::~LoadTask() {
@@ -924,6 +924,14 @@ not_null<Story*> StoryPreload::story() const {
 	return _story;
 }
 
+int64 StoryPreload::loadedBytes() const {
+	return _loadedBytes;
+}
+
+crl::time StoryPreload::loadDuration() const {
+	return _loadFinished ? (_loadFinished - _loadStarted) : 0;
+}
+
 void StoryPreload::start() {
 	if (const auto photo = _story->photo()) {
 		_photo = photo->createMediaView();
@@ -979,7 +987,10 @@ void StoryPreload::load() {
 		callDone();
 		return;
 	}
+	_loadStarted = crl::now();
 	_task = std::make_unique<LoadTask>(id(), video, [=](QByteArray data) {
+		_loadFinished = crl::now();
+		_loadedBytes = data.size();
 		if (!data.isEmpty()) {
 			Assert(data.size() < Storage::kMaxFileInMemory);
 			_story->owner().cacheBigFile().putIfEmpty(
@@ -269,6 +269,10 @@ public:
 	[[nodiscard]] FullStoryId id() const;
 	[[nodiscard]] not_null<Story*> story() const;
 
+	// Only for the video prefixes loaded from the network.
+	[[nodiscard]] int64 loadedBytes() const;
+	[[nodiscard]] crl::time loadDuration() const;
+
 private:
 	class LoadTask;
 
@@ -281,6 +285,9 @@ private:
 
 	std::shared_ptr<Data::PhotoMedia> _photo;
 	std::unique_ptr<LoadTask> _task;
+	crl::time _loadStarted = 0;
+	crl::time _loadFinished = 0;
+	int64 _loadedBytes = 0;
 	rpl::lifetime _lifetime;
 
 };
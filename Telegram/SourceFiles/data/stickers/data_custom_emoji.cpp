@@ -366,7 +366,7 @@ void CustomEmojiLoader::check() {
 	auto put = [=, key = cacheKey(document)](QByteArray value) {
 		const auto size = value.size();
 		if (size <= Storage::kMaxFileInMemory) {
-			document->owner().cacheBigFile().put(key, std::move(value));
+			document->owner().cacheBigFilePut(key, std::move(value));
 		} else {
 			LOG(("Data Error: Cached emoji size too big: %1.").arg(size));
 		}
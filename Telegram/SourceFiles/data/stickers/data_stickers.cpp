@@ -148,6 +148,9 @@ Main::Session &Stickers::session() const {
 }
 
 void Stickers::notifyUpdated(StickersType type) {
+	if (type == StickersType::Stickers) {
+		_emojiIndexDirty = true;
+	}
 	_updated.fire_copy(type);
 }
 
@@ -1132,6 +1135,45 @@ void Stickers::gifsReceived(const QVector<MTPDocument> &items, uint64 hash) {
 	notifySavedGifsUpdated();
 }
 
+void Stickers::validateEmojiIndex() {
+	if (!_emojiIndexDirty) {
+		return;
+	}
+	_emojiIndexDirty = false;
+	_emojiIndex.clear();
+	_emojiAltIndex.clear();
+	_emojiIndexNotLoaded.clear();
+
+	auto position = 0;
+	for (const auto setId : _setsOrder) {
+		const auto it = _sets.find(setId);
+		if (it == _sets.cend()) {
+			continue;
+		}
+		const auto set = it->second.get();
+		if (set->emoji.empty()) {
+			_emojiIndexNotLoaded.push_back(set);
+			continue;
+		}
+		for (const auto &[emoji, pack] : set->emoji) {
+			auto &list = _emojiIndex[emoji];
+			for (const auto document : pack) {
+				if (document->sticker()) {
+					list.push_back({ document, set, position++ });
+				}
+			}
+		}
+		for (const auto document : set->stickers) {
+			const auto sticker = document->sticker();
+			if (!sticker) {
+				continue;
+			} else if (const auto main = Ui::Emoji::Find(sticker->alt)) {
+				_emojiAltIndex[main].push_back({ document, set, position++ });
+			}
+		}
+	}
+}
+
 std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		std::vector<EmojiPtr> emoji,
 		uint64 seed,
@@ -1147,13 +1189,12 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
-	auto &sets = setsRef();
+	auto added = base::flat_set<not_null<DocumentData*>>();
+	const auto &sets = this->sets();
 	auto setsToRequest = base::flat_map<uint64, uint64>();
 
 	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
+		if (added.emplace(document).second) {
 			result.push_back({ document, date });
 		}
 	};
@@ -1241,58 +1282,53 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 				result.push_back({
 					document,
 					date ? date : CreateRecentSortKey(document) });
+				added.emplace(document);
 			}
 		}
 	}
-	const auto addList = [&](
-			const StickersSetsOrder &order,
-			SetFlag skip) {
-		for (const auto setId : order) {
-			auto it = sets.find(setId);
-			if (it == sets.cend() || (it->second->flags & skip)) {
-				continue;
-			}
-			const auto set = it->second.get();
-			if (set->emoji.empty()) {
-				setsToRequest.emplace(set->id, set->accessHash);
-				set->flags |= SetFlag::NotLoaded;
+
+	validateEmojiIndex();
+	for (const auto set : _emojiIndexNotLoaded) {
+		if (set->emoji.empty() && !(set->flags & SetFlag::Archived)) {
+			setsToRequest.emplace(set->id, set->accessHash);
+			set->flags |= SetFlag::NotLoaded;
+		}
+	}
+	const auto addEntries = [&](const std::vector<EmojiIndexEntry> &list) {
+		result.reserve(result.size() + list.size());
+		for (const auto &entry : list) {
+			const auto set = entry.set;
+			if (set->flags & SetFlag::Archived) {
 				continue;
 			}
+			const auto document = entry.document;
 			const auto my = (set->flags & SetFlag::Installed);
-			const auto i = single
-				? set->emoji.find(single)
-				: set->emoji.end();
-			const auto list = (i != set->emoji.end())
-				? &i->second
-				: !single
-				? &set->stickers
-				: nullptr;
-			if (list) {
-				result.reserve(result.size() + list->size());
-				for (const auto document : *list) {
-					const auto sticker = document->sticker();
-					if (!sticker) {
-						continue;
-					} else if (!single) {
-						const auto main = Ui::Emoji::Find(sticker->alt);
-						if (!main || !all.contains(main)) {
-							continue;
-						}
-					}
-					const auto installDate = my ? set->installDate : TimeId(0);
-					const auto date = (installDate > 1)
-						? InstallDateAdjusted(installDate, document)
-						: my
-						? CreateMySortKey(document)
-						: CreateFeaturedSortKey(document);
-					add(document, date);
-				}
-			}
+			const auto installDate = my ? set->installDate : TimeId(0);
+			const auto date = (installDate > 1)
+				? InstallDateAdjusted(installDate, document)
+				: my
+				? CreateMySortKey(document)
+				: CreateFeaturedSortKey(document);
+			add(document, date);
 		}
 	};
-
-	addList(setsOrder(), SetFlag::Archived);
-	//addList(featuredSetsOrder(), SetFlag::Installed);
+	if (single) {
+		const auto i = _emojiIndex.find(single);
+		if (i != end(_emojiIndex)) {
+			addEntries(i->second);
+		}
+	} else {
+		// Merge the lists back to the sets order.
+		auto merged = std::vector<EmojiIndexEntry>();
+		for (const auto emoji : all) {
+			const auto i = _emojiAltIndex.find(emoji);
+			if (i != end(_emojiAltIndex)) {
+				merged.insert(end(merged), begin(i->second), end(i->second));
+			}
+		}
+		ranges::sort(merged, ranges::less(), &EmojiIndexEntry::position);
+		addEntries(merged);
+	}
 
 	if (!setsToRequest.empty()) {
 		for (const auto &[setId, accessHash] : setsToRequest) {
@@ -153,12 +153,14 @@ public:
 		return _sets;
 	}
 	[[nodiscard]] StickersSets &setsRef() {
+		_emojiIndexDirty = true;
 		return _sets;
 	}
 	[[nodiscard]] const StickersSetsOrder &setsOrder() const {
 		return _setsOrder;
 	}
 	[[nodiscard]] StickersSetsOrder &setsOrderRef() {
+		_emojiIndexDirty = true;
 		return _setsOrder;
 	}
 	[[nodiscard]] const StickersSetsOrder &maskSetsOrder() const {
@@ -294,6 +296,16 @@ private:
 		const MTPDmessages_featuredStickers &data,
 		StickersType type);
 
+	struct EmojiIndexEntry {
+		not_null<DocumentData*> document;
+		not_null<StickersSet*> set;
+		int position = 0;
+	};
+	using EmojiIndex = base::flat_map<
+		EmojiPtr,
+		std::vector<EmojiIndexEntry>>;
+	void validateEmojiIndex();
+
 	const not_null<Session*> _owner;
 	rpl::event_stream<StickersType> _updated;
 	rpl::event_stream<StickersType> _recentUpdated;
@@ -320,6 +332,13 @@ private:
 	StickersSetsOrder _archivedMaskSetsOrder;
 	SavedGifs _savedGifs;
 
+	// Installed sets stickers by pack emoji and by their main emoji,
+	// rebuilt lazily after the sets or their order were accessed for write.
+	EmojiIndex _emojiIndex;
+	EmojiIndex _emojiAltIndex;
+	std::vector<not_null<StickersSet*>> _emojiIndexNotLoaded;
+	bool _emojiIndexDirty = true;
+
 };
 
 } // namespace Data
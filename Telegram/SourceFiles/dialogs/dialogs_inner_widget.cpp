@@ -20,6 +20,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "core/application.h"
 #include "core/click_handler_types.h"
+#include "core/core_trace.h"
 #include "core/shortcuts.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
@@ -600,6 +601,7 @@ void InnerWidget::showSavedSublists() {
 }
 
 void InnerWidget::paintEvent(QPaintEvent *e) {
+	const auto trace = Core::Trace::Scope("Dialogs::InnerWidget::paintEvent");
 	Painter p(this);
 
 	p.setInactive(
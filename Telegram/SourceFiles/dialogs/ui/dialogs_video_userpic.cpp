@@ -7,7 +7,6 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "dialogs/ui/dialogs_video_userpic.h"
 
-#include "core/file_location.h"
 #include "data/data_peer.h"
 #include "data/data_photo.h"
 #include "data/data_photo_media.h"
@@ -43,6 +42,7 @@ void VideoUserpic::paintLeft(
 	const auto photoId = _peer->userpicPhotoId();
 	if (_videoPhotoId != photoId) {
 		_videoPhotoId = photoId;
+		_videoLifetime.destroy();
 		_video = nullptr;
 		_videoPhotoMedia = nullptr;
 		const auto photo = _peer->owner().photo(photoId);
@@ -72,24 +72,27 @@ void VideoUserpic::paintLeft(
 				? _videoPhotoMedia->videoContent(Data::PhotoSize::Large)
 				: small;
 			if (!bytes.isEmpty()) {
-				auto callback = [=](Media::Clip::Notification notification) {
+				_video = Media::Clip::MakeSharedReader(
+					_videoPhotoId,
+					size * style::DevicePixelRatio(),
+					bytes);
+				_video->notifications(
+				) | rpl::start_with_next([=](
+						Media::Clip::Notification notification) {
 					clipCallback(notification);
-				};
-				_video = Media::Clip::MakeReader(
-					Core::FileLocation(),
-					std::move(bytes),
-					std::move(callback));
+				}, _videoLifetime);
 			}
 		}
 	}
 	if (rtl()) {
 		x = w - x - size;
 	}
-	if (_video && _video->ready()) {
+	const auto video = _video ? _video->get() : nullptr;
+	if (video && video->ready()) {
 		startReady();
 
 		const auto now = paused ? crl::time(0) : crl::now();
-		p.drawImage(x, y, _video->current(request(size), now));
+		p.drawImage(x, y, video->current(request(size), now));
 	} else {
 		_peer->paintUserpicLeft(p, view, x, y, w, size);
 	}
@@ -105,12 +108,13 @@ Media::Clip::FrameRequest VideoUserpic::request(int size) const {
 }
 
 bool VideoUserpic::startReady(int size) {
-	if (!_video->ready() || _video->started()) {
+	const auto video = _video ? _video->get() : nullptr;
+	if (!video || !video->ready() || video->started()) {
 		return false;
 	} else if (!_lastSize) {
-		_lastSize = size ? size : _video->width();
+		_lastSize = size ? size : video->width();
 	}
-	_video->start(request(_lastSize));
+	video->start(request(_lastSize));
 	_repaint();
 	return true;
 }
@@ -120,9 +124,7 @@ void VideoUserpic::clipCallback(Media::Clip::Notification notification) {
 
 	switch (notification) {
 	case Notification::Reinit: {
-		if (_video->state() == State::Error) {
-			_video.setBad();
-		} else if (startReady()) {
+		if (!_video->isBad() && startReady()) {
 			_repaint();
 		}
 	} break;
@@ -53,7 +53,8 @@ private:
 	const not_null<PeerData*> _peer;
 	const Fn<void()> _repaint;
 
-	Media::Clip::ReaderPointer _video;
+	std::shared_ptr<Media::Clip::SharedReader> _video;
+	rpl::lifetime _videoLifetime;
 	int _lastSize = 0;
 	std::shared_ptr<Data::PhotoMedia> _videoPhotoMedia;
 	PhotoId _videoPhotoId = 0;
@@ -2180,6 +2180,17 @@ bool SingleMessageAfter(
 	return (single > 0 && single > date);
 }
 
+bool SingleMessageIdFrom(const MTPmessages_Messages &data, int32 id) {
+	return data.match([&](const MTPDmessages_messagesNotModified &data) {
+		return false;
+	}, [&](const auto &data) {
+		const auto &list = data.vmessages().v;
+		return !list.isEmpty() && list[0].match([&](const auto &data) {
+			return (data.vid().v >= id);
+		});
+	});
+}
+
 bool SkipMessageByDate(const Message &message, const Settings &settings) {
 	const auto goodFrom = (settings.singlePeerFrom <= 0)
 		|| (settings.singlePeerFrom <= message.date);
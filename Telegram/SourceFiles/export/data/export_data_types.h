@@ -851,6 +851,7 @@ bool SingleMessageBefore(
 bool SingleMessageAfter(
 	const MTPmessages_Messages &data,
 	TimeId date);
+bool SingleMessageIdFrom(const MTPmessages_Messages &data, int32 id);
 bool SkipMessageByDate(const Message &message, const Settings &settings);
 
 Utf8String FormatPhoneNumber(const Utf8String &phoneNumber);
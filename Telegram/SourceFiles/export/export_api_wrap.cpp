@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "export/export_api_wrap.h"
 
+#include "export/export_manifest.h"
 #include "export/export_settings.h"
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_result.h"
@@ -32,15 +33,10 @@ constexpr auto kFileMaxSize = 4000 * int64(1024 * 1024);
 constexpr auto kLocationCacheSize = 100'000;
 constexpr auto kMaxEmojiPerRequest = 100;
 constexpr auto kStoriesSliceLimit = 100;
+constexpr auto kMessagesPrefetchSlices = 8;
+constexpr auto kMessagesPrefetchBytes = 16 * 1024 * 1024;
 
-struct LocationKey {
-	uint64 type;
-	uint64 id;
-
-	inline bool operator<(const LocationKey &other) const {
-		return std::tie(type, id) < std::tie(other.type, other.id);
-	}
-};
+using LocationKey = Manifest::FileKey;
 
 LocationKey ComputeLocationKey(const Data::FileLocation &value) {
 	auto result = LocationKey();
@@ -67,6 +63,18 @@ LocationKey ComputeLocationKey(const Data::FileLocation &value) {
 	return result;
 }
 
+// Rough size of the parsed slice in memory, used for the prefetch budget.
+int64 EstimateSliceSize(const Data::MessagesSlice &slice) {
+	auto result = int64();
+	for (const auto &message : slice.list) {
+		result += sizeof(Data::Message);
+		for (const auto &part : message.text) {
+			result += part.text.size() + part.additional.size();
+		}
+	}
+	return result;
+}
+
 Settings::Type SettingsFromDialogsType(Data::DialogInfo::Type type) {
 	using DialogType = Data::DialogInfo::Type;
 	switch (type) {
@@ -210,6 +218,12 @@ struct ApiWrap::DialogsProcess : ChatsProcess {
 	MTPInputPeer offsetPeer = MTP_inputPeerEmpty();
 };
 
+struct ApiWrap::PrefetchedSlice {
+	Data::MessagesSlice slice;
+	int64 bytes = 0;
+	bool last = false;
+};
+
 struct ApiWrap::ChatProcess {
 	Data::DialogInfo info;
 
@@ -227,6 +241,13 @@ struct ApiWrap::ChatProcess {
 	std::optional<Data::MessagesSlice> slice;
 	bool lastSlice = false;
 	int fileIndex = 0;
+
+	// Slices received while the previous one was still being processed.
+	std::deque<PrefetchedSlice> prefetched;
+	int64 prefetchedBytes = 0;
+	bool requesting = false;
+	bool waiting = false;
+	bool receivedLast = false;
 };
 
 
@@ -406,7 +427,8 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 
 ApiWrap::ApiWrap(QPointer<MTP::Instance> weak, Fn<void(FnMut<void()>)> runner)
 : _mtp(weak, std::move(runner))
-, _fileCache(std::make_unique<LoadedFileCache>(kLocationCacheSize)) {
+, _fileCache(std::make_unique<LoadedFileCache>(kLocationCacheSize))
+, _manifest(std::make_unique<Manifest>()) {
 }
 
 rpl::producer<MTP::Error> ApiWrap::errors() const {
@@ -452,6 +474,14 @@ void ApiWrap::startExport(
 	});
 }
 
+void ApiWrap::setPreviousExport(Manifest &&previous) {
+	_previous = std::make_unique<Manifest>(std::move(previous));
+}
+
+const Manifest &ApiWrap::manifest() const {
+	return *_manifest;
+}
+
 void ApiWrap::sendNextStartRequest() {
 	Expects(_startProcess != nullptr);
 
@@ -1179,6 +1209,7 @@ void ApiWrap::requestMessages(
 	_chatProcess = std::make_unique<ChatProcess>();
 	_chatProcess->context.selfPeerId = peerFromUser(*_selfId);
 	_chatProcess->info = info;
+	_chatProcess->largestIdPlusOne = firstMessageId(info.splits[0]);
 	_chatProcess->start = std::move(start);
 	_chatProcess->fileProgress = std::move(progress);
 	_chatProcess->handleSlice = std::move(slice);
@@ -1191,8 +1222,9 @@ void ApiWrap::requestMessagesCount(int localSplitIndex) {
 	Expects(_chatProcess != nullptr);
 	Expects(localSplitIndex < _chatProcess->info.splits.size());
 
+	const auto splitIndex = _chatProcess->info.splits[localSplitIndex];
 	requestChatMessages(
-		_chatProcess->info.splits[localSplitIndex],
+		splitIndex,
 		0, // offset_id
 		0, // add_offset
 		1, // limit
@@ -1215,7 +1247,10 @@ void ApiWrap::requestMessagesCount(int localSplitIndex) {
 		}
 		const auto skipSplit = !Data::SingleMessageAfter(
 			result,
-			_settings->singlePeerFrom);
+			_settings->singlePeerFrom)
+			|| !Data::SingleMessageIdFrom(
+				result,
+				firstMessageId(splitIndex));
 		if (skipSplit) {
 			// No messages from the requested range, skip this split.
 			messagesCountLoaded(localSplitIndex, 0);
@@ -1596,12 +1631,48 @@ void ApiWrap::appendChatsSlice(
 void ApiWrap::requestMessagesSlice() {
 	Expects(_chatProcess != nullptr);
 
-	const auto count = _chatProcess->info.messagesCountPerSplit[
-		_chatProcess->localSplitIndex];
+	auto &process = *_chatProcess;
+	if (!process.prefetched.empty()) {
+		auto prefetched = std::move(process.prefetched.front());
+		process.prefetched.pop_front();
+		process.prefetchedBytes -= prefetched.bytes;
+		prefetchMessagesSlice();
+		process.lastSlice = prefetched.last;
+		loadMessagesFiles(std::move(prefetched.slice));
+		return;
+	}
+	process.waiting = true;
+	if (process.requesting) {
+		return;
+	}
+	const auto count = process.info.messagesCountPerSplit[
+		process.localSplitIndex];
 	if (!count) {
+		process.waiting = false;
 		loadMessagesFiles({});
 		return;
 	}
+	sendMessagesSliceRequest();
+}
+
+void ApiWrap::prefetchMessagesSlice() {
+	Expects(_chatProcess != nullptr);
+
+	const auto &process = *_chatProcess;
+	if (process.requesting
+		|| process.receivedLast
+		|| process.prefetched.size() >= kMessagesPrefetchSlices
+		|| process.prefetchedBytes >= kMessagesPrefetchBytes) {
+		return;
+	}
+	sendMessagesSliceRequest();
+}
+
+void ApiWrap::sendMessagesSliceRequest() {
+	Expects(_chatProcess != nullptr);
+	Expects(!_chatProcess->requesting);
+
+	_chatProcess->requesting = true;
 	requestChatMessages(
 		_chatProcess->info.splits[_chatProcess->localSplitIndex],
 		_chatProcess->largestIdPlusOne,
@@ -1610,22 +1681,48 @@ void ApiWrap::requestMessagesSlice() {
 		[=](const MTPmessages_Messages &result) {
 		Expects(_chatProcess != nullptr);
 
+		_chatProcess->requesting = false;
 		result.match([&](const MTPDmessages_messagesNotModified &data) {
 			error("Unexpected messagesNotModified received.");
 		}, [&](const auto &data) {
-			if constexpr (MTPDmessages_messages::Is<decltype(data)>()) {
-				_chatProcess->lastSlice = true;
-			}
-			loadMessagesFiles(Data::ParseMessagesSlice(
+			auto slice = Data::ParseMessagesSlice(
 				_chatProcess->context,
 				data.vmessages(),
 				data.vusers(),
 				data.vchats(),
-				_chatProcess->info.relativePath));
+				_chatProcess->info.relativePath);
+			const auto last = MTPDmessages_messages::Is<decltype(data)>()
+				|| slice.list.empty();
+			if (!slice.list.empty()) {
+				_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
+			}
+			messagesSliceReceived(std::move(slice), last);
 		});
 	});
 }
 
+void ApiWrap::messagesSliceReceived(Data::MessagesSlice &&slice, bool last) {
+	Expects(_chatProcess != nullptr);
+
+	auto &process = *_chatProcess;
+	process.receivedLast = last;
+	if (process.waiting) {
+		process.waiting = false;
+		process.lastSlice = last;
+		prefetchMessagesSlice();
+		loadMessagesFiles(std::move(slice));
+		return;
+	}
+	const auto bytes = EstimateSliceSize(slice);
+	process.prefetched.push_back({
+		.slice = std::move(slice),
+		.bytes = bytes,
+		.last = last,
+	});
+	process.prefetchedBytes += bytes;
+	prefetchMessagesSlice();
+}
+
 void ApiWrap::requestChatMessages(
 		int splitIndex,
 		int offsetId,
@@ -1889,9 +1986,17 @@ void ApiWrap::finishMessagesSlice() {
 
 	auto slice = *base::take(_chatProcess->slice);
 	if (!slice.list.empty()) {
-		_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
 		const auto splitIndex = _chatProcess->info.splits[
 			_chatProcess->localSplitIndex];
+		if (!_settings->singlePeerFrom && _settings->singlePeerTill <= 0) {
+			// Messages out of the date range are skipped only by the
+			// writers, so a date limited export doesn't remember ids.
+			auto &lastIds = (splitIndex < 0)
+				? _manifest->lastMigratedMessageIds
+				: _manifest->lastMessageIds;
+			auto &lastId = lastIds[_chatProcess->info.peerId];
+			lastId = std::max(lastId, slice.list.back().id);
+		}
 		if (splitIndex < 0) {
 			slice = AdjustMigrateMessageIds(std::move(slice));
 		}
@@ -1903,7 +2008,9 @@ void ApiWrap::finishMessagesSlice() {
 		&& (++_chatProcess->localSplitIndex
 			< _chatProcess->info.splits.size())) {
 		_chatProcess->lastSlice = false;
-		_chatProcess->largestIdPlusOne = 1;
+		_chatProcess->receivedLast = false;
+		_chatProcess->largestIdPlusOne = firstMessageId(
+			_chatProcess->info.splits[_chatProcess->localSplitIndex]);
 	}
 	if (!_chatProcess->lastSlice) {
 		requestMessagesSlice();
@@ -1984,6 +2091,19 @@ void ApiWrap::finishMessages() {
 	process->done();
 }
 
+int32 ApiWrap::firstMessageId(int splitIndex) const {
+	Expects(_chatProcess != nullptr);
+
+	if (!_previous) {
+		return 1;
+	}
+	const auto &lastIds = (splitIndex < 0)
+		? _previous->lastMigratedMessageIds
+		: _previous->lastMessageIds;
+	const auto i = lastIds.find(_chatProcess->info.peerId);
+	return (i != end(lastIds)) ? (i->second + 1) : 1;
+}
+
 bool ApiWrap::processFileLoad(
 		Data::File &file,
 		const Data::FileOrigin &origin,
@@ -2043,6 +2163,8 @@ bool ApiWrap::processFileLoad(
 		// Don't load thumbs for large files that we skip.
 		file.skipReason = SkipReason::FileSize;
 		return true;
+	} else if (copyPreviousFile(file)) {
+		return true;
 	}
 	loadFile(file, origin, std::move(progress), std::move(done));
 	return false;
@@ -2062,7 +2184,7 @@ bool ApiWrap::writePreloadedFile(
 		const auto process = prepareFileProcess(file, origin);
 		if (const auto result = process->file.writeBlock(file.content)) {
 			file.relativePath = process->relativePath;
-			_fileCache->save(file.location, file.relativePath);
+			rememberFile(file.location, file.relativePath);
 		} else {
 			ioError(result);
 		}
@@ -2071,6 +2193,46 @@ bool ApiWrap::writePreloadedFile(
 	return false;
 }
 
+bool ApiWrap::copyPreviousFile(Data::File &file) {
+	Expects(_settings != nullptr);
+
+	if (!_previous || !file.location) {
+		return false;
+	}
+	const auto &files = _previous->files;
+	const auto i = files.find(ComputeLocationKey(file.location));
+	if (i == end(files) || !QFile::exists(i->second)) {
+		return false;
+	}
+	const auto relativePath = Output::File::PrepareRelativePath(
+		_settings->path,
+		file.suggestedPath);
+	const auto result = Output::File::Copy(
+		i->second,
+		_settings->path + relativePath,
+		_stats);
+	if (!result) {
+		LOG(("Export Error: Could not copy '%1', loading it again."
+			).arg(i->second));
+		return false;
+	}
+	file.relativePath = relativePath;
+	rememberFile(file.location, relativePath);
+	return true;
+}
+
+void ApiWrap::rememberFile(
+		const Data::FileLocation &location,
+		const QString &relativePath) {
+	_fileCache->save(location, relativePath);
+	if (location && !relativePath.isEmpty()) {
+		const auto key = ComputeLocationKey(location);
+		if (key.id) {
+			_manifest->files[key] = relativePath;
+		}
+	}
+}
+
 void ApiWrap::loadFile(
 		const Data::File &file,
 		const Data::FileOrigin &origin,
@@ -2209,7 +2371,7 @@ void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
 
 	auto process = base::take(_fileProcess);
 	const auto relativePath = process->relativePath;
-	_fileCache->save(process->location, relativePath);
+	rememberFile(process->location, relativePath);
 	process->done(process->relativePath);
 }
 
@@ -37,6 +37,7 @@ class Stats;
 } // namespace Output
 
 struct Settings;
+struct Manifest;
 
 class ApiWrap {
 public:
@@ -55,6 +56,10 @@ public:
 		Output::Stats *stats,
 		FnMut<void(StartInfo)> done);
 
+	// Messages and files from the previous exports are not loaded again.
+	void setPreviousExport(Manifest &&previous);
+	[[nodiscard]] const Manifest &manifest() const;
+
 	void requestDialogsList(
 		Fn<bool(int count)> progress,
 		FnMut<void(Data::DialogsInfo&&)> done);
@@ -113,6 +118,7 @@ private:
 	struct ChatsProcess;
 	struct LeftChannelsProcess;
 	struct DialogsProcess;
+	struct PrefetchedSlice;
 	struct ChatProcess;
 
 	void startMainSession(FnMut<void()> done);
@@ -173,6 +179,9 @@ private:
 	void checkFirstMessageDate(int localSplitIndex, int count);
 	void messagesCountLoaded(int localSplitIndex, int count);
 	void requestMessagesSlice();
+	void prefetchMessagesSlice();
+	void sendMessagesSliceRequest();
+	void messagesSliceReceived(Data::MessagesSlice &&slice, bool last);
 	void requestChatMessages(
 		int splitIndex,
 		int offsetId,
@@ -192,6 +201,7 @@ private:
 	void loadMessageEmojiDone(uint64 id, const QString &relativePath);
 	void finishMessagesSlice();
 	void finishMessages();
+	[[nodiscard]] int32 firstMessageId(int splitIndex) const;
 
 	[[nodiscard]] Data::Message *currentFileMessage() const;
 	[[nodiscard]] Data::FileOrigin currentFileMessageOrigin() const;
@@ -209,6 +219,10 @@ private:
 	bool writePreloadedFile(
 		Data::File &file,
 		const Data::FileOrigin &origin);
+	bool copyPreviousFile(Data::File &file);
+	void rememberFile(
+		const Data::FileLocation &location,
+		const QString &relativePath);
 	void loadFile(
 		const Data::File &file,
 		const Data::FileOrigin &origin,
@@ -252,6 +266,8 @@ private:
 
 	std::unique_ptr<StartProcess> _startProcess;
 	std::unique_ptr<LoadedFileCache> _fileCache;
+	std::unique_ptr<Manifest> _manifest;
+	std::unique_ptr<Manifest> _previous;
 	std::unique_ptr<ContactsProcess> _contactsProcess;
 	std::unique_ptr<UserpicsProcess> _userpicsProcess;
 	std::unique_ptr<StoriesProcess> _storiesProcess;
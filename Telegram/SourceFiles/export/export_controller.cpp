@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/export_controller.h"
 
 #include "export/export_api_wrap.h"
+#include "export/export_manifest.h"
 #include "export/export_settings.h"
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_abstract.h"
@@ -26,6 +27,7 @@ Settings NormalizeSettings(const Settings &settings) {
 	}
 	auto result = base::duplicate(settings);
 	result.types = result.fullChats = Settings::Type::AnyChatsMask;
+	result.delta = false;
 	return result;
 }
 
@@ -253,6 +255,9 @@ void ControllerObject::startExport(
 	_settings = NormalizeSettings(settings);
 	_environment = environment;
 
+	if (_settings.delta) {
+		_api.setPreviousExport(ReadPreviousExports(_settings.path));
+	}
 	_settings.path = Output::NormalizePath(_settings);
 	_writer = Output::CreateWriter(_settings.format);
 	fillExportSteps();
@@ -340,7 +345,8 @@ void ControllerObject::cancelExportFast() {
 
 void ControllerObject::exportNext() {
 	if (++_stepIndex >= _steps.size()) {
-		if (ioCatchError(_writer->finish())) {
+		if (ioCatchError(_writer->finish())
+			|| ioCatchError(WriteManifest(_settings.path, _api.manifest()))) {
 			return;
 		}
 		_api.finishExport([=] {
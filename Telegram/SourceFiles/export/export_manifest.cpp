@@ -0,0 +1,128 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/export_manifest.h"
+
+#include "export/output/export_output_file.h"
+#include "export/output/export_output_result.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+namespace Export {
+namespace {
+
+const auto kManifestName = u"export_manifest.json"_q;
+
+[[nodiscard]] QString SerializeId(uint64 value) {
+	// Doubles in JSON can't hold all 64 bit values.
+	return QString::number(value);
+}
+
+[[nodiscard]] uint64 ParseId(const QJsonValue &value) {
+	return value.toString().toULongLong();
+}
+
+void MergeLastId(
+		base::flat_map<PeerId, int32> &to,
+		PeerId peerId,
+		int32 id) {
+	if (id > 0) {
+		auto &already = to[peerId];
+		already = std::max(already, id);
+	}
+}
+
+void ReadManifest(Manifest &to, const QString &folder) {
+	auto file = QFile(folder + kManifestName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	auto error = QJsonParseError();
+	const auto document = QJsonDocument::fromJson(file.readAll(), &error);
+	if (error.error != QJsonParseError::NoError || !document.isObject()) {
+		LOG(("Export Error: Bad manifest in '%1'.").arg(folder));
+		return;
+	}
+	const auto object = document.object();
+	for (const auto &value : object.value(u"chats"_q).toArray()) {
+		const auto chat = value.toObject();
+		const auto peerId = PeerId(PeerIdHelper(ParseId(chat.value(u"id"_q))));
+		if (!peerId) {
+			continue;
+		}
+		MergeLastId(
+			to.lastMessageIds,
+			peerId,
+			chat.value(u"last_message_id"_q).toInt());
+		MergeLastId(
+			to.lastMigratedMessageIds,
+			peerId,
+			chat.value(u"last_migrated_message_id"_q).toInt());
+	}
+	for (const auto &value : object.value(u"files"_q).toArray()) {
+		const auto file = value.toObject();
+		const auto path = file.value(u"path"_q).toString();
+		const auto key = Manifest::FileKey{
+			.type = ParseId(file.value(u"type"_q)),
+			.id = ParseId(file.value(u"id"_q)),
+		};
+		if (!path.isEmpty() && key.id) {
+			to.files.emplace(key, folder + path);
+		}
+	}
+}
+
+} // namespace
+
+Output::Result WriteManifest(
+		const QString &folder,
+		const Manifest &manifest) {
+	auto chats = base::flat_map<PeerId, QJsonObject>();
+	for (const auto &[peerId, id] : manifest.lastMessageIds) {
+		chats[peerId].insert(u"last_message_id"_q, id);
+	}
+	for (const auto &[peerId, id] : manifest.lastMigratedMessageIds) {
+		chats[peerId].insert(u"last_migrated_message_id"_q, id);
+	}
+	auto chatsList = QJsonArray();
+	for (auto &[peerId, chat] : chats) {
+		chat.insert(u"id"_q, SerializeId(peerId.value));
+		chatsList.append(chat);
+	}
+	auto filesList = QJsonArray();
+	for (const auto &[key, path] : manifest.files) {
+		filesList.append(QJsonObject{
+			{ u"type"_q, SerializeId(key.type) },
+			{ u"id"_q, SerializeId(key.id) },
+			{ u"path"_q, path },
+		});
+	}
+	const auto document = QJsonDocument(QJsonObject{
+		{ u"chats"_q, chatsList },
+		{ u"files"_q, filesList },
+	});
+	return Output::File(folder + kManifestName, nullptr).writeBlock(
+		document.toJson(QJsonDocument::Compact));
+}
+
+Manifest ReadPreviousExports(const QString &folder) {
+	auto result = Manifest();
+	const auto dir = QDir(folder);
+	if (!dir.exists()) {
+		return result;
+	}
+	ReadManifest(result, dir.absolutePath() + '/');
+	const auto mode = QDir::Dirs | QDir::NoDotAndDotDot;
+	for (const auto &entry : dir.entryInfoList(mode)) {
+		ReadManifest(result, entry.absoluteFilePath() + '/');
+	}
+	return result;
+}
+
+} // namespace Export
@@ -0,0 +1,45 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "data/data_peer_id.h"
+
+namespace Export {
+namespace Output {
+struct Result;
+} // namespace Output
+
+// Saved to the folder of every finished export, lets the next export
+// to the same location skip the messages and files it already has.
+struct Manifest {
+	struct FileKey {
+		uint64 type = 0;
+		uint64 id = 0;
+
+		friend inline auto operator<=>(FileKey, FileKey) = default;
+		friend inline bool operator==(FileKey, FileKey) = default;
+	};
+
+	// Largest exported message id in each chat. History of a legacy group
+	// that was migrated to a supergroup is kept under the supergroup id.
+	base::flat_map<PeerId, int32> lastMessageIds;
+	base::flat_map<PeerId, int32> lastMigratedMessageIds;
+
+	// Paths of the saved files, relative to the export folder.
+	base::flat_map<FileKey, QString> files;
+};
+
+[[nodiscard]] Output::Result WriteManifest(
+	const QString &folder,
+	const Manifest &manifest);
+
+// Merges manifests of all exports found in the folder itself and in its
+// direct sub-folders. File paths in the result are absolute.
+[[nodiscard]] Manifest ReadPreviousExports(const QString &folder);
+
+} // namespace Export
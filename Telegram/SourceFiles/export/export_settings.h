@@ -88,6 +88,9 @@ struct Settings {
 
 	TimeId availableAt = 0;
 
+	// Only what was added since the previous exports to the same path.
+	bool delta = false;
+
 	bool onlySinglePeer() const {
 		return singlePeer.type() != mtpc_inputPeerEmpty;
 	}
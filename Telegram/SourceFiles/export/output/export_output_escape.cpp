@@ -0,0 +1,237 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/output/export_output_escape.h"
+
+#include <array>
+#include <cstring>
+
+namespace Export {
+namespace Output {
+namespace {
+
+constexpr auto kLowBits = 0x0101010101010101ULL;
+constexpr auto kHighBits = 0x8080808080808080ULL;
+
+// 0xE2 starts both line and paragraph separators: E2 80 A8 and E2 80 A9.
+constexpr auto kSeparatorStart = uchar(0xE2);
+
+[[nodiscard]] constexpr uint64 Broadcast(uchar ch) {
+	return kLowBits * ch;
+}
+
+[[nodiscard]] constexpr uint64 HasZeroByte(uint64 word) {
+	return (word - kLowBits) & ~word & kHighBits;
+}
+
+[[nodiscard]] constexpr uint64 HasByte(uint64 word, uchar ch) {
+	return HasZeroByte(word ^ Broadcast(ch));
+}
+
+[[nodiscard]] constexpr uint64 HasControlByte(uint64 word) {
+	return (word - Broadcast(32)) & ~word & kHighBits;
+}
+
+[[nodiscard]] uint64 JsonSpecialIn(uint64 word) {
+	return HasControlByte(word)
+		| HasByte(word, '"')
+		| HasByte(word, '\\')
+		| HasByte(word, kSeparatorStart);
+}
+
+[[nodiscard]] uint64 HtmlSpecialIn(uint64 word) {
+	return HasControlByte(word)
+		| HasByte(word, '"')
+		| HasByte(word, '&')
+		| HasByte(word, '\'')
+		| HasByte(word, '<')
+		| HasByte(word, '>')
+		| HasByte(word, kSeparatorStart);
+}
+
+template <typename... Chars>
+[[nodiscard]] constexpr std::array<bool, 256> MakeSpecialTable(
+		Chars... chars) {
+	auto result = std::array<bool, 256>();
+	for (auto i = 0; i != 32; ++i) {
+		result[i] = true;
+	}
+	((result[uchar(chars)] = true), ...);
+	result[kSeparatorStart] = true;
+	return result;
+}
+
+constexpr auto kJsonSpecial = MakeSpecialTable('"', '\\');
+constexpr auto kHtmlSpecial = MakeSpecialTable('"', '&', '\'', '<', '>');
+
+template <typename WordCheck>
+[[nodiscard]] const char *FindSpecial(
+		const char *from,
+		const char *till,
+		WordCheck &&wordCheck,
+		const std::array<bool, 256> &table) {
+	while (till - from >= 8) {
+		auto word = uint64();
+		std::memcpy(&word, from, 8);
+		if (wordCheck(word)) {
+			break;
+		}
+		from += 8;
+	}
+	while (from != till && !table[uchar(*from)]) {
+		++from;
+	}
+	return from;
+}
+
+[[nodiscard]] const char *FindJsonSpecial(
+		const char *from,
+		const char *till) {
+	return FindSpecial(from, till, JsonSpecialIn, kJsonSpecial);
+}
+
+[[nodiscard]] const char *FindHtmlSpecial(
+		const char *from,
+		const char *till) {
+	return FindSpecial(from, till, HtmlSpecialIn, kHtmlSpecial);
+}
+
+[[nodiscard]] char HexDigit(int value) {
+	return (value >= 10) ? char('A' + (value - 10)) : char('0' + value);
+}
+
+// Returns 0 if it is some other character starting with 0xE2.
+[[nodiscard]] int SeparatorAt(const char *p, const char *till) {
+	if (till - p < 3 || p[1] != char(0x80)) {
+		return 0;
+	} else if (p[2] == char(0xA8)) { // Line separator.
+		return 0x2028;
+	} else if (p[2] == char(0xA9)) { // Paragraph separator.
+		return 0x2029;
+	}
+	return 0;
+}
+
+} // namespace
+
+void AppendEscapedJson(QByteArray &to, const QByteArray &value) {
+	const auto begin = value.constData();
+	const auto end = begin + value.size();
+
+	to.append('"');
+	auto clean = begin;
+	for (auto p = FindJsonSpecial(begin, end)
+		; p != end
+		; p = FindJsonSpecial(p, end)) {
+		const auto ch = *p;
+		if (uchar(ch) == kSeparatorStart) {
+			const auto separator = SeparatorAt(p, end);
+			if (!separator) {
+				++p;
+				continue;
+			}
+			to.append(clean, p - clean);
+			to.append((separator == 0x2028) ? "\\u2028" : "\\u2029", 6);
+			p += 3;
+			clean = p;
+			continue;
+		}
+		to.append(clean, p - clean);
+		if (ch == '\n') {
+			to.append("\\n", 2);
+		} else if (ch == '\r') {
+			to.append("\\r", 2);
+		} else if (ch == '\t') {
+			to.append("\\t", 2);
+		} else if (ch == '"') {
+			to.append("\\\"", 2);
+		} else if (ch == '\\') {
+			to.append("\\\\", 2);
+		} else {
+			const char escaped[] = {
+				'\\',
+				'x',
+				HexDigit(ch >> 4),
+				HexDigit(ch & 0x0F),
+			};
+			to.append(escaped, sizeof(escaped));
+		}
+		clean = ++p;
+	}
+	to.append(clean, end - clean);
+	to.append('"');
+}
+
+void AppendEscapedHtml(QByteArray &to, const QByteArray &value) {
+	const auto begin = value.constData();
+	const auto end = begin + value.size();
+
+	auto clean = begin;
+	for (auto p = FindHtmlSpecial(begin, end)
+		; p != end
+		; p = FindHtmlSpecial(p, end)) {
+		const auto ch = *p;
+		if (uchar(ch) == kSeparatorStart) {
+			if (!SeparatorAt(p, end)) {
+				++p;
+				continue;
+			}
+			to.append(clean, p - clean);
+			to.append("<br>", 4);
+			p += 3;
+			clean = p;
+			continue;
+		}
+		to.append(clean, p - clean);
+		if (ch == '\n') {
+			to.append("<br>", 4);
+		} else if (ch == '"') {
+			to.append("&quot;", 6);
+		} else if (ch == '&') {
+			to.append("&amp;", 5);
+		} else if (ch == '\'') {
+			to.append("&apos;", 6);
+		} else if (ch == '<') {
+			to.append("&lt;", 4);
+		} else if (ch == '>') {
+			to.append("&gt;", 4);
+		} else {
+			const char escaped[] = {
+				'&',
+				'#',
+				'x',
+				HexDigit(ch >> 4),
+				HexDigit(ch & 0x0F),
+				';',
+			};
+			to.append(escaped, sizeof(escaped));
+		}
+		clean = ++p;
+	}
+	to.append(clean, end - clean);
+}
+
+QByteArray EscapeHtml(const QByteArray &value) {
+	const auto begin = value.constData();
+	const auto end = begin + value.size();
+	auto first = FindHtmlSpecial(begin, end);
+	while (first != end
+		&& uchar(*first) == kSeparatorStart
+		&& !SeparatorAt(first, end)) {
+		first = FindHtmlSpecial(first + 1, end);
+	}
+	if (first == end) {
+		return value;
+	}
+	auto result = QByteArray();
+	result.reserve(value.size() + (value.size() / 8) + 16);
+	AppendEscapedHtml(result, value);
+	return result;
+}
+
+} // namespace Output
+} // namespace Export
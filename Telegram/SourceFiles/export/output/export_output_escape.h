@@ -0,0 +1,27 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Export {
+namespace Output {
+
+// Both append the escaped value to the end of the given buffer. The input
+// is scanned eight bytes at a time and runs without special characters
+// are copied with a single append.
+
+// Quoted JSON string literal.
+void AppendEscapedJson(QByteArray &to, const QByteArray &value);
+
+// HTML text, line breaks become <br>.
+void AppendEscapedHtml(QByteArray &to, const QByteArray &value);
+
+// Returns the value itself when there is nothing to escape in it.
+[[nodiscard]] QByteArray EscapeHtml(const QByteArray &value);
+
+} // namespace Output
+} // namespace Export
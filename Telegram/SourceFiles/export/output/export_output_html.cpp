@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "export/output/export_output_html.h"
 
+#include "export/output/export_output_escape.h"
 #include "export/output/export_output_result.h"
 #include "export/data/export_data_types.h"
 #include "core/utils.h"
@@ -105,50 +106,7 @@ auto CalculateThumbSize(
 }
 
 QByteArray SerializeString(const QByteArray &value) {
-	const auto size = value.size();
-	const auto begin = value.data();
-	const auto end = begin + size;
-
-	auto result = QByteArray();
-	result.reserve(size * 6);
-	for (auto p = begin; p != end; ++p) {
-		const auto ch = *p;
-		if (ch == '\n') {
-			result.append("<br>", 4);
-		} else if (ch == '"') {
-			result.append("&quot;", 6);
-		} else if (ch == '&') {
-			result.append("&amp;", 5);
-		} else if (ch == '\'') {
-			result.append("&apos;", 6);
-		} else if (ch == '<') {
-			result.append("&lt;", 4);
-		} else if (ch == '>') {
-			result.append("&gt;", 4);
-		} else if (ch >= 0 && ch < 32) {
-			result.append("&#x", 3).append('0' + (ch >> 4));
-			const auto left = (ch & 0x0F);
-			if (left >= 10) {
-				result.append('A' + (left - 10));
-			} else {
-				result.append('0' + left);
-			}
-			result.append(';');
-		} else if (ch == char(0xE2)
-			&& (p + 2 < end)
-			&& *(p + 1) == char(0x80)) {
-			if (*(p + 2) == char(0xA8)) { // Line separator.
-				result.append("<br>", 4);
-			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
-				result.append("<br>", 4);
-			} else {
-				result.append(ch);
-			}
-		} else {
-			result.append(ch);
-		}
-	}
-	return result;
+	return EscapeHtml(value);
 }
 
 QByteArray SerializeList(const std::vector<QByteArray> &values) {
@@ -821,7 +779,7 @@ QByteArray HtmlWriter::Wrap::pushStoriesListEntry(
 	result.append(pushDiv("body"));
 	if (!info.isEmpty()) {
 		result.append(pushDiv("pull_right info details"));
-		result.append(SerializeString(info));
+		AppendEscapedHtml(result, info);
 		result.append(popTag());
 	}
 	if (!name.isEmpty()) {
@@ -832,7 +790,7 @@ QByteArray HtmlWriter::Wrap::pushStoriesListEntry(
 			}));
 		}
 		result.append(pushDiv("name bold"));
-		result.append(SerializeString(name));
+		AppendEscapedHtml(result, name);
 		result.append(popTag());
 		if (!link.isEmpty()) {
 			result.append(popTag());
@@ -848,7 +806,7 @@ QByteArray HtmlWriter::Wrap::pushStoriesListEntry(
 	}
 	for (const auto &detail : details) {
 		result.append(pushDiv("details_entry details"));
-		result.append(SerializeString(detail));
+		AppendEscapedHtml(result, detail);
 		result.append(popTag());
 	}
 	result.append(popTag());
@@ -896,22 +854,22 @@ QByteArray HtmlWriter::Wrap::pushGenericListEntry(
 	result.append(pushDiv("body"));
 	if (!info.isEmpty()) {
 		result.append(pushDiv("pull_right info details"));
-		result.append(SerializeString(info));
+		AppendEscapedHtml(result, info);
 		result.append(popTag());
 	}
 	if (!name.isEmpty()) {
 		result.append(pushDiv("name bold"));
-		result.append(SerializeString(name));
+		AppendEscapedHtml(result, name);
 		result.append(popTag());
 	}
 	if (!subname.isEmpty()) {
 		result.append(pushDiv("subname bold"));
-		result.append(SerializeString(subname));
+		AppendEscapedHtml(result, subname);
 		result.append(popTag());
 	}
 	for (const auto &detail : details) {
 		result.append(pushDiv("details_entry details"));
-		result.append(SerializeString(detail));
+		AppendEscapedHtml(result, detail);
 		result.append(popTag());
 	}
 	result.append(popTag());
@@ -948,7 +906,7 @@ QByteArray HtmlWriter::Wrap::pushHeader(
 			{ "onclick", "return GoBack(this)"},
 		}));
 	result.append(pushDiv("text bold"));
-	result.append(SerializeString(header));
+	AppendEscapedHtml(result, header);
 	result.append(popTag());
 	result.append(popTag());
 	result.append(popTag());
@@ -968,7 +926,7 @@ QByteArray HtmlWriter::Wrap::pushSection(
 	result.append(Data::NumberToString(count));
 	result.append(popTag());
 	result.append(pushDiv("label bold"));
-	result.append(SerializeString(header));
+	AppendEscapedHtml(result, header);
 	result.append(popTag());
 	result.append(popTag());
 	return result;
@@ -1494,7 +1452,7 @@ auto HtmlWriter::Wrap::pushMessage(
 	}
 	if (!message.signature.isEmpty()) {
 		block.append(pushDiv("signature details"));
-		block.append(SerializeString(message.signature));
+		AppendEscapedHtml(block, message.signature);
 		block.append(popTag());
 	}
 	if (showForwardedInfo) {
@@ -1602,17 +1560,17 @@ QByteArray HtmlWriter::Wrap::pushGenericMedia(const MediaData &data) {
 	result.append(pushDiv("body"));
 	if (!data.title.isEmpty()) {
 		result.append(pushDiv("title bold"));
-		result.append(SerializeString(data.title));
+		AppendEscapedHtml(result, data.title);
 		result.append(popTag());
 	}
 	if (!data.description.isEmpty()) {
 		result.append(pushDiv("description"));
-		result.append(SerializeString(data.description));
+		AppendEscapedHtml(result, data.description);
 		result.append(popTag());
 	}
 	if (!data.status.isEmpty()) {
 		result.append(pushDiv("status details"));
-		result.append(SerializeString(data.status));
+		AppendEscapedHtml(result, data.status);
 		result.append(popTag());
 	}
 	result.append(popTag());
@@ -1845,13 +1803,13 @@ QByteArray HtmlWriter::Wrap::pushPoll(const Data::Poll &data) {
 	auto result = pushDiv("media_wrap clearfix");
 	result.append(pushDiv("media_poll"));
 	result.append(pushDiv("question bold"));
-	result.append(SerializeString(data.question));
+	AppendEscapedHtml(result, data.question);
 	result.append(popTag());
 	result.append(pushDiv("details"));
 	if (data.closed) {
-		result.append(SerializeString("Final results"));
+		AppendEscapedHtml(result, "Final results");
 	} else {
-		result.append(SerializeString("Anonymous poll"));
+		AppendEscapedHtml(result, "Anonymous poll");
 	}
 	result.append(popTag());
 	const auto votes = [](int count) {
@@ -1894,7 +1852,7 @@ QByteArray HtmlWriter::Wrap::pushGiveaway(
 	result.append(pushDiv("media_giveaway"));
 
 	result.append(pushDiv("section_title bold"));
-	result.append(SerializeString("Giveaway Prizes"));
+	AppendEscapedHtml(result, "Giveaway Prizes");
 	result.append(popTag());
 	result.append(pushDiv("section_body"));
 	result.append("<b>"
@@ -1908,7 +1866,7 @@ QByteArray HtmlWriter::Wrap::pushGiveaway(
 	result.append(popTag());
 
 	result.append(pushDiv("section_title bold"));
-	result.append(SerializeString("Participants"));
+	AppendEscapedHtml(result, "Participants");
 	result.append(popTag());
 	result.append(pushDiv("section_body"));
 	auto channels = QByteArrayList();
@@ -1922,7 +1880,7 @@ QByteArray HtmlWriter::Wrap::pushGiveaway(
 	result.append(popTag());
 
 	result.append(pushDiv("section_title bold"));
-	result.append(SerializeString("Winners Selection Date"));
+	AppendEscapedHtml(result, "Winners Selection Date");
 	result.append(popTag());
 	result.append(pushDiv("section_body"));
 	result.append(Data::FormatDateTime(data.untilDate));
@@ -2303,10 +2261,10 @@ Result HtmlWriter::writePreparedPersonal(
 			}
 			block.append(_summary->pushDiv("row"));
 			block.append(_summary->pushDiv("label details"));
-			block.append(SerializeString(key));
+			AppendEscapedHtml(block, key);
 			block.append(_summary->popTag());
 			block.append(_summary->pushDiv("value bold"));
-			block.append(SerializeString(value));
+			AppendEscapedHtml(block, value);
 			block.append(_summary->popTag());
 			block.append(_summary->popTag());
 		}
@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "export/output/export_output_json.h"
 
+#include "export/output/export_output_escape.h"
 #include "export/output/export_output_result.h"
 #include "export/data/export_data_types.h"
 #include "core/utils.h"
@@ -24,48 +25,9 @@ namespace {
 using Context = details::JsonContext;
 
 QByteArray SerializeString(const QByteArray &value) {
-	const auto size = value.size();
-	const auto begin = value.data();
-	const auto end = begin + size;
-
 	auto result = QByteArray();
-	result.reserve(2 + size * 4);
-	result.append('"');
-	for (auto p = begin; p != end; ++p) {
-		const auto ch = *p;
-		if (ch == '\n') {
-			result.append("\\n", 2);
-		} else if (ch == '\r') {
-			result.append("\\r", 2);
-		} else if (ch == '\t') {
-			result.append("\\t", 2);
-		} else if (ch == '"') {
-			result.append("\\\"", 2);
-		} else if (ch == '\\') {
-			result.append("\\\\", 2);
-		} else if (ch >= 0 && ch < 32) {
-			result.append("\\x", 2).append('0' + (ch >> 4));
-			const auto left = (ch & 0x0F);
-			if (left >= 10) {
-				result.append('A' + (left - 10));
-			} else {
-				result.append('0' + left);
-			}
-		} else if (ch == char(0xE2)
-			&& (p + 2 < end)
-			&& *(p + 1) == char(0x80)) {
-			if (*(p + 2) == char(0xA8)) { // Line separator.
-				result.append("\\u2028", 6);
-			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
-				result.append("\\u2029", 6);
-			} else {
-				result.append(ch);
-			}
-		} else {
-			result.append(ch);
-		}
-	}
-	result.append('"');
+	result.reserve(value.size() + 2);
+	AppendEscapedJson(result, value);
 	return result;
 }
 
@@ -103,8 +65,15 @@ QByteArray SerializeObject(
 	const auto guard = gsl::finally([&] { context.nesting.pop_back(); });
 	const auto next = '\n' + Indentation(context);
 
+	// Keys are plain identifiers, so they almost never need escaping.
+	auto size = indent.size() + 3;
+	for (const auto &[key, value] : values) {
+		size += next.size() + key.size() + value.size() + 5;
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('{');
 	for (const auto &[key, value] : values) {
 		if (value.isEmpty()) {
@@ -115,7 +84,9 @@ QByteArray SerializeObject(
 		} else {
 			result.append(',');
 		}
-		result.append(next).append(SerializeString(key)).append(": ", 2);
+		result.append(next);
+		AppendEscapedJson(result, key);
+		result.append(": ", 2);
 		result.append(value);
 	}
 	result.append('\n').append(indent).append("}");
@@ -128,8 +99,14 @@ QByteArray SerializeArray(
 	const auto indent = Indentation(context.nesting.size());
 	const auto next = '\n' + Indentation(context.nesting.size() + 1);
 
+	auto size = indent.size() + 3;
+	for (const auto &value : values) {
+		size += next.size() + value.size() + 1;
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('[');
 	for (const auto &value : values) {
 		if (first) {
@@ -867,7 +844,7 @@ Result JsonWriter::start(
 	}
 	auto block = pushNesting(Context::kObject);
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(_environment.aboutTelegram));
+	AppendEscapedJson(block, _environment.aboutTelegram);
 	return _output->writeBlock(block);
 }
 
@@ -1078,7 +1055,7 @@ Result JsonWriter::writeSavedContacts(const Data::ContactsList &data) {
 	auto block = prepareObjectItemStart("contacts");
 	block.append(pushNesting(Context::kObject));
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(_environment.aboutContacts));
+	AppendEscapedJson(block, _environment.aboutContacts);
 	block.append(prepareObjectItemStart("list"));
 	block.append(pushNesting(Context::kArray));
 	for (const auto index : Data::SortedContactsIndices(data)) {
@@ -1122,7 +1099,7 @@ Result JsonWriter::writeFrequentContacts(const Data::ContactsList &data) {
 	auto block = prepareObjectItemStart("frequent_contacts");
 	block.append(pushNesting(Context::kObject));
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(_environment.aboutFrequent));
+	AppendEscapedJson(block, _environment.aboutFrequent);
 	block.append(prepareObjectItemStart("list"));
 	block.append(pushNesting(Context::kArray));
 	const auto writeList = [&](
@@ -1248,7 +1225,7 @@ Result JsonWriter::writeSessions(const Data::SessionsList &data) {
 	auto block = prepareObjectItemStart("sessions");
 	block.append(pushNesting(Context::kObject));
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(_environment.aboutSessions));
+	AppendEscapedJson(block, _environment.aboutSessions);
 	block.append(prepareObjectItemStart("list"));
 	block.append(pushNesting(Context::kArray));
 	for (const auto &session : data.list) {
@@ -1284,7 +1261,7 @@ Result JsonWriter::writeWebSessions(const Data::SessionsList &data) {
 	auto block = prepareObjectItemStart("web_sessions");
 	block.append(pushNesting(Context::kObject));
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(_environment.aboutWebSessions));
+	AppendEscapedJson(block, _environment.aboutWebSessions);
 	block.append(prepareObjectItemStart("list"));
 	block.append(pushNesting(Context::kArray));
 	for (const auto &session : data.webList) {
@@ -1412,7 +1389,7 @@ Result JsonWriter::writeChatsStart(
 	auto block = prepareObjectItemStart(listName);
 	block.append(pushNesting(Context::kObject));
 	block.append(prepareObjectItemStart("about"));
-	block.append(SerializeString(about));
+	AppendEscapedJson(block, about);
 	block.append(prepareObjectItemStart("list"));
 	return _output->writeBlock(block + pushNesting(Context::kArray));
 }
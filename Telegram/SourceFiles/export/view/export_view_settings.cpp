@@ -253,6 +253,30 @@ void SettingsWidget::setupOtherOptions(
 		tr::lng_export_option_other(tr::now),
 		Type::OtherData,
 		tr::lng_export_option_other_about(tr::now));
+	addDeltaOption(container);
+}
+
+void SettingsWidget::addDeltaOption(
+		not_null<Ui::VerticalLayout*> container) {
+	const auto checkbox = container->add(
+		object_ptr<Ui::Checkbox>(
+			container,
+			tr::lng_export_option_delta(tr::now),
+			readData().delta,
+			st::defaultBoxCheckbox),
+		st::exportSettingPadding);
+	checkbox->checkedChanges(
+	) | rpl::start_with_next([=](bool checked) {
+		changeData([&](Settings &data) {
+			data.delta = checked;
+		});
+	}, checkbox->lifetime());
+	container->add(
+		object_ptr<Ui::FlatLabel>(
+			container,
+			tr::lng_export_option_delta_about(tr::now),
+			st::exportAboutOptionLabel),
+		st::exportAboutOptionPadding);
 }
 
 void SettingsWidget::setupPathAndFormat(
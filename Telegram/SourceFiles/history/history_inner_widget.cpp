@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "core/file_utilities.h"
 #include "core/click_handler_types.h"
+#include "core/core_trace.h"
 #include "history/history_item_helpers.h"
 #include "history/view/controls/history_view_forward_panel.h"
 #include "history/view/controls/history_view_draft_options.h"
@@ -895,6 +896,7 @@ Ui::ChatPaintContext HistoryInner::preparePaintContext(
 }
 
 void HistoryInner::paintEvent(QPaintEvent *e) {
+	const auto trace = Core::Trace::Scope("HistoryInner::paintEvent");
 	if (_controller->contentOverlapped(this, e)
 		|| hasPendingResizedItems()) {
 		return;
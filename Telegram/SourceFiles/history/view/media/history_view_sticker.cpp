@@ -137,6 +137,15 @@ bool Sticker::emojiSticker() const {
 	return _emojiSticker;
 }
 
+bool Sticker::playOnce() const {
+	return (_diceIndex > 0)
+		? true
+		: (_diceIndex == 0)
+		? false
+		: ((!customEmojiPart() && emojiSticker())
+			|| !Core::App().settings().loopAnimatedStickers());
+}
+
 void Sticker::initSize(int customSize) {
 	if (customSize > 0) {
 		const auto original = Size(_data);
@@ -296,12 +305,7 @@ void Sticker::paintAnimationFrame(
 	_nextLastDiceFrame = !paused
 		&& (_diceIndex > 0)
 		&& (_frameIndex + 2 == count);
-	const auto playOnce = (_diceIndex > 0)
-		? true
-		: (_diceIndex == 0)
-		? false
-		: ((!customEmojiPart() && emojiSticker())
-			|| !Core::App().settings().loopAnimatedStickers());
+	const auto playOnce = this->playOnce();
 	const auto lastDiceFrame = (_diceIndex > 0) && atTheEnd();
 	const auto switchToNext = !playOnce
 		|| (!lastDiceFrame && (_frameIndex != 0 || !_oncePlayed));
@@ -517,13 +521,29 @@ void Sticker::setupPlayer() {
 	Expects(_dataMedia != nullptr);
 
 	if (_data->sticker()->isLottie()) {
-		_player = std::make_unique<LottiePlayer>(
-			ChatHelpers::LottiePlayerFromDocument(
+		const auto box = countOptimalSize() * style::DevicePixelRatio();
+		auto create = [=] {
+			return ChatHelpers::LottiePlayerFromDocument(
 				_dataMedia.get(),
 				_replacements,
 				_cachingTag,
-				countOptimalSize() * style::DevicePixelRatio(),
-				Lottie::Quality::High));
+				box,
+				Lottie::Quality::High);
+		};
+		if (_diceIndex < 0 && !playOnce()) {
+			// Views that stop after one loop need a player of their own.
+			_player = std::make_unique<SharedLottiePlayer>(
+				SharedLottiePlayer::Key{
+					.document = _data,
+					.replacements = _replacements,
+					.width = box.width(),
+					.height = box.height(),
+					.sizeTag = uint8(_cachingTag),
+				},
+				std::move(create));
+		} else {
+			_player = std::make_unique<LottiePlayer>(create());
+		}
 	} else if (_data->sticker()->isWebm()) {
 		_player = std::make_unique<WebmPlayer>(
 			_dataMedia->owner()->location(),
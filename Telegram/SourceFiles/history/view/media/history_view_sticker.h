@@ -98,6 +98,7 @@ private:
 	[[nodiscard]] bool hasPremiumEffect() const;
 	[[nodiscard]] bool customEmojiPart() const;
 	[[nodiscard]] bool emojiSticker() const;
+	[[nodiscard]] bool playOnce() const;
 	void paintAnimationFrame(
 		Painter &p,
 		const PaintContext &context,
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/media/history_view_sticker_player.h"
 
 #include "core/file_location.h"
+#include "ui/image/image_prepare.h"
 
 namespace HistoryView {
 namespace {
@@ -58,6 +59,92 @@ bool LottiePlayer::markFrameShown() {
 	return _lottie->markFrameShown();
 }
 
+SharedLottiePlayer::Shared::~Shared() {
+	Registry().remove(key);
+}
+
+auto SharedLottiePlayer::Registry()
+-> base::flat_map<Key, std::weak_ptr<Shared>> & {
+	static auto result = base::flat_map<Key, std::weak_ptr<Shared>>();
+	return result;
+}
+
+SharedLottiePlayer::SharedLottiePlayer(
+		Key key,
+		FnMut<std::unique_ptr<Lottie::SinglePlayer>()> create) {
+	auto &registry = Registry();
+	if (const auto i = registry.find(key); i != end(registry)) {
+		_shared = i->second.lock();
+	}
+	if (!_shared) {
+		_shared = std::make_shared<Shared>();
+		_shared->key = key;
+		_shared->lottie = create();
+		registry[key] = _shared;
+	}
+}
+
+void SharedLottiePlayer::setRepaintCallback(Fn<void()> callback) {
+	_repaintLifetime = _shared->lottie->updates(
+	) | rpl::start_with_next([=](Lottie::Update) {
+		callback();
+	});
+}
+
+bool SharedLottiePlayer::ready() {
+	return _shared->lottie->ready();
+}
+
+int SharedLottiePlayer::framesCount() {
+	return _shared->lottie->information().framesCount;
+}
+
+SharedLottiePlayer::FrameInfo SharedLottiePlayer::frame(
+		QSize size,
+		QColor colored,
+		bool mirrorHorizontal,
+		crl::time now,
+		bool paused) {
+	// The shared player renders plain frames, views of the same sticker
+	// may be selected or mirrored independently of each other.
+	auto request = Lottie::FrameRequest();
+	request.box = size * style::DevicePixelRatio();
+	const auto info = _shared->lottie->frameInfo(request);
+	_frameIndex = info.index;
+	const auto colorize = (colored.alpha() != 0);
+	if (!colorize && !mirrorHorizontal) {
+		_transformed = QImage();
+		return { .image = info.image, .index = info.index };
+	}
+	const auto key = info.image.cacheKey();
+	if (_transformed.isNull()
+		|| _transformedFrom != key
+		|| _transformedColored != colored
+		|| _transformedMirrored != mirrorHorizontal) {
+		auto image = mirrorHorizontal
+			? info.image.mirrored(true, false)
+			: info.image;
+		_transformed = colorize
+			? Images::Colored(std::move(image), colored)
+			: std::move(image);
+		_transformedFrom = key;
+		_transformedColored = colored;
+		_transformedMirrored = mirrorHorizontal;
+	}
+	return { .image = _transformed, .index = info.index };
+}
+
+bool SharedLottiePlayer::markFrameShown() {
+	// Only the first of the views showing this frame moves the player on.
+	if (_shared->markedIndex == _frameIndex) {
+		return false;
+	} else if (!_shared->lottie->markFrameShown()) {
+		return false;
+	}
+	_shared->markedIndex = _frameIndex;
+	return true;
+}
+
 WebmPlayer::WebmPlayer(
 	const Core::FileLocation &location,
 	const QByteArray &data,
@@ -39,6 +39,58 @@ private:
 
 };
 
+// Looping players of the same sticker in the same size share a single
+// Lottie::SinglePlayer, so each frame is rendered once for all of them.
+// The selection overlay and the mirroring are applied by each view.
+class SharedLottiePlayer final : public StickerPlayer {
+public:
+	struct Key {
+		DocumentData *document = nullptr;
+		const Lottie::ColorReplacements *replacements = nullptr;
+		int width = 0;
+		int height = 0;
+		uint8 sizeTag = 0;
+
+		friend inline auto operator<=>(const Key &, const Key &) = default;
+		friend inline bool operator==(const Key &, const Key &) = default;
+	};
+	SharedLottiePlayer(
+		Key key,
+		FnMut<std::unique_ptr<Lottie::SinglePlayer>()> create);
+
+	void setRepaintCallback(Fn<void()> callback) override;
+	bool ready() override;
+	int framesCount() override;
+	FrameInfo frame(
+		QSize size,
+		QColor colored,
+		bool mirrorHorizontal,
+		crl::time now,
+		bool paused) override;
+	bool markFrameShown() override;
+
+private:
+	struct Shared {
+		~Shared();
+
+		Key key;
+		std::unique_ptr<Lottie::SinglePlayer> lottie;
+		int markedIndex = -1;
+	};
+
+	[[nodiscard]] static auto Registry()
+	-> base::flat_map<Key, std::weak_ptr<Shared>> &;
+
+	std::shared_ptr<Shared> _shared;
+	int _frameIndex = -1;
+	QImage _transformed;
+	qint64 _transformedFrom = 0;
+	QColor _transformedColored;
+	bool _transformedMirrored = false;
+	rpl::lifetime _repaintLifetime;
+
+};
+
 class WebmPlayer final : public StickerPlayer {
 public:
 	WebmPlayer(
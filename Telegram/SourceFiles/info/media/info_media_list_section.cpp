@@ -217,6 +217,24 @@ const ListSection::Items &ListSection::items() const {
 	return _items;
 }
 
+void ListSection::enumerateItemsInRange(
+		int top,
+		int bottom,
+		Fn<void(not_null<BaseLayout*>)> callback) const {
+	if (!_mosaic.empty()) {
+		const auto clip = QRect(0, top, QWIDGETSIZE_MAX, bottom - top);
+		_mosaic.paint([&](not_null<BaseLayout*> item, QPoint point) {
+			callback(item);
+		}, clip);
+		return;
+	}
+	const auto fromIt = findItemAfterTop(top);
+	const auto tillIt = findItemAfterBottom(fromIt, bottom);
+	for (auto it = fromIt; it != tillIt; ++it) {
+		callback(*it);
+	}
+}
+
 void ListSection::paint(
 		Painter &p,
 		const ListContext &context,
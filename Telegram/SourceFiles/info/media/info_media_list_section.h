@@ -41,6 +41,12 @@ public:
 	using Items = std::vector<not_null<BaseLayout*>>;
 	const Items &items() const;
 
+	// Range is in section coordinates, like the paint() clip.
+	void enumerateItemsInRange(
+		int top,
+		int bottom,
+		Fn<void(not_null<BaseLayout*>)> callback) const;
+
 	void paint(
 		Painter &p,
 		const ListContext &context,
@@ -628,6 +628,7 @@ void ListWidget::visibleTopBottomUpdated(
 
 	checkMoveToOtherViewer();
 	clearHeavyItems();
+	preparePreviewsAround();
 
 	if (_dateBadge->goodType) {
 		updateDateBadgeFor(_visibleTop);
@@ -732,6 +733,25 @@ void ListWidget::clearHeavyItems() {
 	}
 }
 
+void ListWidget::preparePreviewsAround() {
+	const auto visibleHeight = _visibleBottom - _visibleTop;
+	if (!visibleHeight) {
+		return;
+	}
+	// Stay inside the area where clearHeavyItems() keeps the items.
+	const auto above = _visibleTop - visibleHeight / 2;
+	const auto below = _visibleBottom + visibleHeight;
+	const auto fromSectionIt = findSectionAfterTop(above);
+	const auto tillSectionIt = findSectionAfterBottom(fromSectionIt, below);
+	for (auto it = fromSectionIt; it != tillSectionIt; ++it) {
+		const auto top = it->top();
+		it->enumerateItemsInRange(
+			above - top,
+			below - top,
+			[](not_null<BaseLayout*> item) { item->preparePreview(); });
+	}
+}
+
 ListScrollTopState ListWidget::countScrollState() const {
 	if (_sections.empty() || _visibleTop <= 0) {
 		return {};
@@ -265,6 +265,7 @@ private:
 	void validateTrippleClickStartTime();
 	void checkMoveToOtherViewer();
 	void clearHeavyItems();
+	void preparePreviewsAround();
 
 	void setActionBoxWeak(QPointer<Ui::BoxContent> box);
 
@@ -12,8 +12,23 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/launcher.h"
 #include "mtproto/facade.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#endif // !Q_OS_WIN
+
 namespace {
 
+// Debug / tcp / mtp lines are pushed to per-thread rings and written
+// by a background thread, so that the MTP and main threads don't
+// contend on file mutexes and don't flush the file on every line.
+constexpr auto kAsyncRingSize = uint32(4096); // Must be a power of two.
+constexpr auto kAsyncWakeThreshold = kAsyncRingSize / 2;
+constexpr auto kAsyncFlushInterval = std::chrono::milliseconds(250);
+
 std::atomic<int> ThreadCounter/* = 0*/;
 thread_local bool WritingEntryFlag/* = false*/;
 
@@ -111,6 +126,10 @@ public:
 	}
 
 	void write(LogDataType type, const QString &msg) {
+		write(type, msg.toUtf8());
+	}
+
+	void write(LogDataType type, const QByteArray &data) {
 		QMutexLocker lock(_logsMutex(type));
 		WritingEntryScope scope;
 
@@ -121,10 +140,37 @@ public:
 		if (!file || !file->isOpen()) {
 			return;
 		}
-		file->write(msg.toUtf8());
+		file->write(data);
 		file->flush();
 	}
 
+#ifndef Q_OS_WIN
+	// Called from the crash handler, so it doesn't allocate and doesn't
+	// wait for the mutex. Files are flushed after each write, so there is
+	// nothing left in the QFile buffers to be written before this.
+	void writeCrashing(LogDataType type, const QByteArray &data) {
+		const auto mutex = _logsMutex(type);
+		if (!mutex->tryLock()) {
+			return;
+		}
+		const auto file = files[type].get();
+		if (file && file->isOpen()) {
+			const auto handle = file->handle();
+			auto from = data.constData();
+			auto left = data.size();
+			while (handle >= 0 && left > 0) {
+				const auto written = ::write(handle, from, left);
+				if (written <= 0) {
+					break;
+				}
+				from += written;
+				left -= written;
+			}
+		}
+		mutex->unlock();
+	}
+#endif // !Q_OS_WIN
+
 private:
 	std::unique_ptr<QFile> files[LogDataCount];
 
@@ -253,6 +299,243 @@ NEW LOGGING INSTANCE STARTED!!!\n\
 
 LogsDataFields *LogsData = 0;
 
+// Single producer (the owning thread), single consumer (the writer).
+class LogsRing final {
+public:
+	bool push(LogDataType type, QByteArray &&data) {
+		const auto tail = _tail.load(std::memory_order_relaxed);
+		const auto head = _head.load(std::memory_order_acquire);
+		if (tail - head >= kAsyncRingSize) {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		auto &entry = _entries[tail & (kAsyncRingSize - 1)];
+		entry.type = type;
+		entry.data = std::move(data);
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	[[nodiscard]] uint32 size() const {
+		return _tail.load(std::memory_order_acquire)
+			- _head.load(std::memory_order_acquire);
+	}
+
+	template <typename Callback>
+	void drain(Callback &&callback) {
+		auto head = _head.load(std::memory_order_relaxed);
+		const auto tail = _tail.load(std::memory_order_acquire);
+		for (; head != tail; ++head) {
+			auto &entry = _entries[head & (kAsyncRingSize - 1)];
+			callback(entry.type, entry.data);
+			entry.data = QByteArray();
+			_head.store(head + 1, std::memory_order_release);
+		}
+	}
+
+	// Doesn't release the entries, used only from the crash handler.
+	template <typename Callback>
+	void peek(Callback &&callback) const {
+		const auto tail = _tail.load(std::memory_order_acquire);
+		auto head = _head.load(std::memory_order_acquire);
+		for (; head != tail; ++head) {
+			const auto &entry = _entries[head & (kAsyncRingSize - 1)];
+			callback(entry.type, entry.data);
+		}
+	}
+
+	[[nodiscard]] int takeDropped() {
+		return _dropped.exchange(0, std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry {
+		LogDataType type = LogDataMain;
+		QByteArray data;
+	};
+
+	std::array<Entry, kAsyncRingSize> _entries;
+	std::atomic<uint32> _head = 0;
+	std::atomic<uint32> _tail = 0;
+	std::atomic<int> _dropped = 0;
+
+};
+
+class LogsAsyncWriter final {
+public:
+	LogsAsyncWriter();
+	~LogsAsyncWriter();
+
+	void push(LogDataType type, QByteArray &&data);
+
+	// Writes everything collected so far from the calling thread.
+	void flush();
+
+	// Joins the writer thread and writes what is left.
+	void stop();
+
+#ifndef Q_OS_WIN
+	// Only try-locks and writes already formatted lines with write(2).
+	// Gives up if the crash happened while any of the locks was held.
+	void writeCrashing();
+#endif // !Q_OS_WIN
+
+private:
+	struct Rings {
+		std::mutex mutex;
+		std::vector<std::shared_ptr<LogsRing>> list;
+	};
+	[[nodiscard]] static Rings &AllRings();
+	[[nodiscard]] static not_null<LogsRing*> ThreadRing();
+
+	void run();
+	void wake();
+	void drainLocked();
+
+	std::mutex _drainMutex;
+	std::array<QByteArray, LogDataCount> _batches;
+	int64 _droppedTotal = 0;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _wakeRequested = false;
+	bool _stopping = false;
+	std::thread _thread;
+
+};
+
+LogsAsyncWriter::LogsAsyncWriter()
+: _thread([=] { run(); }) {
+}
+
+LogsAsyncWriter::~LogsAsyncWriter() {
+	stop();
+}
+
+void LogsAsyncWriter::stop() {
+	{
+		auto lock = std::unique_lock(_mutex);
+		if (_stopping) {
+			return;
+		}
+		_stopping = true;
+	}
+	_condition.notify_one();
+	_thread.join();
+	flush();
+}
+
+auto LogsAsyncWriter::AllRings() -> Rings & {
+	static auto result = Rings();
+	return result;
+}
+
+not_null<LogsRing*> LogsAsyncWriter::ThreadRing() {
+	static thread_local auto ring = std::shared_ptr<LogsRing>();
+	if (!ring) {
+		ring = std::make_shared<LogsRing>();
+
+		auto &rings = AllRings();
+		auto lock = std::unique_lock(rings.mutex);
+		rings.list.push_back(ring);
+	}
+	return ring.get();
+}
+
+void LogsAsyncWriter::push(LogDataType type, QByteArray &&data) {
+	const auto ring = ThreadRing();
+	if (ring->push(type, std::move(data))
+		&& ring->size() == kAsyncWakeThreshold) {
+		wake();
+	}
+}
+
+void LogsAsyncWriter::wake() {
+	{
+		auto lock = std::unique_lock(_mutex);
+		_wakeRequested = true;
+	}
+	_condition.notify_one();
+}
+
+void LogsAsyncWriter::run() {
+	auto lock = std::unique_lock(_mutex);
+	while (!_stopping) {
+		_condition.wait_for(lock, kAsyncFlushInterval, [&] {
+			return _stopping || _wakeRequested;
+		});
+		_wakeRequested = false;
+
+		lock.unlock();
+		flush();
+		lock.lock();
+	}
+}
+
+void LogsAsyncWriter::flush() {
+	auto lock = std::unique_lock(_drainMutex);
+	drainLocked();
+}
+
+#ifndef Q_OS_WIN
+void LogsAsyncWriter::writeCrashing() {
+	auto lock = std::unique_lock(_drainMutex, std::try_to_lock);
+	if (!lock.owns_lock() || !LogsData) {
+		return;
+	}
+	auto &rings = AllRings();
+	auto ringsLock = std::unique_lock(rings.mutex, std::try_to_lock);
+	if (!ringsLock.owns_lock()) {
+		return;
+	}
+	for (const auto &ring : rings.list) {
+		ring->peek([&](LogDataType type, const QByteArray &data) {
+			LogsData->writeCrashing(type, data);
+		});
+	}
+}
+#endif // !Q_OS_WIN
+
+void LogsAsyncWriter::drainLocked() {
+	auto dropped = 0;
+	{
+		auto &rings = AllRings();
+		auto lock = std::unique_lock(rings.mutex);
+		for (auto i = begin(rings.list); i != end(rings.list);) {
+			const auto ring = i->get();
+			ring->drain([&](LogDataType type, const QByteArray &data) {
+				_batches[type].append(data);
+			});
+			dropped += ring->takeDropped();
+
+			// The owning thread has finished and everything is drained.
+			if (i->use_count() == 1 && !ring->size()) {
+				i = rings.list.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+	if (dropped > 0) {
+		_droppedTotal += dropped;
+		_batches[LogDataDebug].append(QString(
+			"[LOGS] %1 debug entries dropped, %2 in total.\n"
+		).arg(dropped).arg(_droppedTotal).toUtf8());
+	}
+	for (auto type = 0; type != LogDataCount; ++type) {
+		auto &batch = _batches[type];
+		if (batch.isEmpty()) {
+			continue;
+		} else if (LogsData) {
+			LogsData->write(LogDataType(type), batch);
+		}
+		batch.clear();
+	}
+}
+
+// Other threads read it while finish() takes it away.
+std::atomic<LogsAsyncWriter*> LogsWriter = nullptr;
+
 using LogsInMemoryList = QList<QPair<LogDataType, QString>>;
 LogsInMemoryList *LogsInMemory = 0;
 LogsInMemoryList *DeletedLogsInMemory = SharedMemoryLocation<LogsInMemoryList, 0>();
@@ -261,8 +544,14 @@ QString LogsBeforeSingleInstanceChecked; // LogsInMemory already dumped in LogsD
 
 void _logsWrite(LogDataType type, const QString &msg) {
 	if (LogsData && (type == LogDataMain || LogsStartIndexChosen < 0)) {
-		if (type == LogDataMain || Logs::DebugEnabled()) {
+		if (type == LogDataMain) {
 			LogsData->write(type, msg);
+		} else if (Logs::DebugEnabled()) {
+			if (const auto writer = LogsWriter.load()) {
+				writer->push(type, msg.toUtf8());
+			} else {
+				LogsData->write(type, msg);
+			}
 		}
 	} else if (LogsInMemory != DeletedLogsInMemory) {
 		if (!LogsInMemory) {
@@ -424,6 +713,12 @@ void start() {
 }
 
 void finish() {
+	if (const auto writer = LogsWriter.exchange(nullptr)) {
+		// Don't delete it, some thread may be inside push() right now.
+		// Lines pushed after the stop are lost, as any after finish().
+		writer->stop();
+	}
+
 	delete LogsData;
 	LogsData = 0;
 
@@ -468,6 +763,10 @@ bool instanceChecked() {
 	}
 	LogsInMemory = DeletedLogsInMemory;
 
+	if (!LogsWriter.load()) {
+		LogsWriter = new LogsAsyncWriter();
+	}
+
 	DEBUG_LOG(("Debug logs started."));
 	LogsBeforeSingleInstanceChecked.clear();
 	return true;
@@ -488,11 +787,26 @@ void multipleInstances() {
 
 void closeMain() {
 	LOG(("Explicitly closing main log and finishing crash handlers."));
+	flushPending();
 	if (LogsData) {
 		LogsData->closeMain();
 	}
 }
 
+void flushPending() {
+	if (const auto writer = LogsWriter.load()) {
+		writer->flush();
+	}
+}
+
+void writePendingOnCrash() {
+#ifndef Q_OS_WIN
+	if (const auto writer = LogsWriter.load()) {
+		writer->writeCrashing();
+	}
+#endif // !Q_OS_WIN
+}
+
 void writeMain(const QString &v) {
 	time_t t = time(NULL);
 	struct tm tm;
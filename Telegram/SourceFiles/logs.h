@@ -26,6 +26,12 @@ void multipleInstances();
 
 void closeMain();
 
+// Debug logs are written in batches from a background thread.
+void flushPending();
+
+// For the crash handler, never blocks or allocates, may write nothing.
+void writePendingOnCrash();
+
 void writeMain(const QString &v);
 void writeDebug(const QString &v);
 void writeTcp(const QString &v);
@@ -42,6 +42,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "lang/lang_keys.h"
 #include "core/application.h"
 #include "ui/text/text_utilities.h"
+#include "ui/userpic_view.h"
 #include "ui/layers/generic_box.h"
 #include "styles/style_layers.h"
 
@@ -236,7 +237,10 @@ void Session::notifyDownloaderTaskFinished() {
 }
 
 rpl::producer<> Session::downloaderTaskFinished() const {
-	return downloader().taskFinished();
+	// Views that wait for loaded userpics also wait for scaled ones.
+	return rpl::merge(
+		downloader().taskFinished(),
+		Ui::SharedUserpicsPrepared());
 }
 
 bool Session::premium() const {
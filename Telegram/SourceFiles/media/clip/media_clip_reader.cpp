@@ -36,6 +36,11 @@ namespace {
 constexpr auto kClipThreadsCount = 8;
 constexpr auto kAverageGifSize = 320 * 240;
 constexpr auto kWaitBeforeGifPause = crl::time(200);
+constexpr auto kMaxSharedReaders = 64;
+constexpr auto kMaxSharedReaderData = 4 * 1024 * 1024;
+
+using SharedReaderKey = std::pair<uint64, int>;
+base::flat_map<SharedReaderKey, std::weak_ptr<SharedReader>> SharedReaders;
 
 QImage PrepareFrame(
 		const FrameRequest &request,
@@ -1005,7 +1010,50 @@ Ui::PreparedFileInformation PrepareForSending(
 	return { .media = result };
 }
 
+SharedReader::SharedReader(const QByteArray &data)
+: _reader(MakeReader(data, [=](Notification notification) {
+	callback(notification);
+})) {
+}
+
+void SharedReader::callback(Notification notification) {
+	if (notification == Notification::Reinit
+		&& _reader
+		&& _reader->state() == State::Error) {
+		_reader.setBad();
+	}
+	_notifications.fire_copy(notification);
+}
+
+std::shared_ptr<SharedReader> MakeSharedReader(
+		uint64 key,
+		int size,
+		const QByteArray &data) {
+	const auto index = SharedReaderKey(key, size);
+	if (const auto i = SharedReaders.find(index); i != end(SharedReaders)) {
+		if (auto result = i->second.lock()) {
+			return result;
+		}
+	}
+	auto result = std::make_shared<SharedReader>(data);
+	if (data.size() > kMaxSharedReaderData) {
+		return result;
+	}
+	for (auto i = begin(SharedReaders); i != end(SharedReaders);) {
+		if (i->second.expired()) {
+			i = SharedReaders.erase(i);
+		} else {
+			++i;
+		}
+	}
+	if (SharedReaders.size() < kMaxSharedReaders) {
+		SharedReaders.emplace_or_assign(index, result);
+	}
+	return result;
+}
+
 void Finish() {
+	SharedReaders.clear();
 	Workers.clear();
 }
 
@@ -239,6 +239,39 @@ inline ReaderPointer MakeReader(Args&&... args) {
 	return ReaderPointer(new Reader(std::forward<Args>(args)...));
 }
 
+// One reader with its decoded frames for all views of the same clip.
+class SharedReader final {
+public:
+	explicit SharedReader(const QByteArray &data);
+
+	[[nodiscard]] Reader *get() const {
+		return _reader.get();
+	}
+	[[nodiscard]] bool isBad() const {
+		return _reader.isBad();
+	}
+	[[nodiscard]] rpl::producer<Notification> notifications() const {
+		return _notifications.events();
+	}
+
+private:
+	void callback(Notification notification);
+
+	ReaderPointer _reader;
+	rpl::event_stream<Notification> _notifications;
+
+};
+
+// Views asking for the same content key and frame size share the reader.
+// Only small clips are shared and only a limited number of them at once.
+// Used for dialog video userpics. Streamed GIFs and videos in messages
+// don't need it: they share Streaming::Document per document already,
+// with a prepared frame per distinct request.
+[[nodiscard]] std::shared_ptr<SharedReader> MakeSharedReader(
+	uint64 key,
+	int size,
+	const QByteArray &data);
+
 [[nodiscard]] Ui::PreparedFileInformation PrepareForSending(
 	const QString &fname,
 	const QByteArray &data);
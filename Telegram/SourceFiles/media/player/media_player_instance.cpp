@@ -52,6 +52,9 @@ constexpr auto kRememberShuffledOrderItems = 16;
 
 constexpr auto kMinLengthForSavePosition = 20 * TimeId(60); // 20 minutes.
 
+// Open the next track when the current one is that close to end.
+constexpr auto kPreloadNextBefore = 20 * crl::time(1000);
+
 base::options::toggle OptionDisableAutoplayNext({
 	.id = kOptionDisableAutoplayNext,
 	.name = "Disable auto-play of the next track",
@@ -219,6 +222,7 @@ void Instance::setCurrent(const AudioMsgId &audioId) {
 		}
 		data->current = audioId;
 		data->isPlaying = false;
+		clearPreloadedNext(data);
 
 		const auto item = (audioId.audio() && audioId.contextId())
 			? audioId.audio()->owner().message(audioId.contextId())
@@ -597,6 +601,93 @@ bool Instance::moveInPlaylist(
 	return false;
 }
 
+HistoryItem *Instance::nextItemToPreload(not_null<Data*> data) {
+	if (!data->playlistIndex || !data->playlistSlice) {
+		return nullptr;
+	} else if (order(data) == OrderMode::Shuffle) {
+		// Only the already decided next track, without picking a new one.
+		const auto raw = data->shuffleData.get();
+		if (!raw
+			|| !raw->history
+			|| raw->indexInPlayedIds + 1 >= raw->playedIds.size()) {
+			return nullptr;
+		}
+		const auto universal = raw->playedIds[raw->indexInPlayedIds + 1];
+		return raw->history->owner().message((universal < 0 && raw->migrated)
+			? FullMsgId(raw->migrated->peer->id, universal + ServerMaxMsgId)
+			: FullMsgId(raw->history->peer->id, universal));
+	}
+	const auto &slice = *data->playlistSlice;
+	const auto size = int(slice.size());
+	const auto index = *data->playlistIndex
+		+ (order(data) == OrderMode::Reverse ? -1 : 1);
+	const auto wrap = (repeat(data) == RepeatMode::All)
+		&& (size > 0)
+		&& (slice.skippedAfter() == 0)
+		&& (slice.skippedBefore() == 0);
+	return itemByIndex(data, wrap ? ((index + size) % size) : index);
+}
+
+void Instance::checkPreloadNext(
+		not_null<Data*> data,
+		crl::time position) {
+	if (data->type != AudioMsgId::Type::Song
+		|| !data->streamed
+		|| OptionDisableAutoplayNext.value()
+		|| repeat(data) == RepeatMode::One) {
+		return;
+	}
+	const auto &info = data->streamed->instance.info();
+	const auto duration = info.audio.state.duration;
+	if (position == kTimeUnknown
+		|| duration == kTimeUnknown
+		|| duration - position > kPreloadNextBefore) {
+		return;
+	}
+	const auto item = nextItemToPreload(data);
+	const auto media = item ? item->media() : nullptr;
+	const auto document = media ? media->document() : nullptr;
+	if (!document
+		|| !document->isAudioFile()
+		|| media->ttlSeconds()
+		|| document == data->current.audio()) {
+		return;
+	}
+	const auto audioId = AudioMsgId(document, item->fullId());
+	if (data->preloadedNext && data->preloadedNext->id == audioId) {
+		return;
+	}
+	clearPreloadedNext(data);
+
+	auto shared = document->owner().streaming().sharedDocument(
+		document,
+		item->fullId());
+	if (!shared) {
+		return;
+	}
+
+	// Open the file and decode the first frame while paused, the reader
+	// stops fetching after the leading seconds. The mixer is taken only
+	// when playStreamed() resumes this instance, so the current track
+	// keeps playing till its end.
+	const auto saved = document->session().settings(
+	).mediaLastPlaybackPosition(document->id);
+	auto options = streamingOptions(audioId, saved);
+	options.deferAudioOutput = true;
+	data->preloadedNext = std::make_unique<Streamed>(
+		audioId,
+		std::move(shared));
+	data->preloadedNext->instance.lockPlayer();
+	data->preloadedNext->instance.play(options);
+	data->preloadedNext->instance.pause();
+}
+
+void Instance::clearPreloadedNext(not_null<Data*> data) {
+	if (const auto preloaded = base::take(data->preloadedNext)) {
+		preloaded->instance.stop();
+	}
+}
+
 void Instance::updatePowerSaveBlocker(
 		not_null<Data*> data,
 		const TrackState &state) {
@@ -817,10 +908,24 @@ void Instance::playStreamed(
 	Assert(data != nullptr);
 
 	clearStreamed(data, data->current.audio() != audioId.audio());
-	data->streamed = std::make_unique<Streamed>(
-		audioId,
-		std::move(shared));
-	data->streamed->instance.lockPlayer();
+	const auto adopt = data->preloadedNext
+		&& (data->preloadedNext->id == audioId)
+		&& data->preloadedNext->instance.active();
+	if (adopt) {
+		data->streamed = base::take(data->preloadedNext);
+
+		// The saved position was already used for the preloaded start.
+		const auto document = audioId.audio();
+		document->session().settings().setMediaLastPlaybackPosition(
+			document->id,
+			0);
+	} else {
+		clearPreloadedNext(data);
+		data->streamed = std::make_unique<Streamed>(
+			audioId,
+			std::move(shared));
+		data->streamed->instance.lockPlayer();
+	}
 
 	data->streamed->instance.player().updates(
 	) | rpl::start_with_next_error([=](Streaming::Update &&update) {
@@ -829,7 +934,11 @@ void Instance::playStreamed(
 		handleStreamingError(data, std::move(error));
 	}, data->streamed->lifetime);
 
-	data->streamed->instance.play(streamingOptions(audioId));
+	if (adopt) {
+		data->streamed->instance.resume();
+	} else {
+		data->streamed->instance.play(streamingOptions(audioId));
+	}
 
 	emitUpdate(audioId.type());
 }
@@ -874,6 +983,7 @@ void Instance::stop(AudioMsgId::Type type) {
 		if (data->streamed) {
 			clearStreamed(data);
 		}
+		clearPreloadedNext(data);
 		data->resumeOnCallEnd = false;
 		_playerStopped.fire_copy({type});
 	}
@@ -1305,6 +1415,7 @@ void Instance::handleStreamingUpdate(
 		//emitUpdate(data->type, [](AudioMsgId) { return true; });
 	}, [&](UpdateAudio &update) {
 		emitUpdate(data->type);
+		checkPreloadNext(data, update.position);
 	}, [&](WaitingForData) {
 	}, [&](MutedByOther) {
 	}, [&](Finished) {
@@ -197,6 +197,7 @@ private:
 		bool resumeOnCallEnd = false;
 		std::unique_ptr<Streamed> streamed;
 		std::unique_ptr<ShuffleData> shuffleData;
+		std::unique_ptr<Streamed> preloadedNext;
 		std::unique_ptr<base::PowerSaveBlocker> powerSaveBlocker;
 		std::unique_ptr<base::PowerSaveBlocker> powerSaveBlockerVideo;
 	};
@@ -238,6 +239,9 @@ private:
 	void validateOtherPlaylist(not_null<Data*> data);
 	void playlistUpdated(not_null<Data*> data);
 	bool moveInPlaylist(not_null<Data*> data, int delta, bool autonext);
+	HistoryItem *nextItemToPreload(not_null<Data*> data);
+	void checkPreloadNext(not_null<Data*> data, crl::time position);
+	void clearPreloadedNext(not_null<Data*> data);
 	void updatePowerSaveBlocker(
 		not_null<Data*> data,
 		const TrackState &state);
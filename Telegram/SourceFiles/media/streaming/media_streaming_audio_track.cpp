@@ -113,7 +113,12 @@ bool AudioTrack::processFirstFrame() {
 	if (!FFmpeg::FrameHasData(_stream.decodedFrame.get())) {
 		return false;
 	}
-	mixerInit();
+	if (_options.deferAudioOutput) {
+		QMutexLocker lock(&_mixerMutex);
+		_mixerDeferred = true;
+	} else {
+		mixerInit();
+	}
 	callReady();
 	return true;
 }
@@ -128,7 +133,7 @@ bool AudioTrack::fillStateFromFrame() {
 }
 
 void AudioTrack::mixerInit() {
-	Expects(!initialized());
+	Expects(_stream.codec != nullptr);
 
 	auto data = std::make_unique<ExternalSoundData>();
 	data->frame = std::move(_stream.decodedFrame);
@@ -142,6 +147,21 @@ void AudioTrack::mixerInit() {
 		_startedPosition);
 }
 
+void AudioTrack::mixerInitDeferred() {
+	QMutexLocker lock(&_mixerMutex);
+	if (!base::take(_mixerDeferred)) {
+		return;
+	}
+	mixerInit();
+	if (!_deferredPackets.empty()) {
+		Media::Player::mixer()->feedFromExternal({
+			_audioId,
+			gsl::make_span(_deferredPackets)
+		});
+		_deferredPackets.clear();
+	}
+}
+
 void AudioTrack::callReady() {
 	Expects(_ready != nullptr);
 
@@ -155,6 +175,14 @@ void AudioTrack::callReady() {
 }
 
 void AudioTrack::mixerEnqueue(gsl::span<FFmpeg::Packet> packets) {
+	QMutexLocker lock(&_mixerMutex);
+	if (_mixerDeferred) {
+		_deferredPackets.insert(
+			end(_deferredPackets),
+			std::make_move_iterator(packets.begin()),
+			std::make_move_iterator(packets.end()));
+		return;
+	}
 	Media::Player::mixer()->feedFromExternal({
 		_audioId,
 		packets
@@ -162,7 +190,10 @@ void AudioTrack::mixerEnqueue(gsl::span<FFmpeg::Packet> packets) {
 }
 
 void AudioTrack::mixerForceToBuffer() {
-	Media::Player::mixer()->forceToBufferExternal(_audioId);
+	QMutexLocker lock(&_mixerMutex);
+	if (!_mixerDeferred) {
+		Media::Player::mixer()->forceToBufferExternal(_audioId);
+	}
 }
 
 void AudioTrack::pause(crl::time time) {
@@ -174,6 +205,7 @@ void AudioTrack::pause(crl::time time) {
 void AudioTrack::resume(crl::time time) {
 	Expects(initialized());
 
+	mixerInitDeferred();
 	Media::Player::mixer()->resume(_audioId, true);
 }
 
@@ -59,6 +59,7 @@ private:
 	[[nodiscard]] bool fillStateFromFrame();
 	[[nodiscard]] bool processFirstFrame();
 	void mixerInit();
+	void mixerInitDeferred();
 	void mixerEnqueue(gsl::span<FFmpeg::Packet> packets);
 	void mixerForceToBuffer();
 	void callReady();
@@ -88,6 +89,12 @@ private:
 	// For initial frame skipping for an exact seek.
 	FFmpeg::FramePointer _initialSkippingFrame;
 
+	// With deferred audio output the decoded first frame and the packets
+	// after it wait here until the first resume() starts the mixer.
+	QMutex _mixerMutex;
+	std::vector<FFmpeg::Packet> _deferredPackets;
+	bool _mixerDeferred = false;
+
 };
 
 } // namespace Streaming
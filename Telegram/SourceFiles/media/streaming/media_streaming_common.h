@@ -48,6 +48,7 @@ struct PlaybackOptions {
 	bool hwAllowed = false;
 	bool seekable = true;
 	bool loop = false;
+	bool deferAudioOutput = false; // Take the mixer only on resume().
 };
 
 struct TrackState {
@@ -23,15 +23,31 @@ constexpr auto kMaxOnlyInHeader = 80 * kPartSize;
 constexpr auto kPartsOutsideFirstSliceGood = 8;
 constexpr auto kSlicesInMemory = 2;
 
+// Streams that keep seeking back to unloaded slices hold more of them.
+constexpr auto kMaxSlicesInMemory = 6;
+
+// All streams together hold no more than 64 MB of such extra slices.
+constexpr auto kExtraSlicesInMemoryLimit = 8;
+
 // 1 MB of parts are requested from cloud ahead of reading demand.
 constexpr auto kPreloadPartsAhead = 8;
+
+// Up to 4 MB while the stream is read sequentially.
+constexpr auto kMaxPreloadPartsAhead = 32;
+
 constexpr auto kDownloaderRequestsLimit = 4;
 
+// When streaming is not active the downloader may use more requests.
+constexpr auto kDownloaderOnlyRequestsLimit = 8;
+
+std::atomic<int> ExtraSlicesInMemory = 0;
+
 using PartsMap = base::flat_map<uint32, QByteArray>;
 
 struct ParsedCacheEntry {
 	PartsMap parts;
 	std::optional<PartsMap> included;
+	QByteArray buffer;
 };
 
 bool IsContiguousSerialization(int serializedSize, int maxSliceSize) {
@@ -70,10 +86,19 @@ int MaxSliceSize(int sliceNumber, uint32 size) {
 		: kInSlice;
 }
 
+QByteArray CachedPart(bytes::const_span bytes, bool shared) {
+	const auto data = reinterpret_cast<const char*>(bytes.data());
+	const auto size = int(bytes.size());
+	return shared
+		? QByteArray::fromRawData(data, size)
+		: QByteArray(data, size);
+}
+
 bytes::const_span ParseComplexCachedMap(
 		PartsMap &result,
 		bytes::const_span data,
-		int maxSize) {
+		int maxSize,
+		bool shared) {
 	const auto takeInt = [&]() -> std::optional<uint32> {
 		if (data.size() < sizeof(uint32)) {
 			return std::nullopt;
@@ -110,10 +135,7 @@ bytes::const_span ParseComplexCachedMap(
 			|| bytes.size() != size) {
 			return {};
 		}
-		result.try_emplace(
-			offset,
-			reinterpret_cast<const char*>(bytes.data()),
-			bytes.size());
+		result.try_emplace(offset, CachedPart(bytes, shared));
 	}
 	return data;
 }
@@ -121,7 +143,8 @@ bytes::const_span ParseComplexCachedMap(
 bytes::const_span ParseCachedMap(
 		PartsMap &result,
 		bytes::const_span data,
-		int maxSize) {
+		int maxSize,
+		bool shared) {
 	const auto size = int(data.size());
 	if (IsContiguousSerialization(size, maxSize)) {
 		if (size > maxSize) {
@@ -131,28 +154,36 @@ bytes::const_span ParseCachedMap(
 			const auto part = data.subspan(
 				offset,
 				std::min(kPartSize, size - offset));
-			result.try_emplace(
-				uint32(offset),
-				reinterpret_cast<const char*>(part.data()),
-				part.size());
+			result.try_emplace(uint32(offset), CachedPart(part, shared));
 		}
 		return {};
 	}
-	return ParseComplexCachedMap(result, data, maxSize);
+	return ParseComplexCachedMap(result, data, maxSize, shared);
 }
 
+// Header parts live as long as the reader does, so they are copied out.
+// Data slice parts reference the entry bytes, kept alive in the buffer.
 ParsedCacheEntry ParseCacheEntry(
-		bytes::const_span data,
+		QByteArray &&data,
 		int sliceNumber,
 		int64 size) {
-	auto result = ParsedCacheEntry();
+	auto result = ParsedCacheEntry{ .buffer = std::move(data) };
+	const auto bytes = bytes::make_span(std::as_const(result.buffer));
 	const auto remaining = ParseCachedMap(
 		result.parts,
-		data,
-		MaxSliceSize(sliceNumber, size));
+		bytes,
+		MaxSliceSize(sliceNumber, size),
+		(sliceNumber != 0));
 	if (!sliceNumber && ComputeIsGoodHeader(size, result.parts)) {
 		result.included = PartsMap();
-		ParseCachedMap(*result.included, remaining, MaxSliceSize(1, size));
+		ParseCachedMap(
+			*result.included,
+			remaining,
+			MaxSliceSize(1, size),
+			true);
+	}
+	if (!sliceNumber && !result.included) {
+		result.buffer = QByteArray();
 	}
 	return result;
 }
@@ -229,7 +260,7 @@ struct Reader::CacheHelper {
 	const Storage::Cache::Key baseKey;
 
 	QMutex mutex;
-	base::flat_map<uint32, PartsMap> results;
+	base::flat_map<uint32, CachedParts> results;
 	std::vector<int> sizes;
 	std::atomic<crl::semaphore*> waiting = nullptr;
 };
@@ -242,7 +273,7 @@ Storage::Cache::Key Reader::CacheHelper::key(int sliceNumber) const {
 	return Storage::Cache::Key{ baseKey.high, baseKey.low + sliceNumber };
 }
 
-void Reader::Slice::processCacheData(PartsMap &&data) {
+void Reader::Slice::processCacheData(CachedParts &&data) {
 	Expects((flags & Flag::LoadingFromCache) != 0);
 	Expects(!(flags & Flag::LoadedFromCache));
 
@@ -250,10 +281,18 @@ void Reader::Slice::processCacheData(PartsMap &&data) {
 		flags |= Flag::LoadedFromCache;
 		flags &= ~Flag::LoadingFromCache;
 	});
+	if (!data.buffer.isEmpty() && !cacheBuffer.isEmpty()) {
+		// We can hold only one entry buffer, detach from the other one.
+		for (auto &[offset, bytes] : data.parts) {
+			bytes = QByteArray(bytes.constData(), bytes.size());
+		}
+	} else if (!data.buffer.isEmpty()) {
+		cacheBuffer = std::move(data.buffer);
+	}
 	if (parts.empty()) {
-		parts = std::move(data);
+		parts = std::move(data.parts);
 	} else {
-		for (auto &[offset, bytes] : data) {
+		for (auto &[offset, bytes] : data.parts) {
 			parts.emplace(offset, std::move(bytes));
 		}
 	}
@@ -270,13 +309,14 @@ void Reader::Slice::addPart(uint32 offset, QByteArray bytes) {
 
 auto Reader::Slice::prepareFill(
 		uint32 from,
-		uint32 till) -> PrepareFillResult {
+		uint32 till,
+		int preloadPartsAhead) -> PrepareFillResult {
 	auto result = PrepareFillResult();
 
 	result.ready = false;
 	const auto fromOffset = (from / kPartSize) * kPartSize;
 	const auto tillPart = (till + kPartSize - 1) / kPartSize;
-	const auto preloadTillOffset = (tillPart + kPreloadPartsAhead)
+	const auto preloadTillOffset = (tillPart + preloadPartsAhead)
 		* kPartSize;
 
 	const auto after = ranges::upper_bound(
@@ -341,7 +381,9 @@ auto Reader::Slice::offsetsFromLoader(uint32 from, uint32 till) const
 }
 
 Reader::Slices::Slices(uint32 size, bool useCache)
-: _size(size) {
+: _slicesInMemory(kSlicesInMemory)
+, _preloadPartsAhead(kPreloadPartsAhead)
+, _size(size) {
 	Expects(size > 0);
 
 	if (useCache) {
@@ -370,6 +412,10 @@ bool Reader::Slices::computeIsGoodHeader() const {
 	return ComputeIsGoodHeader(_size, _header.parts);
 }
 
+Reader::Slices::~Slices() {
+	ExtraSlicesInMemory -= (_slicesInMemory - kSlicesInMemory);
+}
+
 void Reader::Slices::headerDone(bool fromCache) {
 	if (_headerMode != HeaderMode::Unknown) {
 		return;
@@ -438,7 +484,9 @@ void Reader::Slices::applyHeaderCacheData() {
 	}
 }
 
-void Reader::Slices::processCacheResult(int sliceNumber, PartsMap &&result) {
+void Reader::Slices::processCacheResult(
+		int sliceNumber,
+		CachedParts &&result) {
 	Expects(sliceNumber >= 0 && sliceNumber <= _data.size());
 
 	auto &slice = (sliceNumber ? _data[sliceNumber - 1] : _header);
@@ -561,12 +609,14 @@ auto Reader::Slices::fill(uint32 offset, bytes::span buffer) -> FillResult {
 		// Waiting for initial cache query.
 		Assert(waitingForHeaderCache());
 		return {};
-	} else if (isFullInHeader()) {
+	}
+	const auto till = uint32(offset + buffer.size());
+	trackFill(offset, till);
+	if (isFullInHeader()) {
 		return fillFromHeader(offset, buffer);
 	}
 
 	auto result = FillResult();
-	const auto till = uint32(offset + buffer.size());
 	const auto fromSlice = offset / kInSlice;
 	const auto tillSlice = (till + kInSlice - 1) / kInSlice;
 	Assert((fromSlice + 1 == tillSlice || fromSlice + 2 == tillSlice)
@@ -592,8 +642,13 @@ auto Reader::Slices::fill(uint32 offset, bytes::span buffer) -> FillResult {
 	};
 	const auto handleReadFromCache = [&](int sliceIndex) {
 		if (cacheNotLoaded(sliceIndex)) {
-			if (!(_data[sliceIndex].flags & Flag::LoadingFromCache)) {
-				_data[sliceIndex].flags |= Flag::LoadingFromCache;
+			auto &slice = _data[sliceIndex];
+			if (!(slice.flags & Flag::LoadingFromCache)) {
+				if (slice.flags & Flag::Unloaded) {
+					++result.sliceReloads;
+					growSlicesInMemory();
+				}
+				slice.flags |= Flag::LoadingFromCache;
 				result.sliceNumbersFromCache.add(sliceIndex + 1);
 			}
 			result.state = FillState::WaitingCache;
@@ -605,9 +660,15 @@ auto Reader::Slices::fill(uint32 offset, bytes::span buffer) -> FillResult {
 	const auto secondTill = (till > (fromSlice + 1) * kInSlice)
 		? (till - (fromSlice + 1) * kInSlice)
 		: 0;
-	const auto first = _data[fromSlice].prepareFill(firstFrom, firstTill);
+	const auto first = _data[fromSlice].prepareFill(
+		firstFrom,
+		firstTill,
+		_preloadPartsAhead);
 	const auto second = (fromSlice + 1 < tillSlice)
-		? _data[fromSlice + 1].prepareFill(secondFrom, secondTill)
+		? _data[fromSlice + 1].prepareFill(
+			secondFrom,
+			secondTill,
+			_preloadPartsAhead)
 		: Slice::PrepareFillResult();
 	handlePrepareResult(fromSlice, first);
 	if (fromSlice + 1 < tillSlice) {
@@ -645,7 +706,10 @@ auto Reader::Slices::fillFromHeader(uint32 offset, bytes::span buffer)
 	const auto from = offset;
 	const auto till = uint32(offset + buffer.size());
 
-	const auto prepared = _header.prepareFill(from, till);
+	const auto prepared = _header.prepareFill(
+		from,
+		till,
+		_preloadPartsAhead);
 	for (const auto full : prepared.offsetsFromLoader.values()) {
 		if (full < _size) {
 			result.offsetsFromLoader.add(full);
@@ -673,7 +737,13 @@ QByteArray Reader::Slices::partForDownloader(uint32 offset) const {
 	const auto index = offset / kInSlice;
 	const auto &slice = _data[index];
 	const auto i = slice.parts.find(offset - index * kInSlice);
-	return (i != end(slice.parts)) ? i->second : QByteArray();
+	if (i == end(slice.parts)) {
+		return QByteArray();
+	} else if (slice.cacheBuffer.isEmpty()) {
+		return i->second;
+	}
+	// The part may reference cacheBuffer, which goes away with the slice.
+	return QByteArray(i->second.constData(), i->second.size());
 }
 
 bool Reader::Slices::waitingForHeaderCache() const {
@@ -705,6 +775,39 @@ void Reader::Slices::markSliceUsed(int sliceIndex) {
 	}
 }
 
+void Reader::Slices::trackFill(uint32 from, uint32 till) {
+	// Demuxer reads may step back a bit, that is still sequential reading.
+	const auto window = kPreloadPartsAhead * kPartSize;
+	const auto sequential = (from + kInSlice > _lastFillFrom)
+		&& (from <= _lastFillTill + window);
+	if (!sequential) {
+		_sequentialBytes = 0;
+	} else if (till > _lastFillTill) {
+		_sequentialBytes += (till - _lastFillTill);
+	}
+	_lastFillFrom = from;
+	_lastFillTill = till;
+
+	// Each slice read in a row adds one more megabyte of read-ahead.
+	const auto grow = int(_sequentialBytes / kInSlice) * kPreloadPartsAhead;
+	_preloadPartsAhead = std::min(
+		kPreloadPartsAhead + grow,
+		kMaxPreloadPartsAhead);
+}
+
+void Reader::Slices::growSlicesInMemory() {
+	if (_slicesInMemory >= kMaxSlicesInMemory) {
+		return;
+	}
+	auto extra = ExtraSlicesInMemory.load(std::memory_order_relaxed);
+	while (extra < kExtraSlicesInMemoryLimit) {
+		if (ExtraSlicesInMemory.compare_exchange_weak(extra, extra + 1)) {
+			++_slicesInMemory;
+			return;
+		}
+	}
+}
+
 int Reader::Slices::maxSliceSize(int sliceNumber) const {
 	return MaxSliceSize(sliceNumber, _size);
 }
@@ -713,7 +816,7 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadUnused() {
 	using Flag = Slice::Flag;
 
 	if (_headerMode == HeaderMode::Unknown
-		|| _usedSlices.size() <= kSlicesInMemory) {
+		|| int(_usedSlices.size()) <= _slicesInMemory) {
 		return {};
 	}
 	const auto purgeSlice = _usedSlices.front();
@@ -801,6 +904,7 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadSlice(
 void Reader::Slices::unloadSlice(Slice &slice) const {
 	const auto full = (slice.flags & Slice::Flag::FullInCache);
 	slice = Slice();
+	slice.flags |= Slice::Flag::Unloaded;
 	if (full) {
 		slice.flags |= Slice::Flag::FullInCache;
 	}
@@ -847,6 +951,10 @@ Reader::Reader(
 , _slices(_loader->size(), _cacheHelper != nullptr) {
 	_loader->parts(
 	) | rpl::start_with_next([=](LoadedPart &&part) {
+		_partsFromLoader.fetch_add(1, std::memory_order_relaxed);
+		_bytesFromLoader.fetch_add(
+			part.bytes.size(),
+			std::memory_order_relaxed);
 		if (_attachedDownloader) {
 			_partsForDownloader.fire_copy(part);
 		}
@@ -866,7 +974,7 @@ Reader::Reader(
 
 void Reader::startSleep(not_null<crl::semaphore*> wake) {
 	_sleeping.store(wake, std::memory_order_release);
-	processDownloaderRequests();
+	processDownloaderRequests(true);
 }
 
 void Reader::wakeFromSleep() {
@@ -911,7 +1019,7 @@ void Reader::stopStreaming(bool stillActive) {
 		_streamingActive = false;
 		refreshLoaderPriority();
 		_loadingOffsets.clear();
-		processDownloaderRequests();
+		processDownloaderRequests(false);
 	}
 }
 
@@ -1007,11 +1115,14 @@ void Reader::checkForDownloaderReadyOffsets() {
 		if (i == end(_downloaderReadCache) || !i->second) {
 			return true;
 		}
-		const auto j = i->second->find(offset - index * kInSlice);
-		if (j == end(*i->second)) {
+		const auto &parts = i->second->parts;
+		const auto j = parts.find(offset - index * kInSlice);
+		if (j == end(parts)) {
 			return true;
 		}
-		return unavailableInBytes(offset, std::move(j->second));
+		return unavailableInBytes(
+			offset,
+			QByteArray(j->second.constData(), j->second.size()));
 	};
 	const auto unavailable = [&](uint32 offset) {
 		return unavailableInBytes(offset, _slices.partForDownloader(offset))
@@ -1022,14 +1133,16 @@ void Reader::checkForDownloaderReadyOffsets() {
 		ranges::find_if(_offsetsForDownloader, unavailable));
 }
 
-void Reader::processDownloaderRequests() {
+void Reader::processDownloaderRequests(bool streaming) {
 	processCacheResults();
 	enqueueDownloaderOffsets();
 	checkForDownloaderReadyOffsets();
 	pruneDoneDownloaderRequests();
 	if (!empty(_offsetsForDownloader)) {
 		pruneDownloaderCache(_offsetsForDownloader.front());
-		sendDownloaderRequests();
+		sendDownloaderRequests(streaming
+			? kDownloaderRequestsLimit
+			: kDownloaderOnlyRequestsLimit);
 	}
 }
 
@@ -1039,7 +1152,9 @@ void Reader::pruneDownloaderCache(uint32 minimalOffset) {
 		_downloaderReadCache,
 		minimalSliceNumber,
 		ranges::less(),
-		&base::flat_map<uint32, std::optional<PartsMap>>::value_type::first);
+		&base::flat_map<
+			uint32,
+			std::optional<CachedParts>>::value_type::first);
 	_downloaderReadCache.erase(_downloaderReadCache.begin(), removeTill);
 }
 
@@ -1053,10 +1168,10 @@ void Reader::pruneDoneDownloaderRequests() {
 	}
 }
 
-void Reader::sendDownloaderRequests() {
+void Reader::sendDownloaderRequests(int limit) {
 	auto &&offsets = ranges::views::all(
 		_offsetsForDownloader
-	) | ranges::views::take(kDownloaderRequestsLimit);
+	) | ranges::views::take(limit);
 	for (const auto offset : offsets) {
 		if ((!_cacheHelper || !downloaderWaitForCachedSlice(offset))
 			&& _downloaderOffsetsRequested.emplace(offset).second) {
@@ -1082,7 +1197,7 @@ bool Reader::downloaderWaitForCachedSlice(uint32 offset) {
 			sliceNumber,
 			(readFromCacheForDownloader(sliceNumber)
 				? std::nullopt
-				: std::make_optional(PartsMap()))).first;
+				: std::make_optional(CachedParts()))).first;
 	}
 	return !i->second;
 }
@@ -1095,7 +1210,7 @@ void Reader::continueDownloaderFromMainThread() {
 	if (_streamingActive) {
 		wakeFromSleep();
 	} else {
-		processDownloaderRequests();
+		processDownloaderRequests(false);
 	}
 }
 
@@ -1115,6 +1230,15 @@ bool Reader::isRemoteLoader() const {
 	return _loader->baseCacheKey().valid();
 }
 
+Reader::Stats Reader::stats() const {
+	return {
+		.slicesFromCache = _slicesFromCache.load(std::memory_order_relaxed),
+		.sliceReloads = _sliceReloads.load(std::memory_order_relaxed),
+		.partsFromLoader = _partsFromLoader.load(std::memory_order_relaxed),
+		.bytesFromLoader = _bytesFromLoader.load(std::memory_order_relaxed),
+	};
+}
+
 std::shared_ptr<Reader::CacheHelper> Reader::InitCacheHelper(
 		Storage::Cache::Key baseKey) {
 	if (!baseKey) {
@@ -1145,14 +1269,20 @@ void Reader::readFromCache(int sliceNumber) {
 			sizes = std::move(sizes)
 		]() mutable{
 			auto entry = ParseCacheEntry(
-				bytes::make_span(result),
+				std::move(result),
 				sliceNumber,
 				size);
 			if (const auto strong = cache.lock()) {
 				QMutexLocker lock(&strong->mutex);
-				strong->results.emplace(sliceNumber, std::move(entry.parts));
+				strong->results.emplace(sliceNumber, CachedParts{
+					.parts = std::move(entry.parts),
+					.buffer = (sliceNumber ? entry.buffer : QByteArray()),
+				});
 				if (!sliceNumber && entry.included) {
-					strong->results.emplace(1, std::move(*entry.included));
+					strong->results.emplace(1, CachedParts{
+						.parts = std::move(*entry.included),
+						.buffer = std::move(entry.buffer),
+					});
 				}
 				strong->sizes = std::move(sizes);
 				if (const auto waiting = strong->waiting.load()) {
@@ -1263,6 +1393,11 @@ Reader::FillState Reader::fillFromSlices(uint32 offset, bytes::span buffer) {
 	using namespace rpl::mappers;
 
 	auto result = _slices.fill(offset, buffer);
+	if (result.sliceReloads) {
+		_sliceReloads.fetch_add(
+			result.sliceReloads,
+			std::memory_order_relaxed);
+	}
 	if (result.state != FillState::Success && _slices.headerWontBeFilled()) {
 		_streamingError = Error::NotStreamable;
 		return FillState::Failed;
@@ -1332,6 +1467,9 @@ bool Reader::processCacheResults() {
 		return false;
 	}
 	for (auto &[sliceNumber, result] : loaded) {
+		if (!result.parts.empty()) {
+			_slicesFromCache.fetch_add(1, std::memory_order_relaxed);
+		}
 		_slices.processCacheResult(sliceNumber, std::move(result));
 	}
 	if (!sizes.empty()) {
@@ -1393,6 +1531,17 @@ void Reader::finalizeCache() {
 
 Reader::~Reader() {
 	finalizeCache();
+
+	const auto stats = this->stats();
+	if (stats.slicesFromCache || stats.partsFromLoader) {
+		DEBUG_LOG(("Streaming Info: Reader done, "
+			"slices from cache: %1 (reloads: %2), "
+			"parts from loader: %3 (%4 bytes).").arg(
+				stats.slicesFromCache
+			).arg(stats.sliceReloads
+			).arg(stats.partsFromLoader
+			).arg(stats.bytesFromLoader));
+	}
 }
 
 QByteArray SerializeComplexPartsMap(
@@ -46,9 +46,17 @@ public:
 
 	void setLoaderPriority(int priority);
 
+	struct Stats {
+		int64 slicesFromCache = 0;
+		int64 sliceReloads = 0;
+		int64 partsFromLoader = 0;
+		int64 bytesFromLoader = 0;
+	};
+
 	// Any thread.
 	[[nodiscard]] int64 size() const;
 	[[nodiscard]] bool isRemoteLoader() const;
+	[[nodiscard]] Stats stats() const;
 
 	// Single thread.
 	[[nodiscard]] FillState fill(
@@ -90,6 +98,13 @@ private:
 
 	using PartsMap = base::flat_map<uint32, QByteArray>;
 
+	// Parts of a data slice read from cache don't own their bytes,
+	// they point inside of the decrypted cache entry kept in buffer.
+	struct CachedParts {
+		PartsMap parts;
+		QByteArray buffer;
+	};
+
 	template <int Size>
 	class StackIntVector {
 	public:
@@ -112,6 +127,7 @@ private:
 		StackIntVector<kLoadFromRemoteMax> offsetsFromLoader;
 		SerializedSlice toCache;
 		FillState state = FillState::WaitingRemote;
+		int sliceReloads = 0;
 	};
 	struct Slice {
 		enum class Flag : uchar {
@@ -119,6 +135,7 @@ private:
 			LoadedFromCache = 0x02,
 			ChangedSinceCache = 0x04,
 			FullInCache = 0x08,
+			Unloaded = 0x10,
 		};
 		friend constexpr inline bool is_flag_type(Flag) { return true; }
 		using Flags = base::flags<Flag>;
@@ -130,9 +147,12 @@ private:
 			bool ready = true;
 		};
 
-		void processCacheData(PartsMap &&data);
+		void processCacheData(CachedParts &&data);
 		void addPart(uint32 offset, QByteArray bytes);
-		PrepareFillResult prepareFill(uint32 from, uint32 till);
+		PrepareFillResult prepareFill(
+			uint32 from,
+			uint32 till,
+			int preloadPartsAhead);
 
 		// Get up to kLoadFromRemoteMax not loaded parts in from-till range.
 		StackIntVector<kLoadFromRemoteMax> offsetsFromLoader(
@@ -140,6 +160,7 @@ private:
 			uint32 till) const;
 
 		PartsMap parts;
+		QByteArray cacheBuffer;
 		Flags flags;
 
 	};
@@ -147,6 +168,7 @@ private:
 	class Slices {
 	public:
 		Slices(uint32 size, bool useCache);
+		~Slices();
 
 		void headerDone(bool fromCache);
 		[[nodiscard]] int headerSize() const;
@@ -159,7 +181,7 @@ private:
 
 		[[nodiscard]] int requestSliceSizesCount() const;
 
-		void processCacheResult(int sliceNumber, PartsMap &&result);
+		void processCacheResult(int sliceNumber, CachedParts &&result);
 		void processCachedSizes(const std::vector<int> &sizes);
 		void processPart(uint32 offset, QByteArray &&bytes);
 
@@ -187,6 +209,8 @@ private:
 			const Slice &slice) const;
 		[[nodiscard]] QByteArray serializeAndUnloadFirstSliceNoHeader();
 		void markSliceUsed(int sliceIndex);
+		void trackFill(uint32 from, uint32 till);
+		void growSlicesInMemory();
 		[[nodiscard]] bool computeIsGoodHeader() const;
 		[[nodiscard]] FillResult fillFromHeader(
 			uint32 offset,
@@ -198,6 +222,11 @@ private:
 		std::vector<Slice> _data;
 		Slice _header;
 		std::deque<int> _usedSlices;
+		int _slicesInMemory = 0;
+		int _preloadPartsAhead = 0;
+		uint32 _lastFillFrom = 0;
+		uint32 _lastFillTill = 0;
+		uint32 _sequentialBytes = 0;
 		uint32 _size = 0;
 		HeaderMode _headerMode = HeaderMode::Unknown;
 		bool _fullInCache = false;
@@ -222,11 +251,11 @@ private:
 
 	void finalizeCache();
 
-	void processDownloaderRequests();
+	void processDownloaderRequests(bool streaming);
 	void checkCacheResultsForDownloader();
 	void pruneDownloaderCache(uint32 minimalOffset);
 	void pruneDoneDownloaderRequests();
-	void sendDownloaderRequests();
+	void sendDownloaderRequests(int limit);
 	[[nodiscard]] bool downloaderWaitForCachedSlice(uint32 offset);
 	void enqueueDownloaderOffsets();
 	void checkForDownloaderChange(int checkItemsCount);
@@ -251,6 +280,11 @@ private:
 
 	Slices _slices;
 
+	std::atomic<int64> _slicesFromCache = 0;
+	std::atomic<int64> _sliceReloads = 0;
+	std::atomic<int64> _partsFromLoader = 0;
+	std::atomic<int64> _bytesFromLoader = 0;
+
 	// Even if streaming had failed, the Reader can work for the downloader.
 	std::optional<Error> _streamingError;
 
@@ -266,7 +300,7 @@ private:
 	// Streaming thread.
 	std::deque<uint32> _offsetsForDownloader;
 	base::flat_set<uint32> _downloaderOffsetsRequested;
-	base::flat_map<uint32, std::optional<PartsMap>> _downloaderReadCache;
+	base::flat_map<uint32, std::optional<CachedParts>> _downloaderReadCache;
 
 	// Communication from main thread to streaming thread.
 	// Streaming thread to main thread communicates using crl::on_main.
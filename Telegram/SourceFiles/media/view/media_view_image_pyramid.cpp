@@ -0,0 +1,313 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "media/view/media_view_image_pyramid.h"
+
+#include <QtCore/QBuffer>
+#include <QtGui/QImageReader>
+
+namespace Media::View {
+namespace {
+
+constexpr auto kTileSize = 512;
+constexpr auto kMaxTiles = 96;
+
+[[nodiscard]] QImage PrepareLevel(QImage image) {
+	constexpr auto kGood = QImage::Format_ARGB32_Premultiplied;
+	if (!image.isNull()
+		&& image.format() != kGood
+		&& image.format() != QImage::Format_RGB32) {
+		image = std::move(image).convertToFormat(kGood);
+	}
+	return image;
+}
+
+[[nodiscard]] QImage Read(
+		const QByteArray &content,
+		QSize scaled,
+		QRect clip = QRect()) {
+	QBuffer buffer;
+	buffer.setData(content);
+	if (!buffer.open(QIODevice::ReadOnly)) {
+		return QImage();
+	}
+	QImageReader reader(&buffer);
+	reader.setAutoTransform(true);
+	if (!clip.isEmpty()) {
+		reader.setClipRect(clip);
+	}
+	if (!scaled.isEmpty()) {
+		reader.setScaledSize(scaled);
+	}
+	return PrepareLevel(reader.read());
+}
+
+} // namespace
+
+struct ImagePyramid::Worker {
+	Worker(QByteArray content, QSize original);
+
+	[[nodiscard]] QImage readDetail(QRect region, QSize outer);
+	[[nodiscard]] QRect tileRect(int column, int row) const;
+	void touchTile(int index);
+
+	const QByteArray content;
+	const QSize original;
+	const int columns = 0;
+	base::flat_map<int, QImage> tiles;
+	std::vector<int> used;
+	std::atomic<bool> cancelled = false;
+};
+
+ImagePyramid::Worker::Worker(QByteArray content, QSize original)
+: content(std::move(content))
+, original(original)
+, columns((original.width() + kTileSize - 1) / kTileSize) {
+}
+
+QRect ImagePyramid::Worker::tileRect(int column, int row) const {
+	return QRect(
+		column * kTileSize,
+		row * kTileSize,
+		kTileSize,
+		kTileSize
+	).intersected(QRect(QPoint(), original));
+}
+
+void ImagePyramid::Worker::touchTile(int index) {
+	used.erase(ranges::remove(used, index), end(used));
+	used.push_back(index);
+}
+
+QImage ImagePyramid::Worker::readDetail(QRect region, QSize outer) {
+	if (region.width() > outer.width() || region.height() > outer.height()) {
+		// Not zoomed to full resolution yet, tiles would only waste memory.
+		return Read(
+			content,
+			region.size().scaled(outer, Qt::KeepAspectRatio),
+			region);
+	}
+	const auto left = region.x() / kTileSize;
+	const auto top = region.y() / kTileSize;
+	const auto right = (region.x() + region.width() - 1) / kTileSize;
+	const auto bottom = (region.y() + region.height() - 1) / kTileSize;
+	const auto index = [&](int column, int row) {
+		return row * columns + column;
+	};
+	auto missing = QRect();
+	for (auto row = top; row <= bottom; ++row) {
+		for (auto column = left; column <= right; ++column) {
+			if (!tiles.contains(index(column, row))) {
+				missing |= tileRect(column, row);
+			}
+		}
+	}
+	if (!missing.isEmpty()) {
+		const auto image = Read(content, QSize(), missing);
+		if (image.isNull() || image.size() != missing.size()) {
+			return QImage();
+		}
+		for (auto row = top; row <= bottom; ++row) {
+			for (auto column = left; column <= right; ++column) {
+				const auto rect = tileRect(column, row);
+				if (missing.contains(rect)) {
+					tiles[index(column, row)] = image.copy(
+						rect.translated(-missing.topLeft()));
+				}
+			}
+		}
+	}
+	const auto format = tiles[index(left, top)].format();
+	auto result = QImage(region.size(), format);
+	result.fill(Qt::transparent);
+	auto p = QPainter(&result);
+	p.setCompositionMode(QPainter::CompositionMode_Source);
+	for (auto row = top; row <= bottom; ++row) {
+		for (auto column = left; column <= right; ++column) {
+			const auto i = index(column, row);
+			p.drawImage(
+				tileRect(column, row).topLeft() - region.topLeft(),
+				tiles[i]);
+			touchTile(i);
+		}
+	}
+	p.end();
+
+	while (tiles.size() > kMaxTiles) {
+		tiles.remove(used.front());
+		used.erase(begin(used));
+	}
+	return result;
+}
+
+bool IsSemitransparent(const QImage &image) {
+	if (image.isNull()) {
+		return true;
+	} else if (!image.hasAlphaChannel()) {
+		return false;
+	}
+	Assert(image.format() == QImage::Format_ARGB32_Premultiplied);
+	constexpr auto kAlphaMask = 0xFF000000;
+	auto ints = reinterpret_cast<const uint32*>(image.bits());
+	const auto add = (image.bytesPerLine() / 4) - image.width();
+	for (auto y = 0; y != image.height(); ++y) {
+		for (auto till = ints + image.width(); ints != till; ++ints) {
+			if ((*ints & kAlphaMask) != kAlphaMask) {
+				return true;
+			}
+		}
+		ints += add;
+	}
+	return false;
+}
+
+ImagePyramid::ImagePyramid(
+	QByteArray content,
+	QSize screen,
+	int maxLevelSide,
+	Fn<void()> updated)
+: _updated(std::move(updated)) {
+	QBuffer buffer;
+	buffer.setData(content);
+	if (!buffer.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	QImageReader reader(&buffer);
+	reader.setAutoTransform(true);
+	const auto stored = reader.canRead() ? reader.size() : QSize();
+	if (stored.isEmpty()) {
+		return;
+	}
+	const auto transformation = reader.transformation();
+	_rotated = transformation.testFlag(
+		QImageIOHandler::TransformationRotate90);
+	_tiled = (transformation == QImageIOHandler::TransformationNone)
+		&& reader.supportsOption(QImageIOHandler::ClipRect);
+	_original = _rotated ? stored.transposed() : stored;
+	_size = (_original.width() > maxLevelSide
+		|| _original.height() > maxLevelSide)
+		? _original.scaled(maxLevelSide, maxLevelSide, Qt::KeepAspectRatio)
+		: _original;
+	_worker = std::make_shared<Worker>(std::move(content), _original);
+	startLevels(screen);
+}
+
+ImagePyramid::~ImagePyramid() {
+	if (_worker) {
+		_worker->cancelled = true;
+	}
+}
+
+void ImagePyramid::startLevels(QSize screen) {
+	auto sizes = std::vector<QSize>();
+	if (_size.width() > screen.width() || _size.height() > screen.height()) {
+		sizes.push_back(_size.scaled(screen, Qt::KeepAspectRatio));
+	}
+	sizes.push_back(_size);
+
+	// Scaled size is applied before the EXIF transformation.
+	const auto rotated = _rotated;
+	const auto original = _original;
+	crl::async([=, worker = _worker, weak = base::make_weak(this)] {
+		for (const auto &size : sizes) {
+			if (worker->cancelled) {
+				return;
+			}
+			const auto scaled = (size == original)
+				? QSize()
+				: rotated
+				? size.transposed()
+				: size;
+			auto image = Read(worker->content, scaled);
+			if (image.isNull()) {
+				continue;
+			}
+			const auto transparent = IsSemitransparent(image);
+			crl::on_main(weak, [=, image = std::move(image)]() mutable {
+				_level = std::move(image);
+				_transparent = transparent;
+				_hasLevel = true;
+				_updated();
+			});
+		}
+	});
+}
+
+bool ImagePyramid::valid() const {
+	return (_worker != nullptr);
+}
+
+QSize ImagePyramid::size() const {
+	return _size;
+}
+
+QSize ImagePyramid::originalSize() const {
+	return _original;
+}
+
+bool ImagePyramid::transparent() const {
+	return _transparent;
+}
+
+QImage ImagePyramid::takeLevel() {
+	return base::take(_level);
+}
+
+bool ImagePyramid::hasLevel() const {
+	return _hasLevel;
+}
+
+void ImagePyramid::requestDetail(QRect region, QSize outer) {
+	if (!_tiled) {
+		return;
+	}
+	region = region.intersected(QRect(QPoint(), _original));
+	if (region.isEmpty() || outer.isEmpty()) {
+		return;
+	}
+	const auto request = DetailRequest{ region, outer };
+	if (_detailLoading) {
+		if (*_detailLoading != request) {
+			_detailPending = request;
+		}
+		return;
+	} else if (!_detail.isNull() && _detailFor == request) {
+		return;
+	}
+	loadDetail(request);
+}
+
+void ImagePyramid::loadDetail(DetailRequest request) {
+	_detailLoading = request;
+	crl::async([=, worker = _worker, weak = base::make_weak(this)] {
+		if (worker->cancelled) {
+			return;
+		}
+		auto image = worker->readDetail(request.region, request.outer);
+		crl::on_main(weak, [=, image = std::move(image)]() mutable {
+			_detail = std::move(image);
+			_detailFor = request;
+			_detailLoading = std::nullopt;
+			if (const auto next = base::take(_detailPending)) {
+				if (*next != request) {
+					loadDetail(*next);
+				}
+			}
+			_updated();
+		});
+	});
+}
+
+const QImage &ImagePyramid::detail() const {
+	return _detail;
+}
+
+QRect ImagePyramid::detailRegion() const {
+	return _detail.isNull() ? QRect() : _detailFor.region;
+}
+
+} // namespace Media::View
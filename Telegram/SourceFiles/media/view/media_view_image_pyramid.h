@@ -0,0 +1,78 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/weak_ptr.h"
+
+namespace Media::View {
+
+[[nodiscard]] bool IsSemitransparent(const QImage &image);
+
+// Decodes a static image in the background, level by level.
+//
+// The first level fits the screen, the second one is limited by
+// maxLevelSide. When the image is zoomed beyond the second level the
+// visible region is read from the source in full resolution tiles.
+class ImagePyramid final : public base::has_weak_ptr {
+public:
+	ImagePyramid(
+		QByteArray content,
+		QSize screen,
+		int maxLevelSide,
+		Fn<void()> updated);
+	~ImagePyramid();
+
+	[[nodiscard]] bool valid() const;
+	[[nodiscard]] QSize size() const;
+	[[nodiscard]] QSize originalSize() const;
+	[[nodiscard]] bool transparent() const;
+
+	// Returns the next decoded level once, null if there is no new one.
+	[[nodiscard]] QImage takeLevel();
+
+	// Until then only a placeholder can be shown instead of the levels.
+	[[nodiscard]] bool hasLevel() const;
+
+	// Region is in original image coordinates, outer is the size in
+	// device pixels it is going to be painted with.
+	void requestDetail(QRect region, QSize outer);
+	[[nodiscard]] const QImage &detail() const;
+	[[nodiscard]] QRect detailRegion() const;
+
+private:
+	struct Worker;
+	struct DetailRequest {
+		QRect region;
+		QSize outer;
+
+		friend inline bool operator==(
+			const DetailRequest &,
+			const DetailRequest &) = default;
+	};
+
+	void startLevels(QSize screen);
+	void loadDetail(DetailRequest request);
+
+	const Fn<void()> _updated;
+	std::shared_ptr<Worker> _worker;
+	QSize _original;
+	QSize _size;
+	QImage _level;
+	bool _transparent = false;
+	bool _hasLevel = false;
+	bool _rotated = false;
+	bool _tiled = false;
+
+	QImage _detail;
+	DetailRequest _detailFor;
+	std::optional<DetailRequest> _detailLoading;
+	std::optional<DetailRequest> _detailPending;
+
+};
+
+} // namespace Media::View
@@ -41,6 +41,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "boxes/report_messages_box.h"
 #include "media/audio/media_audio.h"
 #include "media/view/media_view_group_thumbs.h"
+#include "media/view/media_view_image_pyramid.h"
 #include "media/view/media_view_pip.h"
 #include "media/view/media_view_overlay_raster.h"
 #include "media/view/media_view_overlay_opengl.h"
@@ -198,27 +199,6 @@ QWidget *PipDelegate::pipParentWidget() {
 		: read.image;
 }
 
-[[nodiscard]] bool IsSemitransparent(const QImage &image) {
-	if (image.isNull()) {
-		return true;
-	} else if (!image.hasAlphaChannel()) {
-		return false;
-	}
-	Assert(image.format() == QImage::Format_ARGB32_Premultiplied);
-	constexpr auto kAlphaMask = 0xFF000000;
-	auto ints = reinterpret_cast<const uint32*>(image.bits());
-	const auto add = (image.bytesPerLine() / 4) - image.width();
-	for (auto y = 0; y != image.height(); ++y) {
-		for (auto till = ints + image.width(); ints != till; ++ints) {
-			if ((*ints & kAlphaMask) != kAlphaMask) {
-				return true;
-			}
-		}
-		ints += add;
-	}
-	return false;
-}
-
 } // namespace
 
 struct OverlayWidget::SharedMedia {
@@ -1109,7 +1089,8 @@ int OverlayWidget::streamedIndex() const {
 }
 
 bool OverlayWidget::documentContentShown() const {
-	return _document && (!_staticContent.isNull() || videoShown());
+	return _document
+		&& (!_staticContent.isNull() || _staticPyramid || videoShown());
 }
 
 bool OverlayWidget::documentBubbleShown() const {
@@ -1117,6 +1098,7 @@ bool OverlayWidget::documentBubbleShown() const {
 		|| (_document
 			&& !_themePreviewShown
 			&& !_streamed
+			&& !_staticPyramid
 			&& _staticContent.isNull());
 }
 
@@ -1132,6 +1114,133 @@ void OverlayWidget::setStaticContent(QImage image) {
 	_staticContentTransparent = IsSemitransparent(_staticContent);
 }
 
+QSize OverlayWidget::staticContentSize() const {
+	return _staticPyramid ? _staticPyramid->size() : _staticContent.size();
+}
+
+std::unique_ptr<ImagePyramid> OverlayWidget::makeStaticPyramid(
+		not_null<DocumentData*> document,
+		QByteArray content) const {
+	const auto screen = _window->screen();
+	const auto outer = screen
+		? (screen->geometry().size() * style::DevicePixelRatio())
+		: QSize(kMaxDisplayImageSize, kMaxDisplayImageSize);
+	return std::make_unique<ImagePyramid>(
+		std::move(content),
+		outer,
+		kMaxDisplayImageSize,
+		[=] {
+			if (_document == document) {
+				staticPyramidUpdated();
+			}
+		});
+}
+
+void OverlayWidget::setStaticPyramid(QByteArray content) {
+	Expects(_document != nullptr);
+
+	_staticPyramid = makeStaticPyramid(_document, content);
+	if (!_staticPyramid->valid()) {
+		_staticPyramid = nullptr;
+		setStaticContent(PrepareStaticImage({ .content = content }));
+	} else {
+		setStaticPyramidPlaceholder();
+	}
+}
+
+void OverlayWidget::setStaticPyramidPlaceholder() {
+	if (const auto thumbnail = _documentMedia->thumbnail()) {
+		setStaticContent(thumbnail->pixNoCache(
+			thumbnail->size(),
+			{ .options = Images::Option::Blur }
+		).toImage());
+	} else {
+		_staticContent = QImage();
+		_staticContentTransparent = false;
+	}
+}
+
+bool OverlayWidget::applyPreparedPyramid() {
+	const auto i = _preparedPyramids.find(_document);
+	if (i == end(_preparedPyramids)) {
+		return false;
+	}
+	_staticPyramid = std::move(i->second);
+	_preparedPyramids.erase(i);
+	setStaticPyramidPlaceholder();
+	staticPyramidUpdated();
+	return true;
+}
+
+void OverlayWidget::staticPyramidUpdated() {
+	if (!_staticPyramid) {
+		return;
+	} else if (auto level = _staticPyramid->takeLevel(); !level.isNull()) {
+		level.setDevicePixelRatio(style::DevicePixelRatio());
+		_staticContent = std::move(level);
+		_staticContentTransparent = _staticPyramid->transparent();
+	}
+	update();
+}
+
+bool OverlayWidget::staticDetailNeeded() const {
+	// Before the first level the content is a small blurred thumbnail,
+	// the detail would only decode the image once more in parallel.
+	return _staticPyramid
+		&& _staticPyramid->hasLevel()
+		&& !_stories
+		&& !_staticContent.isNull()
+		&& !finalContentRotation()
+		&& !_geometryAnimation.animating()
+		&& (_w * style::DevicePixelRatio() > _staticContent.width());
+}
+
+void OverlayWidget::validateStaticDetail() {
+	if (!staticDetailNeeded()) {
+		return;
+	}
+	const auto content = finalContentRect();
+	const auto visible = content.intersected(QRect(0, 0, width(), height()));
+	if (visible.isEmpty()) {
+		return;
+	}
+	const auto original = _staticPyramid->originalSize();
+	const auto scalex = original.width() / float64(content.width());
+	const auto scaley = original.height() / float64(content.height());
+	const auto left = int(std::floor((visible.x() - content.x()) * scalex));
+	const auto top = int(std::floor((visible.y() - content.y()) * scaley));
+	const auto right = int(std::ceil(
+		(visible.x() + visible.width() - content.x()) * scalex));
+	const auto bottom = int(std::ceil(
+		(visible.y() + visible.height() - content.y()) * scaley));
+	_staticPyramid->requestDetail(
+		QRect(left, top, right - left, bottom - top),
+		visible.size() * style::DevicePixelRatio());
+}
+
+auto OverlayWidget::staticDetailGeometry() const
+-> std::optional<ContentGeometry> {
+	if (!staticDetailNeeded()) {
+		return std::nullopt;
+	}
+	const auto region = _staticPyramid->detailRegion();
+	if (region.isEmpty()) {
+		return std::nullopt;
+	}
+	const auto content = finalContentRect();
+	const auto original = _staticPyramid->originalSize();
+	const auto scalex = content.width() / float64(original.width());
+	const auto scaley = content.height() / float64(original.height());
+	return ContentGeometry{
+		.rect = QRectF(
+			content.x() + region.x() * scalex,
+			content.y() + region.y() * scaley,
+			region.width() * scalex,
+			region.height() * scaley),
+		.controlsOpacity = _controlsOpacity.current(),
+	};
+}
+
 bool OverlayWidget::contentShown() const {
 	return _photo || documentContentShown();
 }
@@ -3389,6 +3498,7 @@ void OverlayWidget::displayPhoto(
 	refreshMediaViewer();
 
 	_staticContent = QImage();
+	_staticPyramid = nullptr;
 	if (!_stories && _photo->videoCanBePlayed()) {
 		initStreaming();
 	}
@@ -3442,6 +3552,7 @@ void OverlayWidget::displayDocument(
 		const StartStreaming &startStreaming) {
 	_fullScreenVideo = false;
 	_staticContent = QImage();
+	_staticPyramid = nullptr;
 	clearStreaming(_document != doc);
 	destroyThemePreview();
 	assignMediaPointer(doc);
@@ -3477,23 +3588,25 @@ void OverlayWidget::displayDocument(
 			} else {
 				_documentMedia->automaticLoad(fileOrigin(), _message);
 				_document->saveFromDataSilent();
-				auto &location = _document->location(true);
-				if (location.accessEnable()) {
-					setStaticContent(PrepareStaticImage({
-						.path = location.name(),
-					}));
-					if (!_staticContent.isNull()) {
-						_touchbarDisplay.fire(TouchBarItemType::Photo);
-					}
-				} else {
-					setStaticContent(PrepareStaticImage({
-						.content = _documentMedia->bytes(),
-					}));
-					if (!_staticContent.isNull()) {
-						_touchbarDisplay.fire(TouchBarItemType::Photo);
+				if (!applyPreparedPyramid()) {
+					auto &location = _document->location(true);
+					auto content = QByteArray();
+					if (location.accessEnable()) {
+						// Read the bytes while the file is accessible,
+						// they are decoded in the background.
+						QFile file(location.name());
+						if (file.open(QIODevice::ReadOnly)) {
+							content = file.readAll();
+						}
+					} else {
+						content = _documentMedia->bytes();
 					}
+					location.accessDisable();
+					setStaticPyramid(std::move(content));
+				}
+				if (!_staticContent.isNull() || _staticPyramid) {
+					_touchbarDisplay.fire(TouchBarItemType::Photo);
 				}
-				location.accessDisable();
 			}
 		}
 	}
@@ -3548,9 +3661,9 @@ void OverlayWidget::displayDocument(
 		}
 	} else if (_themePreviewShown) {
 		updateThemePreviewGeometry();
-	} else if (!_staticContent.isNull()) {
+	} else if (!_staticContent.isNull() || _staticPyramid) {
 		const auto size = style::ConvertScale(
-			flipSizeByRotation(_staticContent.size()));
+			flipSizeByRotation(staticContentSize()));
 		_w = size.width();
 		_h = size.height();
 	} else if (videoShown()) {
@@ -3835,7 +3948,19 @@ QImage OverlayWidget::transformedShownContent() const {
 QImage OverlayWidget::transformShownContent(
 		QImage content,
 		int rotation) const {
-	if (rotation) {
+	if (rotation && !videoShown()) {
+		// Static content is rotated once and then reused in each frame.
+		const auto key = content.cacheKey();
+		auto &cache = _staticContentRotated;
+		if (cache.key != key || cache.rotation != rotation) {
+			cache = RotatedContent{
+				.image = RotateFrameImage(std::move(content), rotation),
+				.key = key,
+				.rotation = rotation,
+			};
+		}
+		return cache.image;
+	} else if (rotation) {
 		content = RotateFrameImage(std::move(content), rotation);
 	}
 	if (videoShown()) {
@@ -4495,6 +4620,10 @@ void OverlayWidget::validatePhotoImage(Image *image, bool blurred) {
 	}
 	const auto use = flipSizeByRotation({ _width, _height })
 		* style::DevicePixelRatio();
+	if (!blurred && applyPreparedPhoto(use)) {
+		_blurred = false;
+		return;
+	}
 	setStaticContent(image->pixNoCache(
 		use,
 		{ .options = (blurred ? Images::Option::Blur : Images::Option()) }
@@ -4562,6 +4691,15 @@ void OverlayWidget::paint(not_null<Renderer*> renderer) {
 				contentGeometry(),
 				_staticContentTransparent,
 				fillTransparentBackground);
+			validateStaticDetail();
+			if (const auto detail = staticDetailGeometry()) {
+				renderer->paintTransformedStaticContent(
+					_staticPyramid->detail(),
+					*detail,
+					_staticContentTransparent,
+					fillTransparentBackground,
+					1);
+			}
 		}
 		paintRadialLoading(renderer);
 		if (_stories) {
@@ -5422,6 +5560,7 @@ void OverlayWidget::setSession(not_null<Main::Session*> session) {
 		if (!isHidden()) {
 			updateControls();
 			checkForSaveLoaded();
+			prepareNeighbours();
 		}
 	}, _sessionLifetime);
 
@@ -5513,6 +5652,130 @@ void OverlayWidget::preloadData(int delta) {
 	}
 	_preloadPhotos = std::move(photos);
 	_preloadDocuments = std::move(documents);
+	prepareNeighbours();
+}
+
+void OverlayWidget::prepareNeighbours() {
+	if (!_index || _stories) {
+		_preparedPhotos.clear();
+		_preparedPyramids.clear();
+		return;
+	}
+	auto photos = base::flat_set<not_null<PhotoData*>>();
+	auto documents = base::flat_set<not_null<DocumentData*>>();
+	for (const auto delta : { -1, 0, 1 }) {
+		const auto entity = entityByIndex(*_index + delta);
+		if (const auto photo = std::get_if<not_null<PhotoData*>>(
+				&entity.data)) {
+			photos.emplace(*photo);
+		} else if (const auto document = std::get_if<
+				not_null<DocumentData*>>(&entity.data)) {
+			documents.emplace(*document);
+		}
+	}
+
+	// The current item keeps what was prepared for it until it is shown.
+	for (auto i = begin(_preparedPhotos); i != end(_preparedPhotos);) {
+		if (photos.contains(i->first)) {
+			++i;
+		} else {
+			i = _preparedPhotos.erase(i);
+		}
+	}
+	for (auto i = begin(_preparedPyramids); i != end(_preparedPyramids);) {
+		if (documents.contains(i->first)) {
+			++i;
+		} else {
+			i = _preparedPyramids.erase(i);
+		}
+	}
+
+	for (const auto photo : photos) {
+		if (photo != _photo && !_preparedPhotos.contains(photo)) {
+			preparePhotoAhead(photo);
+		}
+	}
+	for (const auto document : documents) {
+		if (document == _document
+			|| _preparedPyramids.contains(document)
+			|| !document->isImage()
+			|| document->sticker()) {
+			continue;
+		}
+		const auto media = document->activeMediaView();
+		auto content = media ? media->bytes() : QByteArray();
+		if (content.isEmpty()) {
+			continue;
+		}
+		auto pyramid = makeStaticPyramid(document, std::move(content));
+		if (pyramid->valid()) {
+			_preparedPyramids.emplace(document, std::move(pyramid));
+		}
+	}
+}
+
+void OverlayWidget::preparePhotoAhead(not_null<PhotoData*> photo) {
+	const auto media = photo->activeMediaView();
+	const auto large = media
+		? media->image(Data::PhotoSize::Large)
+		: nullptr;
+	if (!large || photo->videoCanBePlayed()) {
+		return;
+	}
+	_preparedPhotos.emplace(photo, PreparedStatic());
+
+	// Same size validatePhotoImage() will ask for, see displayPhoto().
+	const auto ratio = style::DevicePixelRatio();
+	const auto size = style::ConvertScale(
+		QSize(photo->width(), photo->height())) * ratio;
+	const auto rotation = photo->owner().mediaRotation().get(photo);
+	const auto rotate = !_opengl && !UsePainterRotation(rotation);
+	const auto weak = Ui::MakeWeak(_widget);
+	crl::async([=, original = large->original()]() mutable {
+		auto result = PreparedStatic{
+			.image = Images::Prepare(std::move(original), size, {}),
+		};
+		constexpr auto kGood = QImage::Format_ARGB32_Premultiplied;
+		if (!result.image.isNull()
+			&& result.image.format() != kGood
+			&& result.image.format() != QImage::Format_RGB32) {
+			result.image = std::move(result.image).convertToFormat(kGood);
+		}
+		result.image.setDevicePixelRatio(ratio);
+		result.transparent = IsSemitransparent(result.image);
+		if (rotate) {
+			result.rotated = RotateFrameImage(result.image, rotation);
+		}
+		result.ready = true;
+		crl::on_main(weak, [=, result = std::move(result)]() mutable {
+			const auto i = _preparedPhotos.find(photo);
+			if (i != end(_preparedPhotos) && !i->second.ready) {
+				i->second = std::move(result);
+			}
+		});
+	});
+}
+
+bool OverlayWidget::applyPreparedPhoto(QSize size) {
+	const auto i = _photo
+		? _preparedPhotos.find(_photo)
+		: end(_preparedPhotos);
+	if (i == end(_preparedPhotos)
+		|| !i->second.ready
+		|| i->second.image.size() != size) {
+		return false;
+	}
+	const auto &prepared = i->second;
+	_staticContent = prepared.image;
+	_staticContentTransparent = prepared.transparent;
+	if (!prepared.rotated.isNull()) {
+		_staticContentRotated = RotatedContent{
+			.image = prepared.rotated,
+			.key = _staticContent.cacheKey(),
+			.rotation = _rotation,
+		};
+	}
+	return true;
 }
 
 void OverlayWidget::handleMousePress(
@@ -6172,6 +6435,8 @@ void OverlayWidget::clearBeforeHide() {
 	assignMediaPointer(nullptr);
 	_preloadPhotos.clear();
 	_preloadDocuments.clear();
+	_preparedPhotos.clear();
+	_preparedPyramids.clear();
 	if (_menu) {
 		_menu->hideMenu(true);
 	}
@@ -6189,6 +6454,10 @@ void OverlayWidget::clearAfterHide() {
 	destroyThemePreview();
 	_radial.stop();
 	_staticContent = QImage();
+	_staticPyramid = nullptr;
+	_staticContentRotated = RotatedContent();
+	_preparedPhotos.clear();
+	_preparedPyramids.clear();
 	_themePreview = nullptr;
 	_themeApply.destroyDelayed();
 	_themeCancel.destroyDelayed();
@@ -78,6 +78,7 @@ struct ContentLayout;
 namespace Media::View {
 
 class GroupThumbs;
+class ImagePyramid;
 class Pip;
 
 class OverlayWidget final
@@ -185,6 +186,17 @@ private:
 		int roundRadius = 0;
 		bool topShadowShown = false;
 	};
+	struct PreparedStatic {
+		QImage image;
+		QImage rotated;
+		bool transparent = false;
+		bool ready = false;
+	};
+	struct RotatedContent {
+		QImage image;
+		qint64 key = 0;
+		int rotation = 0;
+	};
 	struct StartStreaming {
 		StartStreaming() : continueStreaming(false), startTime(0) {
 		}
@@ -308,6 +320,10 @@ private:
 	void updateGeometryToScreen(bool inMove = false);
 	bool moveToNext(int delta);
 	void preloadData(int delta);
+	void prepareNeighbours();
+	void preparePhotoAhead(not_null<PhotoData*> photo);
+	[[nodiscard]] bool applyPreparedPhoto(QSize size);
+	[[nodiscard]] bool applyPreparedPyramid();
 
 	void handleScreenChanged(QScreen *screen);
 
@@ -519,6 +535,17 @@ private:
 	[[nodiscard]] bool documentContentShown() const;
 	[[nodiscard]] bool documentBubbleShown() const;
 	void setStaticContent(QImage image);
+	void setStaticPyramid(QByteArray content);
+	void setStaticPyramidPlaceholder();
+	[[nodiscard]] std::unique_ptr<ImagePyramid> makeStaticPyramid(
+		not_null<DocumentData*> document,
+		QByteArray content) const;
+	void staticPyramidUpdated();
+	[[nodiscard]] QSize staticContentSize() const;
+	[[nodiscard]] bool staticDetailNeeded() const;
+	void validateStaticDetail();
+	[[nodiscard]] auto staticDetailGeometry() const
+		-> std::optional<ContentGeometry>;
 	[[nodiscard]] bool contentShown() const;
 	[[nodiscard]] bool opaqueContentShown() const;
 	void clearStreaming(bool savePosition = true);
@@ -556,6 +583,10 @@ private:
 	std::shared_ptr<Data::DocumentMedia> _documentMedia;
 	base::flat_set<std::shared_ptr<Data::PhotoMedia>> _preloadPhotos;
 	base::flat_set<std::shared_ptr<Data::DocumentMedia>> _preloadDocuments;
+	base::flat_map<not_null<PhotoData*>, PreparedStatic> _preparedPhotos;
+	base::flat_map<
+		not_null<DocumentData*>,
+		std::unique_ptr<ImagePyramid>> _preparedPyramids;
 	int _rotation = 0;
 	std::unique_ptr<SharedMedia> _sharedMedia;
 	std::optional<SharedMediaWithLastSlice> _sharedMediaData;
@@ -615,6 +646,8 @@ private:
 	int32 _dragging = 0;
 	QImage _staticContent;
 	bool _staticContentTransparent = false;
+	mutable RotatedContent _staticContentRotated;
+	std::unique_ptr<ImagePyramid> _staticPyramid;
 	bool _blurred = true;
 	bool _reShow = false;
 
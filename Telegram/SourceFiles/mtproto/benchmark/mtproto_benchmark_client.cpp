@@ -0,0 +1,529 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/benchmark/mtproto_benchmark_client.h"
+
+#include "mtproto/connection_tcp.h"
+#include "mtproto/mtproto_dc_options.h"
+#include "base/openssl_help.h"
+#include "base/random.h"
+#include "base/unixtime.h"
+
+namespace MTP::Benchmark {
+namespace {
+
+using namespace details;
+
+constexpr auto kTemporaryExpiresIn = TimeId(86400);
+constexpr auto kCheckSentEach = crl::time(100);
+constexpr auto kMaxFailedAttempts = 5;
+constexpr auto kUnknownKeyErrorCode = -404;
+
+// Same limits as the server applies to the incoming containers.
+constexpr auto kMaxContainerMessages = 1020;
+constexpr auto kMaxContainerSize = 1024 * 1024 / int(sizeof(mtpPrime));
+
+[[nodiscard]] QByteArray RandomBytes(int size) {
+	auto result = QByteArray(size, Qt::Uninitialized);
+	bytes::set_random(bytes::make_span(result));
+	return result;
+}
+
+[[nodiscard]] bytes::const_span MsgKeyPart(
+		const AuthKeyPtr &key,
+		bool send) {
+	return bytes::const_span(
+		static_cast<const bytes::type*>(key->partForMsgKey(send)),
+		32);
+}
+
+} // namespace
+
+Client::Client(not_null<DcOptions*> dcOptions, ClientSettings settings)
+: _dcOptions(dcOptions)
+, _settings(std::move(settings))
+, _payload(RandomBytes(_settings.payload))
+, _fileId(base::RandomValue<uint64>())
+, _sessionId(base::RandomValue<uint64>())
+, _checkSentTimer([=] { checkSentRequests(); }) {
+}
+
+Client::~Client() = default;
+
+void Client::start(Fn<void()> done) {
+	_done = std::move(done);
+	_started = crl::now();
+	_requests.reserve(_settings.requests);
+	connect();
+}
+
+const ClientReport &Client::report() const {
+	return _report;
+}
+
+void Client::connect() {
+	_connected = false;
+	_connection = ConnectionPointer::New<TcpConnection>(
+		QThread::currentThread(),
+		ProxyData());
+	const auto raw = _connection.get();
+	QObject::connect(raw, &AbstractConnection::connected, [=] {
+		connected();
+	});
+	QObject::connect(raw, &AbstractConnection::disconnected, [=] {
+		lost(0);
+	});
+	QObject::connect(raw, &AbstractConnection::error, [=](qint32 code) {
+		lost(code);
+	});
+	raw->connectToServer(
+		_settings.ip,
+		_settings.port,
+		_settings.secret,
+		int16(_settings.dcId),
+		false);
+}
+
+void Client::connected() {
+	_connected = true;
+	_failedAttempts = 0;
+	if (_lostAt) {
+		_report.reconnects.push_back(crl::now() - _lostAt);
+	}
+	if (!_key) {
+		createKey();
+	} else {
+		startSession();
+	}
+}
+
+void Client::lost(qint32 errorCode) {
+	if (_finished) {
+		return;
+	} else if (!_connected && ++_failedAttempts >= kMaxFailedAttempts) {
+		LOG(("Benchmark Error: Could not connect to %1:%2."
+			).arg(_settings.ip
+			).arg(_settings.port));
+		return finish(true);
+	}
+	if (errorCode == kUnknownKeyErrorCode) {
+		_key = nullptr;
+	}
+	_lostAt = crl::now();
+	_connected = false;
+	_checkSentTimer.cancel();
+	_keyCreator = std::nullopt;
+	_connection = nullptr;
+	resendAll();
+	connect();
+}
+
+void Client::createKey() {
+	_keyCreationStarted = crl::now();
+
+	auto delegate = DcKeyCreator::Delegate();
+	delegate.done = [=](base::expected<DcKeyResult, DcKeyError> result) {
+		keyCreated(std::move(result));
+	};
+	auto request = DcKeyRequest();
+	request.temporaryExpiresIn = kTemporaryExpiresIn;
+	_keyCreator.emplace(
+		_settings.dcId,
+		int16(_settings.dcId),
+		_connection.get(),
+		_dcOptions,
+		std::move(delegate),
+		request);
+}
+
+void Client::keyCreated(base::expected<DcKeyResult, DcKeyError> result) {
+	_keyCreator = std::nullopt;
+	if (!result) {
+		LOG(("Benchmark Error: Could not create the auth key."));
+		return finish(true);
+	}
+	_report.keyCreation = crl::now() - _keyCreationStarted;
+	_key = std::move(result->temporaryKey);
+	_salt = result->temporaryServerSalt;
+	startSession();
+}
+
+void Client::startSession() {
+	QObject::connect(
+		_connection.get(),
+		&AbstractConnection::receivedData,
+		[=] { handleReceived(); });
+	_checkSentTimer.callEach(kCheckSentEach);
+	tryToSend();
+}
+
+void Client::tryToSend() {
+	if (_finished || !_connected || !_key) {
+		return;
+	}
+	const auto now = crl::now();
+	auto messages = std::vector<SerializedRequest>();
+	auto containerSize = 0;
+	const auto flush = [&] {
+		if (!messages.empty()) {
+			sendPacket(base::take(messages));
+			containerSize = 0;
+		}
+	};
+	const auto add = [&](int index) {
+		auto &request = _requests[index];
+		auto &serialized = request.serialized;
+		const auto size = int(serialized.messageSize());
+		if (int(messages.size()) == kMaxContainerMessages
+			|| (!messages.empty() && containerSize + size > kMaxContainerSize)) {
+			flush();
+		}
+		const auto msgId = base::unixtime::mtproto_msg_id();
+		serialized.setMsgId(msgId);
+		serialized.setSeqNo(nextSeqNo(true));
+		request.lastSent = now;
+		_sentIds.emplace(msgId, index);
+		messages.push_back(serialized);
+		containerSize += size;
+	};
+	if (!_ackIds.isEmpty()) {
+		auto ack = SerializedRequest::Serialize(MTPMsgsAck(
+			MTP_msgs_ack(MTP_vector<MTPlong>(base::take(_ackIds)))));
+		ack.setMsgId(base::unixtime::mtproto_msg_id());
+		ack.setSeqNo(nextSeqNo(false));
+		containerSize += int(ack.messageSize());
+		messages.push_back(std::move(ack));
+	}
+	for (const auto index : base::take(_resend)) {
+		if (!_requests[index].answered) {
+			++_report.resent;
+			add(index);
+		}
+	}
+	while (_inflight < _settings.inflight
+		&& int(_requests.size()) < _settings.requests) {
+		const auto index = int(_requests.size());
+		_requests.push_back({
+			.serialized = prepareRequest(index),
+			.started = std::chrono::steady_clock::now(),
+		});
+		++_inflight;
+		add(index);
+	}
+	flush();
+}
+
+SerializedRequest Client::prepareRequest(int index) {
+	return SerializedRequest::Serialize(MTPupload_SaveFilePart(
+		MTP_long(_fileId),
+		MTP_int(index),
+		MTP_bytes(_payload)));
+}
+
+int32 Client::nextSeqNo(bool needAck) {
+	return needAck ? (2 * _seqNo++ + 1) : (2 * _seqNo);
+}
+
+void Client::sendPacket(std::vector<SerializedRequest> &&messages) {
+	Expects(!messages.empty());
+
+	// See SessionPrivate::tryToSend and SessionPrivate::sendSecureRequest.
+	auto request = SerializedRequest();
+	if (messages.size() == 1) {
+		request = std::move(messages.front());
+	} else {
+		auto containerSize = uint32(1 + 1); // cons + vector size
+		for (const auto &message : messages) {
+			containerSize += message.messageSize();
+		}
+		request = SerializedRequest::Prepare(containerSize);
+		request->push_back(mtpc_msg_container);
+		request->push_back(mtpPrime(messages.size()));
+		for (const auto &message : messages) {
+			const auto from = request->size();
+			const auto length = message.messageSize();
+			request->resize(from + length);
+			memcpy(
+				request->data() + from,
+				message->constData() + 4,
+				length * sizeof(mtpPrime));
+		}
+		request.setMsgId(base::unixtime::mtproto_msg_id());
+		request.setSeqNo(nextSeqNo(false));
+
+		++_report.containersSent;
+		_report.maxContainerMessages = std::max(
+			_report.maxContainerMessages,
+			int(messages.size()));
+	}
+	_report.messagesSent += int(messages.size());
+
+	request.addPadding(false);
+	const auto fullSize = uint32(request->size());
+	memcpy(request->data() + 0, &_salt, 2 * sizeof(mtpPrime));
+	memcpy(request->data() + 2, &_sessionId, 2 * sizeof(mtpPrime));
+
+	const auto hash = openssl::Sha256(
+		MsgKeyPart(_key, true),
+		bytes::make_span(*request));
+	const auto msgKey = *reinterpret_cast<const MTPint128*>(
+		hash.data() + 8);
+
+	const auto keyId = _key->keyId();
+	auto packet = _connection->prepareSecurePacket(keyId, msgKey, fullSize);
+	const auto prefix = packet.size();
+	packet.resize(prefix + fullSize);
+	aesIgeEncrypt(
+		request->constData(),
+		&packet[prefix],
+		fullSize * sizeof(mtpPrime),
+		_key,
+		msgKey);
+
+	++_report.packetsSent;
+	_report.bytesSent += (prefix + fullSize) * sizeof(mtpPrime);
+	_connection->setSentEncryptedWithKeyId(keyId);
+	_connection->sendData(std::move(packet));
+}
+
+void Client::checkSentRequests() {
+	const auto now = crl::now();
+	auto resending = false;
+	for (auto i = 0, count = int(_requests.size()); i != count; ++i) {
+		auto &request = _requests[i];
+		if (request.answered
+			|| !request.lastSent
+			|| request.lastSent + _settings.resendAfter > now) {
+			continue;
+		}
+		_sentIds.remove(request.serialized.getMsgId());
+		request.lastSent = 0;
+		_resend.push_back(i);
+		resending = true;
+	}
+	if (resending) {
+		tryToSend();
+	}
+}
+
+void Client::resendAll() {
+	for (auto i = 0, count = int(_requests.size()); i != count; ++i) {
+		auto &request = _requests[i];
+		if (request.answered || !request.lastSent) {
+			continue;
+		}
+		_sentIds.remove(request.serialized.getMsgId());
+		request.lastSent = 0;
+		_resend.push_back(i);
+	}
+}
+
+void Client::handleReceived() {
+	Expects(_key != nullptr);
+
+	// See SessionPrivate::handleReceived.
+	constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
+	constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
+	constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
+	constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
+	constexpr auto kMinPaddingSize = 12U;
+	constexpr auto kMaxPaddingSize = 1024U;
+
+	while (_connection && !_connection->received().empty()) {
+		const auto intsBuffer = std::move(_connection->received().front());
+		_connection->received().pop_front();
+
+		const auto intsCount = uint32(intsBuffer.size());
+		const auto ints = intsBuffer.constData();
+		_report.bytesReceived += intsCount * sizeof(mtpPrime);
+		if (intsCount < kMinimalIntsCount
+			|| *reinterpret_cast<const uint64*>(ints) != _key->keyId()) {
+			LOG(("Benchmark Error: Bad packet received."));
+			return lost(0);
+		}
+
+		const auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
+		const auto encryptedBytesCount = encryptedIntsCount * sizeof(mtpPrime);
+		auto decrypted = mtpBuffer(encryptedIntsCount);
+		auto msgKey = *reinterpret_cast<const MTPint128*>(ints + 2);
+		aesIgeDecrypt(
+			ints + kExternalHeaderIntsCount,
+			decrypted.data(),
+			encryptedBytesCount,
+			_key,
+			msgKey);
+
+		const auto hash = openssl::Sha256(
+			MsgKeyPart(_key, false),
+			bytes::make_span(decrypted));
+		const auto serverSalt = *reinterpret_cast<const uint64*>(&decrypted[0]);
+		const auto session = *reinterpret_cast<const uint64*>(&decrypted[2]);
+		const auto msgId = *reinterpret_cast<const mtpMsgId*>(&decrypted[4]);
+		const auto seqNo = uint32(decrypted[6]);
+		const auto messageLength = uint32(decrypted[7]);
+		const auto paddingSize = uint32(encryptedBytesCount)
+			- (kEncryptedHeaderIntsCount * sizeof(mtpPrime))
+			- messageLength;
+		if (bytes::compare(
+				bytes::make_span(hash).subspan(8, sizeof(msgKey)),
+				bytes::object_as_span(&msgKey))
+			|| (messageLength & 0x03)
+			|| (paddingSize < kMinPaddingSize)
+			|| (paddingSize > kMaxPaddingSize)
+			|| (session != _sessionId)) {
+			LOG(("Benchmark Error: Bad encrypted message received."));
+			return lost(0);
+		}
+		_salt = serverSalt;
+
+		const auto needAck = ((seqNo & 0x01) != 0);
+		const auto registered = _receivedIds.registerMsgId(msgId, needAck);
+		if (registered != ReceivedIdsManager::Result::Success) {
+			continue;
+		} else if (needAck) {
+			_ackIds.push_back(MTP_long(msgId));
+		}
+		const auto from = decrypted.constData() + kEncryptedHeaderIntsCount;
+		const auto end = from + (messageLength / sizeof(mtpPrime));
+		if (!handleMessage(from, end)) {
+			LOG(("Benchmark Error: Could not parse message %1.").arg(msgId));
+			return lost(0);
+		}
+	}
+	tryToSend();
+}
+
+bool Client::handleMessage(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	if (from >= end) {
+		return false;
+	}
+	switch (mtpTypeId(*from)) {
+	case mtpc_msg_container: {
+		if (++from >= end) {
+			return false;
+		}
+		const auto count = uint32(*from++);
+		for (auto i = 0U; i != count; ++i) {
+			if (from + 4 >= end) {
+				return false;
+			}
+			auto otherEnd = from + 4;
+			auto inMsgId = MTPlong();
+			auto inSeqNo = MTPint();
+			auto length = MTPint();
+			if (!inMsgId.read(from, otherEnd)
+				|| !inSeqNo.read(from, otherEnd)
+				|| !length.read(from, otherEnd)
+				|| (length.v & 0x03)
+				|| (length.v < 4)) {
+				return false;
+			}
+			otherEnd = from + (length.v >> 2);
+			if (otherEnd > end) {
+				return false;
+			}
+			const auto needAck = (inSeqNo.v & 0x01);
+			const auto registered = _receivedIds.registerMsgId(
+				inMsgId.v,
+				needAck);
+			if (registered == ReceivedIdsManager::Result::Success) {
+				if (needAck) {
+					_ackIds.push_back(inMsgId);
+				}
+				if (!handleMessage(from, otherEnd)) {
+					return false;
+				}
+			}
+			from = otherEnd;
+		}
+	} return true;
+
+	case mtpc_rpc_result: {
+		auto requestMsgId = MTPlong();
+		if (!requestMsgId.read(++from, end) || from >= end) {
+			return false;
+		} else if (mtpTypeId(*from) == mtpc_rpc_error) {
+			LOG(("Benchmark Error: Request %1 failed."
+				).arg(requestMsgId.v));
+			finish(true);
+			return true;
+		}
+		answered(requestMsgId.v);
+	} return true;
+
+	case mtpc_new_session_created: {
+		auto message = MTPNewSession();
+		if (!message.read(from, end)) {
+			return false;
+		}
+		_salt = message.c_new_session_created().vserver_salt().v;
+	} return true;
+
+	case mtpc_bad_server_salt: {
+		auto message = MTPBadMsgNotification();
+		if (!message.read(from, end)) {
+			return false;
+		}
+		_salt = message.c_bad_server_salt().vnew_server_salt().v;
+		resendAll();
+	} return true;
+
+	case mtpc_msgs_ack:
+	case mtpc_pong: return true;
+	}
+	LOG(("Benchmark Error: Unexpected message %1.").arg(mtpTypeId(*from)));
+	return true;
+}
+
+void Client::answered(mtpMsgId requestMsgId) {
+	const auto i = _sentIds.find(requestMsgId);
+	if (i == end(_sentIds)) {
+		++_report.lateAnswers;
+		return;
+	}
+	auto &request = _requests[i->second];
+	_sentIds.erase(i);
+	if (request.answered) {
+		++_report.lateAnswers;
+		return;
+	}
+	const auto latency = std::chrono::steady_clock::now() - request.started;
+	request.answered = true;
+	request.serialized = SerializedRequest();
+	--_inflight;
+
+	++_report.answered;
+	_report.latencies.push_back(
+		std::chrono::duration_cast<std::chrono::microseconds>(
+			latency).count());
+	if (_lostAt) {
+		_report.recoveries.push_back(crl::now() - _lostAt);
+		_lostAt = 0;
+	}
+	if (_report.answered == _settings.requests) {
+		finish(false);
+	}
+}
+
+void Client::finish(bool failed) {
+	if (_finished) {
+		return;
+	}
+	_finished = true;
+	_report.failed = failed;
+	_report.elapsed = crl::now() - _started;
+	_checkSentTimer.cancel();
+	_keyCreator = std::nullopt;
+	_connection = nullptr;
+	if (const auto done = base::take(_done)) {
+		done();
+	}
+}
+
+} // namespace MTP::Benchmark
@@ -0,0 +1,129 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/details/mtproto_dc_key_creator.h"
+#include "mtproto/details/mtproto_received_ids_manager.h"
+#include "mtproto/details/mtproto_serialized_request.h"
+#include "mtproto/connection_abstract.h"
+#include "mtproto/mtproto_auth_key.h"
+#include "base/timer.h"
+
+#include <chrono>
+
+namespace MTP {
+class DcOptions;
+} // namespace MTP
+
+namespace MTP::Benchmark {
+
+struct ClientSettings {
+	QString ip;
+	int port = 0;
+	bytes::vector secret;
+	DcId dcId = 0;
+
+	int requests = 1000;
+	int inflight = 32;
+	int payload = 4096;
+	crl::time resendAfter = 1000;
+};
+
+struct ClientReport {
+	bool failed = false;
+	crl::time keyCreation = 0;
+	crl::time elapsed = 0;
+	int answered = 0;
+	int resent = 0;
+	int lateAnswers = 0;
+	int64 bytesSent = 0;
+	int64 bytesReceived = 0;
+	int packetsSent = 0;
+	int containersSent = 0;
+	int messagesSent = 0;
+	int maxContainerMessages = 0;
+	std::vector<int64> latencies; // In microseconds.
+	std::vector<crl::time> reconnects; // Lost until connected.
+	std::vector<crl::time> recoveries; // Lost until the first answer.
+};
+
+// Uploads file parts to a single DC through the same TcpConnection,
+// DcKeyCreator and AuthKey the sessions use, packing the outgoing
+// messages into containers the way SessionPrivate::tryToSend does.
+class Client final {
+public:
+	Client(not_null<DcOptions*> dcOptions, ClientSettings settings);
+	~Client();
+
+	void start(Fn<void()> done);
+
+	[[nodiscard]] const ClientReport &report() const;
+
+private:
+	struct Request {
+		details::SerializedRequest serialized;
+		std::chrono::steady_clock::time_point started;
+		crl::time lastSent = 0;
+		bool answered = false;
+	};
+
+	void connect();
+	void connected();
+	void lost(qint32 errorCode);
+	void createKey();
+	void keyCreated(
+		base::expected<details::DcKeyResult, details::DcKeyError> result);
+	void startSession();
+
+	void tryToSend();
+	void sendPacket(std::vector<details::SerializedRequest> &&messages);
+	[[nodiscard]] details::SerializedRequest prepareRequest(int index);
+	[[nodiscard]] int32 nextSeqNo(bool needAck);
+	void checkSentRequests();
+	void resendAll();
+
+	void handleReceived();
+	[[nodiscard]] bool handleMessage(
+		const mtpPrime *from,
+		const mtpPrime *end);
+	void answered(mtpMsgId requestMsgId);
+	void finish(bool failed);
+
+	const not_null<DcOptions*> _dcOptions;
+	const ClientSettings _settings;
+	const QByteArray _payload;
+	const uint64 _fileId = 0;
+	Fn<void()> _done;
+
+	details::ConnectionPointer _connection;
+	std::optional<details::DcKeyCreator> _keyCreator;
+	AuthKeyPtr _key;
+	uint64 _salt = 0;
+	uint64 _sessionId = 0;
+	int32 _seqNo = 0;
+	details::ReceivedIdsManager _receivedIds;
+	QVector<MTPlong> _ackIds;
+
+	std::vector<Request> _requests;
+	base::flat_map<mtpMsgId, int> _sentIds;
+	std::vector<int> _resend;
+	int _inflight = 0;
+
+	base::Timer _checkSentTimer;
+	crl::time _started = 0;
+	crl::time _keyCreationStarted = 0;
+	crl::time _lostAt = 0;
+	int _failedAttempts = 0;
+	bool _connected = false;
+	bool _finished = false;
+
+	ClientReport _report;
+
+};
+
+} // namespace MTP::Benchmark
@@ -0,0 +1,1043 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/benchmark/mtproto_benchmark_fake_dc.h"
+
+#include "mtproto/details/mtproto_rsa_public_key.h"
+#include "mtproto/mtproto_dh_utils.h"
+#include "base/invoke_queued.h"
+#include "base/openssl_help.h"
+#include "base/random.h"
+#include "base/unixtime.h"
+#include "base/weak_ptr.h"
+
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpSocket>
+
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+
+namespace MTP::Benchmark {
+namespace {
+
+constexpr auto kConnectionStartPrefixSize = 64;
+constexpr auto kAbridgedProtocolId = 0xEFEFEFEFU;
+constexpr auto kPaddedIntermediateProtocolId = 0xDDDDDDDDU;
+constexpr auto kMaxPacketSize = int(0x01000000 * sizeof(mtpPrime));
+constexpr auto kRSAKeyBits = 2048;
+constexpr auto kRSABlockSize = 256;
+constexpr auto kDhGenerator = 3;
+constexpr auto kBadServerSaltCode = 48;
+constexpr auto kUnknownKeyErrorCode = -404;
+constexpr auto kExternalHeaderInts = 6U; // 2 auth_key_id, 4 msg_key
+constexpr auto kEncryptedHeaderInts = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
+constexpr auto kMinPaddingSize = 12U;
+constexpr auto kMaxPaddingSize = 1024U;
+
+// Small enough for the fast factorization path in the client.
+constexpr auto kP = uint32(0x494C553BU);
+constexpr auto kQ = uint32(0x53911073U);
+
+[[nodiscard]] QByteArray BigEndianBytes(uint64 value, int size) {
+	auto result = QByteArray(size, Qt::Uninitialized);
+	for (auto i = size; i != 0;) {
+		result[--i] = char(value & 0xFF);
+		value >>= 8;
+	}
+	return result;
+}
+
+template <typename Type>
+[[nodiscard]] mtpBuffer Serialize(const Type &value) {
+	auto result = mtpBuffer();
+	result.reserve(tl::count_length(value) >> 2);
+	value.write(result);
+	return result;
+}
+
+template <typename Result>
+[[nodiscard]] mtpBuffer SerializeRpcResult(
+		mtpMsgId requestId,
+		const Result &result) {
+	auto buffer = mtpBuffer();
+	buffer.reserve(3 + (tl::count_length(result) >> 2));
+	buffer.push_back(mtpc_rpc_result);
+	MTP_long(requestId).write(buffer);
+	result.write(buffer);
+	return buffer;
+}
+
+[[nodiscard]] uint32 CountPaddingInts(uint32 size) {
+	auto result = (size & 0x03) ? (4 - (size & 0x03)) : 0;
+	if (result < kMinPaddingSize / sizeof(mtpPrime)) {
+		result += 4;
+	}
+	return result;
+}
+
+[[nodiscard]] bool Chance(float64 chance) {
+	return (chance > 0.)
+		&& (base::RandomValue<uint32>() < chance * float64(0xFFFFFFFFU));
+}
+
+} // namespace
+
+class FakeDc::Connection final : public base::has_weak_ptr {
+public:
+	Connection(not_null<FakeDc*> dc, not_null<QTcpSocket*> socket);
+	~Connection();
+
+private:
+	enum class Framing {
+		Abridged,
+		PaddedIntermediate,
+	};
+	struct Handshake {
+		MTPint128 nonce;
+		MTPint128 serverNonce;
+		MTPint256 newNonce;
+		bytes::array<32> aesKey = { { bytes::type() } };
+		bytes::array<32> aesIV = { { bytes::type() } };
+		bytes::vector randomPower;
+		bool waitingClientDH = false;
+	};
+	struct Outgoing {
+		mtpBuffer body;
+		bool reply = false;
+		bool content = false;
+	};
+
+	static constexpr auto kUnknownSize = -1;
+	static constexpr auto kInvalidSize = -2;
+
+	void read();
+	[[nodiscard]] bool readStartPrefix();
+	void prepareKey(bytes::span key, bytes::const_span source) const;
+	void readPackets();
+	[[nodiscard]] int readPacketLength(bytes::const_span bytes) const;
+	void handlePacket(bytes::const_span packet);
+
+	void handleNotSecure(const mtpBuffer &buffer);
+	void handleReqPQ(const mtpPrime *from, const mtpPrime *end);
+	void handleReqDHParams(const mtpPrime *from, const mtpPrime *end);
+	void handleSetClientDHParams(const mtpPrime *from, const mtpPrime *end);
+	void prepareTemporaryAES();
+
+	void handleEncrypted(const mtpBuffer &buffer);
+	[[nodiscard]] bool handleMessage(
+		mtpMsgId msgId,
+		const mtpPrime *from,
+		const mtpPrime *end,
+		std::vector<Outgoing> &answers);
+
+	template <typename Answer>
+	void sendNotSecure(const Answer &answer);
+	void sendEncrypted(
+		uint64 keyId,
+		uint64 sessionId,
+		std::vector<Outgoing> &&messages);
+	void sendPacket(const mtpBuffer &packet);
+	void close();
+
+	const not_null<FakeDc*> _dc;
+	const not_null<QTcpSocket*> _socket;
+
+	bytes::vector _startPrefix;
+	bytes::vector _received;
+	Framing _framing = Framing::Abridged;
+	bytes::array<CTRState::KeySize> _sendKey = { { bytes::type() } };
+	bytes::array<CTRState::KeySize> _receiveKey = { { bytes::type() } };
+	CTRState _sendState;
+	CTRState _receiveState;
+	bool _started = false;
+	bool _closed = false;
+
+	Handshake _handshake;
+	mtpMsgId _lastNotSecureId = 0;
+	int _requestsReceived = 0;
+
+};
+
+FakeDc::Connection::Connection(
+	not_null<FakeDc*> dc,
+	not_null<QTcpSocket*> socket)
+: _dc(dc)
+, _socket(socket) {
+	QObject::connect(_socket, &QTcpSocket::readyRead, [=] {
+		read();
+	});
+	QObject::connect(_socket, &QTcpSocket::disconnected, [=] {
+		close();
+	});
+}
+
+FakeDc::Connection::~Connection() {
+	_socket->disconnect();
+	_socket->abort();
+	_socket->deleteLater();
+}
+
+void FakeDc::Connection::read() {
+	auto data = _socket->readAll();
+	auto received = bytes::make_span(data);
+	if (!_started) {
+		const auto missing = kConnectionStartPrefixSize
+			- int(_startPrefix.size());
+		const auto part = received.subspan(
+			0,
+			std::min(missing, int(received.size())));
+		_startPrefix.insert(end(_startPrefix), part.begin(), part.end());
+		received = received.subspan(part.size());
+		if (_startPrefix.size() < kConnectionStartPrefixSize) {
+			return;
+		} else if (!readStartPrefix()) {
+			return close();
+		}
+	}
+	if (!received.empty()) {
+		aesCtrEncrypt(received, _receiveKey.data(), &_receiveState);
+		_received.insert(end(_received), received.begin(), received.end());
+	}
+	readPackets();
+}
+
+bool FakeDc::Connection::readStartPrefix() {
+	// Mirror of TcpConnection::prepareConnectionStartPrefix.
+	const auto nonce = bytes::make_span(_startPrefix);
+	prepareKey(
+		bytes::make_span(_receiveKey),
+		nonce.subspan(8, CTRState::KeySize));
+	bytes::copy(
+		bytes::make_span(_receiveState.ivec),
+		nonce.subspan(8 + CTRState::KeySize, CTRState::IvecSize));
+
+	auto reversedBytes = bytes::vector(48);
+	const auto reversed = bytes::make_span(reversedBytes);
+	bytes::copy(reversed, nonce.subspan(8, reversed.size()));
+	std::reverse(reversed.begin(), reversed.end());
+	prepareKey(
+		bytes::make_span(_sendKey),
+		reversed.subspan(0, CTRState::KeySize));
+	bytes::copy(
+		bytes::make_span(_sendState.ivec),
+		reversed.subspan(CTRState::KeySize, CTRState::IvecSize));
+
+	aesCtrEncrypt(nonce, _receiveKey.data(), &_receiveState);
+	const auto protocol = *reinterpret_cast<const uint32*>(
+		nonce.data() + 56);
+	const auto dcId = *reinterpret_cast<const int16*>(nonce.data() + 60);
+	_startPrefix.clear();
+
+	const auto padded = (_dc->_secret.size() == 17);
+	if (dcId != _dc->_dcId) {
+		LOG(("Fake DC Error: Connection to dc %1 instead of %2."
+			).arg(dcId
+			).arg(_dc->_dcId));
+		return false;
+	} else if (protocol == kPaddedIntermediateProtocolId && padded) {
+		_framing = Framing::PaddedIntermediate;
+	} else if (protocol == kAbridgedProtocolId && !padded) {
+		_framing = Framing::Abridged;
+	} else {
+		LOG(("Fake DC Error: Unexpected protocol %1.").arg(protocol));
+		return false;
+	}
+	_started = true;
+	return true;
+}
+
+void FakeDc::Connection::prepareKey(
+		bytes::span key,
+		bytes::const_span source) const {
+	// See TcpConnection::Protocol::Create.
+	const auto secret = bytes::make_span(_dc->_secret);
+	if (secret.empty()) {
+		bytes::copy(key, source);
+		return;
+	}
+	const auto part = (secret.size() == 17)
+		? secret.subspan(1, 16)
+		: secret;
+	bytes::copy(key, openssl::Sha256(bytes::concatenate(source, part)));
+}
+
+int FakeDc::Connection::readPacketLength(bytes::const_span bytes) const {
+	if (_framing == Framing::PaddedIntermediate) {
+		if (bytes.size() < 4) {
+			return kUnknownSize;
+		}
+		const auto value = *reinterpret_cast<const uint32*>(bytes.data());
+		return (value >= 8 && value < kMaxPacketSize)
+			? int(value) + 4
+			: kInvalidSize;
+	} else if (bytes.empty()) {
+		return kUnknownSize;
+	}
+	const auto first = static_cast<uint32>(bytes[0]);
+	if (first == 0x7F) {
+		if (bytes.size() < 4) {
+			return kUnknownSize;
+		}
+		const auto ints = static_cast<uint32>(bytes[1])
+			| (static_cast<uint32>(bytes[2]) << 8)
+			| (static_cast<uint32>(bytes[3]) << 16);
+		return (ints >= 0x7F) ? (int(ints << 2) + 4) : kInvalidSize;
+	} else if (first > 0 && first < 0x7F) {
+		return int(first << 2) + 1;
+	}
+	return kInvalidSize;
+}
+
+void FakeDc::Connection::readPackets() {
+	auto available = bytes::make_span(_received);
+	auto processed = 0;
+	while (!_closed) {
+		const auto size = readPacketLength(available);
+		if (size == kUnknownSize || size > available.size()) {
+			break;
+		} else if (size == kInvalidSize) {
+			LOG(("Fake DC Error: Bad packet length."));
+			return close();
+		}
+		const auto header = (_framing == Framing::PaddedIntermediate)
+			? 4
+			: (static_cast<uint32>(available[0]) == 0x7F)
+			? 4
+			: 1;
+		handlePacket(available.subspan(header, size - header));
+		available = available.subspan(size);
+		processed += size;
+	}
+	if (!_closed) {
+		_received.erase(begin(_received), begin(_received) + processed);
+	}
+}
+
+void FakeDc::Connection::handlePacket(bytes::const_span packet) {
+	// The padded intermediate framing appends up to 15 random bytes.
+	auto buffer = mtpBuffer(packet.size() / sizeof(mtpPrime));
+	if (buffer.size() < 5) {
+		LOG(("Fake DC Error: Too short packet %1.").arg(packet.size()));
+		return close();
+	}
+	bytes::copy(bytes::make_span(buffer), packet);
+	if (*reinterpret_cast<const uint64*>(buffer.constData()) == 0) {
+		handleNotSecure(buffer);
+	} else {
+		handleEncrypted(buffer);
+	}
+}
+
+void FakeDc::Connection::handleNotSecure(const mtpBuffer &buffer) {
+	// auth_key_id, message_id, message_length, message_data.
+	const auto length = uint32(buffer[4]);
+	if ((length & 0x03)
+		|| !length
+		|| (length >> 2) > uint32(buffer.size() - 5)) {
+		LOG(("Fake DC Error: Bad not secure length %1.").arg(length));
+		return close();
+	}
+	const auto from = buffer.constData() + 5;
+	const auto end = from + (length >> 2);
+	switch (mtpTypeId(*from)) {
+	case mtpc_req_pq:
+	case mtpc_req_pq_multi: return handleReqPQ(from + 1, end);
+	case mtpc_req_DH_params: return handleReqDHParams(from + 1, end);
+	case mtpc_set_client_DH_params:
+		return handleSetClientDHParams(from + 1, end);
+	}
+	LOG(("Fake DC Error: Unexpected not secure request %1."
+		).arg(mtpTypeId(*from)));
+	close();
+}
+
+void FakeDc::Connection::handleReqPQ(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	auto nonce = MTPint128();
+	if (!nonce.read(from, end)) {
+		return close();
+	}
+
+	// TcpConnection checks the transport with a req_pq first,
+	// DcKeyCreator starts over with its own req_pq_multi.
+	_handshake = Handshake();
+	_handshake.nonce = nonce;
+	_handshake.serverNonce = base::RandomValue<MTPint128>();
+	sendNotSecure(MTPResPQ(MTP_resPQ(
+		_handshake.nonce,
+		_handshake.serverNonce,
+		MTP_bytes(BigEndianBytes(uint64(kP) * kQ, 8)),
+		MTP_vector<MTPlong>(1, MTP_long(_dc->_fingerprint)))));
+}
+
+void FakeDc::Connection::handleReqDHParams(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	auto nonce = MTPint128();
+	auto serverNonce = MTPint128();
+	auto p = MTPbytes();
+	auto q = MTPbytes();
+	auto fingerprint = MTPlong();
+	auto encrypted = MTPbytes();
+	if (!nonce.read(from, end)
+		|| !serverNonce.read(from, end)
+		|| !p.read(from, end)
+		|| !q.read(from, end)
+		|| !fingerprint.read(from, end)
+		|| !encrypted.read(from, end)) {
+		return close();
+	} else if (nonce != _handshake.nonce
+		|| serverNonce != _handshake.serverNonce
+		|| static_cast<uint64>(fingerprint.v) != _dc->_fingerprint
+		|| p.v != BigEndianBytes(kP, 4)
+		|| q.v != BigEndianBytes(kQ, 4)) {
+		LOG(("Fake DC Error: Bad req_DH_params."));
+		return close();
+	}
+
+	const auto decrypted = _dc->decryptRSA(bytes::make_span(encrypted.v));
+	if (decrypted.size() != kRSABlockSize) {
+		return close();
+	}
+
+	// key_aes_encrypted := temp_key_xor + aes_encrypted;
+	constexpr auto kKeySize = 32;
+	const auto keyXor = bytes::make_span(decrypted).subspan(0, kKeySize);
+	const auto aesEncrypted = bytes::make_span(decrypted).subspan(kKeySize);
+	const auto aesHash = openssl::Sha256(aesEncrypted);
+	auto tempKey = bytes::array<kKeySize>();
+	for (auto i = 0; i != kKeySize; ++i) {
+		tempKey[i] = keyXor[i] ^ aesHash[i];
+	}
+	auto dataWithHash = mtpBuffer(aesEncrypted.size() / sizeof(mtpPrime));
+	const auto tempIv = bytes::array<kKeySize>{ { bytes::type(0) } };
+	aesIgeDecryptRaw(
+		aesEncrypted.data(),
+		dataWithHash.data(),
+		aesEncrypted.size(),
+		tempKey.data(),
+		tempIv.data());
+
+	// data_with_hash := BYTE_REVERSE(data_with_padding)
+	//	+ SHA256(temp_key + data_with_padding);
+	constexpr auto kDataWithPaddingPrimes = 192 / sizeof(mtpPrime);
+	auto dataWithPadding = dataWithHash.mid(0, kDataWithPaddingPrimes);
+	ranges::reverse(bytes::make_span(dataWithPadding));
+	const auto hash = openssl::Sha256(
+		tempKey,
+		bytes::make_span(dataWithPadding));
+	if (bytes::compare(
+			hash,
+			bytes::make_span(dataWithHash).subspan(
+				kDataWithPaddingPrimes * sizeof(mtpPrime)))) {
+		LOG(("Fake DC Error: Bad p_q_inner_data hash."));
+		return close();
+	}
+
+	auto inner = MTPP_Q_inner_data();
+	auto innerFrom = dataWithPadding.constData();
+	const auto innerEnd = innerFrom + dataWithPadding.size();
+	if (!inner.read(innerFrom, innerEnd)) {
+		return close();
+	}
+	const auto valid = inner.match([&](const auto &data) {
+		_handshake.newNonce = data.vnew_nonce();
+		return (data.vnonce() == _handshake.nonce)
+			&& (data.vserver_nonce() == _handshake.serverNonce);
+	});
+	if (!valid) {
+		LOG(("Fake DC Error: Bad nonce in p_q_inner_data."));
+		return close();
+	}
+	prepareTemporaryAES();
+
+	auto randomSeed = bytes::vector(ModExpFirst::kRandomPowerSize);
+	bytes::set_random(randomSeed);
+	auto g_a = CreateModExp(kDhGenerator, KnownGoodPrime(), randomSeed);
+	if (g_a.modexp.empty()) {
+		return close();
+	}
+	_handshake.randomPower = std::move(g_a.randomPower);
+
+	const auto answer = MTPServer_DH_inner_data(MTP_server_DH_inner_data(
+		_handshake.nonce,
+		_handshake.serverNonce,
+		MTP_int(kDhGenerator),
+		MTP_bytes(KnownGoodPrime()),
+		MTP_bytes(g_a.modexp),
+		MTP_int(base::unixtime::now())));
+
+	// encrypted_answer := AES256_IGE(SHA1(answer) + answer + padding).
+	constexpr auto kSkipPrimes = openssl::kSha1Size / sizeof(mtpPrime);
+	const auto answerSize = tl::count_length(answer);
+	auto buffer = mtpBuffer();
+	buffer.reserve(kSkipPrimes + (answerSize >> 2) + 3);
+	buffer.resize(kSkipPrimes);
+	answer.write(buffer);
+	const auto dataSize = buffer.size();
+	buffer.resize((dataSize + 3) & ~0x03);
+	const auto span = bytes::make_span(buffer);
+	bytes::copy(
+		span,
+		openssl::Sha1(span.subspan(
+			kSkipPrimes * sizeof(mtpPrime),
+			answerSize)));
+	bytes::set_random(span.subspan(dataSize * sizeof(mtpPrime)));
+
+	auto encryptedAnswer = QByteArray(int(span.size()), Qt::Uninitialized);
+	aesIgeEncryptRaw(
+		span.data(),
+		encryptedAnswer.data(),
+		span.size(),
+		_handshake.aesKey.data(),
+		_handshake.aesIV.data());
+
+	_handshake.waitingClientDH = true;
+	sendNotSecure(MTPServer_DH_Params(MTP_server_DH_params_ok(
+		_handshake.nonce,
+		_handshake.serverNonce,
+		MTP_bytes(encryptedAnswer))));
+}
+
+void FakeDc::Connection::prepareTemporaryAES() {
+	const auto newNonce = bytes::object_as_span(&_handshake.newNonce);
+	const auto serverNonce = bytes::object_as_span(&_handshake.serverNonce);
+	const auto sha1ns = openssl::Sha1(
+		bytes::concatenate(newNonce, serverNonce));
+	const auto sha1sn = openssl::Sha1(
+		bytes::concatenate(serverNonce, newNonce));
+	const auto sha1nn = openssl::Sha1(
+		bytes::concatenate(newNonce, newNonce));
+
+	const auto aesKey = bytes::make_span(_handshake.aesKey);
+	const auto aesIV = bytes::make_span(_handshake.aesIV);
+	bytes::copy(aesKey, bytes::make_span(sha1ns).subspan(0, 20));
+	bytes::copy(aesKey.subspan(20), bytes::make_span(sha1sn).subspan(0, 12));
+	bytes::copy(aesIV, bytes::make_span(sha1sn).subspan(12, 8));
+	bytes::copy(aesIV.subspan(8), bytes::make_span(sha1nn).subspan(0, 20));
+	bytes::copy(aesIV.subspan(28), newNonce.subspan(0, 4));
+}
+
+void FakeDc::Connection::handleSetClientDHParams(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	auto nonce = MTPint128();
+	auto serverNonce = MTPint128();
+	auto encrypted = MTPbytes();
+	if (!nonce.read(from, end)
+		|| !serverNonce.read(from, end)
+		|| !encrypted.read(from, end)) {
+		return close();
+	} else if (!_handshake.waitingClientDH
+		|| nonce != _handshake.nonce
+		|| serverNonce != _handshake.serverNonce
+		|| (encrypted.v.size() & 0x0F)
+		|| encrypted.v.isEmpty()) {
+		LOG(("Fake DC Error: Bad set_client_DH_params."));
+		return close();
+	}
+
+	auto decrypted = mtpBuffer(encrypted.v.size() / sizeof(mtpPrime));
+	aesIgeDecryptRaw(
+		encrypted.v.constData(),
+		decrypted.data(),
+		encrypted.v.size(),
+		_handshake.aesKey.data(),
+		_handshake.aesIV.data());
+
+	constexpr auto kSkipPrimes = openssl::kSha1Size / sizeof(mtpPrime);
+	const auto innerStart = decrypted.constData() + kSkipPrimes;
+	auto innerFrom = innerStart;
+	auto inner = MTPClient_DH_Inner_Data();
+	if (!inner.read(innerFrom, decrypted.constData() + decrypted.size())) {
+		return close();
+	}
+	const auto span = bytes::make_span(decrypted);
+	const auto hash = openssl::Sha1(span.subspan(
+		kSkipPrimes * sizeof(mtpPrime),
+		(innerFrom - innerStart) * sizeof(mtpPrime)));
+	const auto &data = inner.c_client_DH_inner_data();
+	if (bytes::compare(hash, span.subspan(0, openssl::kSha1Size))
+		|| data.vnonce() != nonce
+		|| data.vserver_nonce() != serverNonce) {
+		LOG(("Fake DC Error: Bad client_DH_inner_data."));
+		return close();
+	}
+
+	const auto computedAuthKey = CreateAuthKey(
+		bytes::make_span(data.vg_b().v),
+		_handshake.randomPower,
+		KnownGoodPrime());
+	if (computedAuthKey.empty()) {
+		LOG(("Fake DC Error: Bad g_b."));
+		return close();
+	}
+	auto authKey = AuthKey::Data();
+	AuthKey::FillData(authKey, computedAuthKey);
+	const auto key = std::make_shared<AuthKey>(
+		AuthKey::Type::Generated,
+		_dc->_dcId,
+		authKey);
+
+	// new_nonce_hash1 := SHA1(new_nonce + 0x01 + auth_key_aux_hash).
+	auto newNonceBuffer = bytes::array<41>();
+	const auto newNonce = bytes::object_as_span(&_handshake.newNonce);
+	bytes::copy(newNonceBuffer, newNonce);
+	newNonceBuffer[32] = bytes::type(1);
+	bytes::copy(
+		bytes::make_span(newNonceBuffer).subspan(33),
+		bytes::make_span(openssl::Sha1(key->data())).subspan(0, 8));
+	const auto newNonceHash = openssl::Sha1(newNonceBuffer);
+
+	const auto salt = _handshake.newNonce.l.l ^ _handshake.serverNonce.l;
+	_dc->registerKey(key, salt);
+	_handshake = Handshake();
+
+	sendNotSecure(MTPSet_client_DH_params_answer(MTP_dh_gen_ok(
+		nonce,
+		serverNonce,
+		*reinterpret_cast<const MTPint128*>(newNonceHash.data() + 4))));
+}
+
+void FakeDc::Connection::handleEncrypted(const mtpBuffer &buffer) {
+	const auto keyId = *reinterpret_cast<const uint64*>(buffer.constData());
+	const auto found = _dc->findKey(keyId);
+	if (!found) {
+		// The client drops the connection and creates a new key.
+		sendPacket(mtpBuffer(1, kUnknownKeyErrorCode));
+		return;
+	}
+	const auto &key = found->key;
+	const auto intsCount = uint32(buffer.size());
+	if (intsCount < kExternalHeaderInts + kEncryptedHeaderInts + 4) {
+		LOG(("Fake DC Error: Too short encrypted packet."));
+		return close();
+	}
+	++_dc->_stats.packetsReceived;
+	if (Chance(_dc->_script.dropChance)) {
+		++_dc->_stats.packetsDropped;
+		return;
+	}
+
+	const auto encryptedInts = (intsCount - kExternalHeaderInts) & ~0x03U;
+	const auto encryptedBytes = encryptedInts * sizeof(mtpPrime);
+	auto msgKey = *reinterpret_cast<const MTPint128*>(buffer.constData() + 2);
+	auto decrypted = mtpBuffer(encryptedInts);
+	auto aesKey = MTPint256();
+	auto aesIV = MTPint256();
+	key->prepareAES(msgKey, aesKey, aesIV, true);
+	aesIgeDecryptRaw(
+		buffer.constData() + kExternalHeaderInts,
+		decrypted.data(),
+		encryptedBytes,
+		&aesKey,
+		&aesIV);
+
+	const auto hash = openssl::Sha256(
+		bytes::const_span(
+			static_cast<const bytes::type*>(key->partForMsgKey(true)),
+			32),
+		bytes::make_span(decrypted));
+	const auto salt = *reinterpret_cast<const uint64*>(&decrypted[0]);
+	const auto sessionId = *reinterpret_cast<const uint64*>(&decrypted[2]);
+	const auto msgId = *reinterpret_cast<const mtpMsgId*>(&decrypted[4]);
+	const auto seqNo = decrypted[6];
+	const auto length = uint32(decrypted[7]);
+	const auto paddingSize = uint32(encryptedBytes)
+		- (kEncryptedHeaderInts * sizeof(mtpPrime))
+		- length;
+	if (bytes::compare(
+			bytes::make_span(hash).subspan(8, sizeof(msgKey)),
+			bytes::object_as_span(&msgKey))) {
+		LOG(("Fake DC Error: Bad msg_key."));
+		return close();
+	} else if ((length & 0x03)
+		|| (length > encryptedBytes)
+		|| (paddingSize < kMinPaddingSize)
+		|| (paddingSize > kMaxPaddingSize)) {
+		LOG(("Fake DC Error: Bad msg_len %1.").arg(length));
+		return close();
+	}
+
+	auto answers = std::vector<Outgoing>();
+	if (!_dc->findSession(keyId, sessionId)) {
+		_dc->createSession(keyId, sessionId);
+		answers.push_back({
+			Serialize(MTPNewSession(MTP_new_session_created(
+				MTP_long(msgId),
+				MTP_long(base::RandomValue<uint64>()),
+				MTP_long(found->salt)))),
+			false,
+			true,
+		});
+	}
+	if (salt != found->salt) {
+		answers.push_back({
+			Serialize(MTPBadMsgNotification(MTP_bad_server_salt(
+				MTP_long(msgId),
+				MTP_int(seqNo),
+				MTP_int(kBadServerSaltCode),
+				MTP_long(found->salt)))),
+			true,
+			false,
+		});
+		return sendEncrypted(keyId, sessionId, std::move(answers));
+	}
+
+	auto from = decrypted.constData() + kEncryptedHeaderInts;
+	const auto end = from + (length >> 2);
+	if (mtpTypeId(*from) != mtpc_msg_container) {
+		if (!handleMessage(msgId, from, end, answers)) {
+			return close();
+		}
+	} else {
+		++_dc->_stats.containersReceived;
+		if (++from >= end) {
+			return close();
+		}
+		const auto count = uint32(*from++);
+		for (auto i = 0U; i != count; ++i) {
+			// msg_id, seq_no, bytes, body.
+			if (from + 4 >= end) {
+				return close();
+			}
+			const auto innerId = *reinterpret_cast<const mtpMsgId*>(from);
+			const auto innerLength = uint32(from[3]);
+			const auto innerEnd = from + 4 + (innerLength >> 2);
+			if ((innerLength & 0x03) || innerEnd > end) {
+				return close();
+			} else if (!handleMessage(innerId, from + 4, innerEnd, answers)) {
+				return close();
+			}
+			from = innerEnd;
+		}
+	}
+
+	const auto disconnectEvery = _dc->_script.disconnectEvery;
+	if (disconnectEvery > 0 && _requestsReceived >= disconnectEvery) {
+		++_dc->_stats.disconnects;
+		return close();
+	}
+	const auto delay = _dc->_script.answerDelay;
+	if (delay > 0) {
+		QTimer::singleShot(int(delay), _socket, crl::guard(this, [=] {
+			auto copy = answers;
+			sendEncrypted(keyId, sessionId, std::move(copy));
+		}));
+	} else {
+		sendEncrypted(keyId, sessionId, std::move(answers));
+	}
+}
+
+bool FakeDc::Connection::handleMessage(
+		mtpMsgId msgId,
+		const mtpPrime *from,
+		const mtpPrime *end,
+		std::vector<Outgoing> &answers) {
+	if (from >= end) {
+		return false;
+	}
+	++_dc->_stats.messagesReceived;
+	switch (mtpTypeId(*from++)) {
+	case mtpc_upload_saveFilePart: {
+		auto fileId = MTPlong();
+		auto filePart = MTPint();
+		auto data = MTPbytes();
+		if (!fileId.read(from, end)
+			|| !filePart.read(from, end)
+			|| !data.read(from, end)) {
+			return false;
+		}
+		++_requestsReceived;
+		++_dc->_stats.requestsReceived;
+		answers.push_back({
+			SerializeRpcResult(msgId, MTPBool(MTP_boolTrue())),
+			true,
+			true,
+		});
+	} return true;
+
+	case mtpc_ping: {
+		auto pingId = MTPlong();
+		if (!pingId.read(from, end)) {
+			return false;
+		}
+		answers.push_back({
+			Serialize(MTPPong(MTP_pong(MTP_long(msgId), pingId))),
+			true,
+			true,
+		});
+	} return true;
+
+	case mtpc_msgs_ack: return true;
+	}
+	answers.push_back({
+		SerializeRpcResult(msgId, MTPRpcError(MTP_rpc_error(
+			MTP_int(400),
+			MTP_string("METHOD_NOT_SUPPORTED")))),
+		true,
+		true,
+	});
+	return true;
+}
+
+template <typename Answer>
+void FakeDc::Connection::sendNotSecure(const Answer &answer) {
+	// auth_key_id, message_id, message_length, message_data.
+	auto packet = mtpBuffer(5, 0);
+	const auto msgId = std::max(
+		mtpMsgId(base::unixtime::now()) << 32,
+		(_lastNotSecureId & ~mtpMsgId(0x03)) + 4);
+	_lastNotSecureId = msgId | 1;
+	*reinterpret_cast<mtpMsgId*>(&packet[2]) = _lastNotSecureId;
+	answer.write(packet);
+	packet[4] = mtpPrime((packet.size() - 5) * sizeof(mtpPrime));
+	sendPacket(packet);
+}
+
+void FakeDc::Connection::sendEncrypted(
+		uint64 keyId,
+		uint64 sessionId,
+		std::vector<Outgoing> &&messages) {
+	const auto found = _dc->findKey(keyId);
+	const auto session = _dc->findSession(keyId, sessionId);
+	if (_closed || !found || !session || messages.empty()) {
+		return;
+	}
+
+	auto data = mtpBuffer(kEncryptedHeaderInts, 0);
+	auto msgId = mtpMsgId();
+	auto seqNo = int32();
+	if (messages.size() == 1) {
+		const auto &message = messages.front();
+		msgId = session->nextMessageId(message.reply);
+		seqNo = session->nextSeqNo(message.content);
+		data.append(message.body);
+	} else {
+		data.push_back(mtpc_msg_container);
+		data.push_back(int32(messages.size()));
+		for (const auto &message : messages) {
+			const auto from = data.size();
+			data.resize(from + 4);
+			const auto id = session->nextMessageId(message.reply);
+			*reinterpret_cast<mtpMsgId*>(&data[from]) = id;
+			data[from + 2] = session->nextSeqNo(message.content);
+			data[from + 3] = mtpPrime(message.body.size() * sizeof(mtpPrime));
+			data.append(message.body);
+		}
+		msgId = session->nextMessageId(false);
+		seqNo = session->nextSeqNo(false);
+	}
+	const auto length = uint32(data.size() - kEncryptedHeaderInts);
+	*reinterpret_cast<uint64*>(&data[0]) = found->salt;
+	*reinterpret_cast<uint64*>(&data[2]) = sessionId;
+	*reinterpret_cast<mtpMsgId*>(&data[4]) = msgId;
+	data[6] = seqNo;
+	data[7] = mtpPrime(length * sizeof(mtpPrime));
+
+	const auto padding = CountPaddingInts(uint32(data.size()));
+	const auto fullSize = data.size() + padding;
+	data.resize(fullSize);
+	bytes::set_random(bytes::make_span(data).subspan(
+		(fullSize - padding) * sizeof(mtpPrime)));
+
+	const auto &key = found->key;
+	const auto hash = openssl::Sha256(
+		bytes::const_span(
+			static_cast<const bytes::type*>(key->partForMsgKey(false)),
+			32),
+		bytes::make_span(data));
+	auto msgKey = *reinterpret_cast<const MTPint128*>(hash.data() + 8);
+	auto aesKey = MTPint256();
+	auto aesIV = MTPint256();
+	key->prepareAES(msgKey, aesKey, aesIV, false);
+
+	auto packet = mtpBuffer(kExternalHeaderInts + fullSize);
+	*reinterpret_cast<uint64*>(&packet[0]) = keyId;
+	*reinterpret_cast<MTPint128*>(&packet[2]) = msgKey;
+	aesIgeEncryptRaw(
+		data.constData(),
+		packet.data() + kExternalHeaderInts,
+		fullSize * sizeof(mtpPrime),
+		&aesKey,
+		&aesIV);
+	sendPacket(packet);
+}
+
+void FakeDc::Connection::sendPacket(const mtpBuffer &packet) {
+	const auto ints = uint32(packet.size());
+	const auto size = ints * sizeof(mtpPrime);
+	auto data = QByteArray();
+	if (_framing == Framing::PaddedIntermediate) {
+		// Short packets are error codes, the client expects them unpadded.
+		const auto padding = (ints < 3)
+			? 0U
+			: (base::RandomValue<uint32>() & 0x0F);
+		const auto length = uint32(size + padding);
+		data.reserve(4 + length);
+		data.append(reinterpret_cast<const char*>(&length), 4);
+		data.append(reinterpret_cast<const char*>(packet.constData()), size);
+		auto random = QByteArray(int(padding), Qt::Uninitialized);
+		bytes::set_random(bytes::make_span(random));
+		data.append(random);
+	} else {
+		data.reserve(4 + size);
+		if (ints < 0x7F) {
+			data.append(char(ints));
+		} else {
+			data.append(char(0x7F));
+			data.append(char(ints & 0xFF));
+			data.append(char((ints >> 8) & 0xFF));
+			data.append(char((ints >> 16) & 0xFF));
+		}
+		data.append(reinterpret_cast<const char*>(packet.constData()), size);
+	}
+	aesCtrEncrypt(bytes::make_span(data), _sendKey.data(), &_sendState);
+	_socket->write(data);
+}
+
+void FakeDc::Connection::close() {
+	if (_closed) {
+		return;
+	}
+	_closed = true;
+	_socket->abort();
+	_dc->closed(this);
+}
+
+mtpMsgId FakeDc::Session::nextMessageId(bool reply) {
+	const auto next = std::max(
+		mtpMsgId(base::unixtime::now()) << 32,
+		(lastMessageId & ~mtpMsgId(0x03)) + 4);
+	lastMessageId = next | (reply ? 1 : 3);
+	return lastMessageId;
+}
+
+int32 FakeDc::Session::nextSeqNo(bool content) {
+	return content ? (2 * contentMessages++ + 1) : (2 * contentMessages);
+}
+
+void FakeDc::RSADeleter::operator()(rsa_st *value) {
+	RSA_free(value);
+}
+
+FakeDc::FakeDc(DcId dcId, bytes::const_span secret, FakeDcScript script)
+: _dcId(dcId)
+, _secret(bytes::make_vector(secret))
+, _script(script) {
+	Expects(_secret.empty()
+		|| _secret.size() == 16
+		|| (_secret.size() == 17 && _secret[0] == bytes::type(0xDD)));
+
+	generateKey();
+	QObject::connect(&_server, &QTcpServer::newConnection, [=] {
+		acceptConnections();
+	});
+}
+
+FakeDc::~FakeDc() = default;
+
+void FakeDc::generateKey() {
+	const auto exponent = BN_new();
+	BN_set_word(exponent, RSA_F4);
+	_rsa.reset(RSA_new());
+	const auto generated = RSA_generate_key_ex(
+		_rsa.get(),
+		kRSAKeyBits,
+		exponent,
+		nullptr);
+	BN_free(exponent);
+	Assert(generated == 1);
+
+	const auto bio = BIO_new(BIO_s_mem());
+	PEM_write_bio_RSAPublicKey(bio, _rsa.get());
+	char *data = nullptr;
+	const auto size = BIO_get_mem_data(bio, &data);
+	_publicKey = QByteArray(data, size);
+	BIO_free(bio);
+
+	const auto key = details::RSAPublicKey(bytes::make_span(_publicKey));
+	Assert(key.valid());
+	_fingerprint = key.fingerprint();
+}
+
+bool FakeDc::listen() {
+	return _server.listen(QHostAddress::LocalHost);
+}
+
+int FakeDc::port() const {
+	return _server.serverPort();
+}
+
+MTPCdnConfig FakeDc::cdnConfig() const {
+	return MTP_cdnConfig(MTP_vector<MTPCdnPublicKey>(
+		1,
+		MTP_cdnPublicKey(
+			MTP_int(_dcId),
+			MTP_string(_publicKey.toStdString()))));
+}
+
+const FakeDcStats &FakeDc::stats() const {
+	return _stats;
+}
+
+void FakeDc::acceptConnections() {
+	while (const auto socket = _server.nextPendingConnection()) {
+		++_stats.connections;
+		_connections.push_back(std::make_unique<Connection>(this, socket));
+	}
+}
+
+bytes::vector FakeDc::decryptRSA(bytes::const_span data) const {
+	if (data.size() != kRSABlockSize) {
+		return {};
+	}
+	auto result = bytes::vector(kRSABlockSize);
+	const auto size = RSA_private_decrypt(
+		kRSABlockSize,
+		reinterpret_cast<const unsigned char*>(data.data()),
+		reinterpret_cast<unsigned char*>(result.data()),
+		_rsa.get(),
+		RSA_NO_PADDING);
+	return (size == kRSABlockSize) ? result : bytes::vector();
+}
+
+auto FakeDc::findKey(uint64 keyId) const -> const Key* {
+	const auto i = _keys.find(keyId);
+	return (i != end(_keys)) ? &i->second : nullptr;
+}
+
+void FakeDc::registerKey(AuthKeyPtr key, uint64 salt) {
+	++_stats.keysCreated;
+	const auto keyId = key->keyId();
+	_keys[keyId] = Key{ std::move(key), salt };
+}
+
+auto FakeDc::findSession(uint64 keyId, uint64 sessionId) -> Session* {
+	const auto i = _sessions.find(std::make_pair(keyId, sessionId));
+	return (i != end(_sessions)) ? &i->second : nullptr;
+}
+
+auto FakeDc::createSession(uint64 keyId, uint64 sessionId) -> Session& {
+	return _sessions[std::make_pair(keyId, sessionId)];
+}
+
+void FakeDc::closed(not_null<Connection*> connection) {
+	// Called from the socket signal handlers, destroy it later.
+	InvokeQueued(&_server, [=] {
+		const auto i = ranges::find_if(_connections, [&](const auto &item) {
+			return (item.get() == connection.get());
+		});
+		if (i != end(_connections)) {
+			_connections.erase(i);
+		}
+	});
+}
+
+} // namespace MTP::Benchmark
@@ -0,0 +1,105 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/mtproto_auth_key.h"
+#include "base/bytes.h"
+#include "base/flat_map.h"
+
+#include <QtNetwork/QTcpServer>
+
+struct rsa_st;
+
+namespace MTP::Benchmark {
+
+struct FakeDcScript {
+	// Part of the encrypted packets the server silently ignores.
+	float64 dropChance = 0.;
+
+	// Abort the connection after receiving this many requests on it,
+	// losing the answers that were not written yet.
+	int disconnectEvery = 0;
+
+	crl::time answerDelay = 0;
+};
+
+struct FakeDcStats {
+	int connections = 0;
+	int keysCreated = 0;
+	int packetsReceived = 0;
+	int packetsDropped = 0;
+	int messagesReceived = 0;
+	int containersReceived = 0;
+	int requestsReceived = 0;
+	int disconnects = 0;
+};
+
+// A localhost server speaking the obfuscated TCP transport (abridged or
+// padded intermediate framing), creating auth keys the same way the real
+// DCs do and answering AES-IGE encrypted upload.saveFilePart and ping.
+class FakeDc final {
+public:
+	FakeDc(DcId dcId, bytes::const_span secret, FakeDcScript script);
+	~FakeDc();
+
+	[[nodiscard]] bool listen();
+	[[nodiscard]] int port() const;
+
+	// Apply with DcOptions::setCDNConfig so the client trusts our key.
+	[[nodiscard]] MTPCdnConfig cdnConfig() const;
+
+	[[nodiscard]] const FakeDcStats &stats() const;
+
+private:
+	class Connection;
+
+	struct Key {
+		AuthKeyPtr key;
+		uint64 salt = 0;
+	};
+
+	struct Session {
+		[[nodiscard]] mtpMsgId nextMessageId(bool reply);
+		[[nodiscard]] int32 nextSeqNo(bool content);
+
+		mtpMsgId lastMessageId = 0;
+		int32 contentMessages = 0;
+	};
+
+	struct RSADeleter {
+		void operator()(rsa_st *value);
+	};
+
+	void generateKey();
+	void acceptConnections();
+
+	[[nodiscard]] bytes::vector decryptRSA(bytes::const_span data) const;
+	[[nodiscard]] const Key *findKey(uint64 keyId) const;
+	void registerKey(AuthKeyPtr key, uint64 salt);
+	[[nodiscard]] Session *findSession(uint64 keyId, uint64 sessionId);
+	Session &createSession(uint64 keyId, uint64 sessionId);
+	void closed(not_null<Connection*> connection);
+
+	const DcId _dcId = 0;
+	const bytes::vector _secret;
+	const FakeDcScript _script;
+
+	QTcpServer _server;
+	std::unique_ptr<rsa_st, RSADeleter> _rsa;
+	QByteArray _publicKey;
+	uint64 _fingerprint = 0;
+
+	base::flat_map<uint64, Key> _keys;
+	base::flat_map<std::pair<uint64, uint64>, Session> _sessions;
+	std::vector<std::unique_ptr<Connection>> _connections;
+
+	FakeDcStats _stats;
+
+};
+
+} // namespace MTP::Benchmark
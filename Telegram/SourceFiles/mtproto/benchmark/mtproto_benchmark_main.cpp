@@ -0,0 +1,282 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/benchmark/mtproto_benchmark_client.h"
+#include "mtproto/benchmark/mtproto_benchmark_fake_dc.h"
+#include "mtproto/mtproto_dc_options.h"
+#include "base/integration.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+
+#include <cstdio>
+
+namespace {
+
+constexpr auto kDcId = MTP::DcId(2);
+constexpr auto kSecretSize = 16;
+constexpr auto kPaddedSecretMarker = bytes::type(0xDD);
+
+bool DebugEnabledValue = false;
+
+void Print(const QString &line) {
+	fprintf(stderr, "%s\n", line.toUtf8().constData());
+	fflush(stderr);
+}
+
+class Integration final : public base::Integration {
+public:
+	Integration(int argc, char *argv[]) : base::Integration(argc, argv) {
+	}
+
+	void enterFromEventLoop(FnMut<void()> &&method) override {
+		method();
+	}
+	bool logSkipDebug() override {
+		return !Logs::DebugEnabled();
+	}
+	void logMessageDebug(const QString &message) override {
+		Logs::writeDebug(message);
+	}
+	void logMessage(const QString &message) override {
+		Logs::writeMain(message);
+	}
+	void logAssertionViolation(const QString &info) override {
+		Logs::writeMain("Assertion Failed! " + info);
+	}
+	void setCrashAnnotation(
+			const std::string &key,
+			const QString &value) override {
+	}
+
+};
+
+[[nodiscard]] bytes::vector GenerateSecret(bool padded) {
+	auto result = bytes::vector(kSecretSize + (padded ? 1 : 0));
+	auto random = bytes::make_span(result);
+	if (padded) {
+		result[0] = kPaddedSecretMarker;
+		random = random.subspan(1);
+	}
+	bytes::set_random(random);
+	return result;
+}
+
+[[nodiscard]] int64 Percentile(const std::vector<int64> &sorted, int value) {
+	if (sorted.empty()) {
+		return 0;
+	}
+	const auto index = (int64(sorted.size()) - 1) * value / 100;
+	return sorted[index];
+}
+
+[[nodiscard]] QString Times(const std::vector<crl::time> &list) {
+	if (list.empty()) {
+		return u"none"_q;
+	}
+	auto sum = crl::time(0);
+	auto max = crl::time(0);
+	for (const auto value : list) {
+		sum += value;
+		max = std::max(max, value);
+	}
+	return u"%1, avg %2 ms, max %3 ms"_q
+		.arg(list.size())
+		.arg(sum / crl::time(list.size()))
+		.arg(max);
+}
+
+void PrintReport(
+		const MTP::Benchmark::ClientReport &report,
+		const MTP::Benchmark::FakeDcStats &stats,
+		int payload) {
+	auto latencies = report.latencies;
+	ranges::sort(latencies);
+
+	const auto seconds = std::max(report.elapsed, crl::time(1)) / 1000.;
+	Print(u"Result: %1"_q.arg(report.failed ? "FAILED" : "OK"));
+	Print(u"Key creation: %1 ms"_q.arg(report.keyCreation));
+	Print(u"Answered: %1 in %2 ms, %3 requests/s, %4 MB/s"_q
+		.arg(report.answered)
+		.arg(report.elapsed)
+		.arg(report.answered / seconds, 0, 'f', 1)
+		.arg(report.answered * float64(payload) / seconds / 1024. / 1024.,
+			0,
+			'f',
+			2));
+	Print(u"Latency: p50 %1 us, p90 %2 us, p99 %3 us, max %4 us"_q
+		.arg(Percentile(latencies, 50))
+		.arg(Percentile(latencies, 90))
+		.arg(Percentile(latencies, 99))
+		.arg(latencies.empty() ? 0 : latencies.back()));
+	Print(u"Sent: %1 packets, %2 messages, %3 per packet, %4 bytes"_q
+		.arg(report.packetsSent)
+		.arg(report.messagesSent)
+		.arg(report.packetsSent
+			? (report.messagesSent / float64(report.packetsSent))
+			: 0.,
+			0,
+			'f',
+			2)
+		.arg(report.bytesSent));
+	Print(u"Containers: %1, max %2 messages"_q
+		.arg(report.containersSent)
+		.arg(report.maxContainerMessages));
+	Print(u"Received: %1 bytes"_q.arg(report.bytesReceived));
+	Print(u"Resent: %1, late answers: %2"_q
+		.arg(report.resent)
+		.arg(report.lateAnswers));
+	Print(u"Reconnects: %1"_q.arg(Times(report.reconnects)));
+	Print(u"Recoveries: %1"_q.arg(Times(report.recoveries)));
+	Print(u"Server: %1 connections, %2 keys, %3 packets (%4 dropped), "
+		"%5 messages, %6 containers, %7 requests, %8 disconnects"_q
+		.arg(stats.connections)
+		.arg(stats.keysCreated)
+		.arg(stats.packetsReceived)
+		.arg(stats.packetsDropped)
+		.arg(stats.messagesReceived)
+		.arg(stats.containersReceived)
+		.arg(stats.requestsReceived)
+		.arg(stats.disconnects));
+}
+
+} // namespace
+
+namespace Logs {
+
+void SetDebugEnabled(bool enabled) {
+	DebugEnabledValue = enabled;
+}
+
+bool DebugEnabled() {
+	return DebugEnabledValue;
+}
+
+bool started() {
+	return true;
+}
+
+void writeMain(const QString &v) {
+	Print(v);
+}
+
+void writeDebug(const QString &v) {
+	Print(v);
+}
+
+void writeTcp(const QString &v) {
+	Print("TCP " + v);
+}
+
+void writeMtp(int32 dc, const QString &v) {
+	Print(u"MTP %1 %2"_q.arg(dc).arg(v));
+}
+
+} // namespace Logs
+
+int main(int argc, char *argv[]) {
+	auto integration = Integration(argc, argv);
+	base::Integration::Set(&integration);
+
+	auto app = QCoreApplication(argc, argv);
+
+	auto parser = QCommandLineParser();
+	parser.addHelpOption();
+	const auto option = [&](
+			const QString &name,
+			const QString &description,
+			const QString &value) {
+		auto result = QCommandLineOption(
+			name,
+			description,
+			u"value"_q,
+			value);
+		parser.addOption(result);
+		return result;
+	};
+	const auto requests = option(
+		u"requests"_q,
+		u"Count of upload.saveFilePart requests."_q,
+		u"1000"_q);
+	const auto inflight = option(
+		u"inflight"_q,
+		u"Count of requests waiting for an answer at once."_q,
+		u"32"_q);
+	const auto payload = option(
+		u"payload"_q,
+		u"Size of a single file part in bytes."_q,
+		u"4096"_q);
+	const auto protocol = option(
+		u"protocol"_q,
+		u"Transport framing: abridged or padded."_q,
+		u"abridged"_q);
+	const auto drop = option(
+		u"drop"_q,
+		u"Part of the encrypted packets the server ignores."_q,
+		u"0"_q);
+	const auto disconnectEvery = option(
+		u"disconnect-every"_q,
+		u"Abort the connection after this many requests on it."_q,
+		u"0"_q);
+	const auto delay = option(
+		u"delay"_q,
+		u"Server answer delay in milliseconds."_q,
+		u"0"_q);
+	const auto resendAfter = option(
+		u"resend-after"_q,
+		u"Resend unanswered requests after this many milliseconds."_q,
+		u"1000"_q);
+	const auto verbose = QCommandLineOption(
+		u"verbose"_q,
+		u"Write the debug, TCP and MTP logs."_q);
+	parser.addOption(verbose);
+	parser.process(app);
+
+	Logs::SetDebugEnabled(parser.isSet(verbose));
+
+	const auto padded = (parser.value(protocol) == u"padded"_q);
+	if (!padded && parser.value(protocol) != u"abridged"_q) {
+		Print(u"Unknown protocol: %1"_q.arg(parser.value(protocol)));
+		return 1;
+	}
+	const auto secret = GenerateSecret(padded);
+
+	auto script = MTP::Benchmark::FakeDcScript();
+	script.dropChance = std::clamp(parser.value(drop).toDouble(), 0., 1.);
+	script.disconnectEvery = std::max(parser.value(disconnectEvery).toInt(), 0);
+	script.answerDelay = std::max(parser.value(delay).toLongLong(), 0LL);
+
+	auto dc = MTP::Benchmark::FakeDc(kDcId, secret, script);
+	if (!dc.listen()) {
+		Print(u"Could not listen on localhost."_q);
+		return 1;
+	}
+
+	auto dcOptions = MTP::DcOptions(MTP::Environment::Production);
+	dc.cdnConfig().match([&](const MTPDcdnConfig &data) {
+		dcOptions.setCDNConfig(data);
+	});
+
+	auto settings = MTP::Benchmark::ClientSettings();
+	settings.ip = u"127.0.0.1"_q;
+	settings.port = dc.port();
+	settings.secret = secret;
+	settings.dcId = kDcId;
+	settings.requests = std::max(parser.value(requests).toInt(), 1);
+	settings.inflight = std::max(parser.value(inflight).toInt(), 1);
+	settings.payload = std::max(parser.value(payload).toInt(), 4);
+	settings.resendAfter = std::max(
+		parser.value(resendAfter).toLongLong(),
+		1LL);
+
+	auto client = MTP::Benchmark::Client(&dcOptions, settings);
+	client.start([] { QCoreApplication::quit(); });
+	app.exec();
+
+	PrintReport(client.report(), dc.stats(), settings.payload);
+	return client.report().failed ? 1 : 0;
+}
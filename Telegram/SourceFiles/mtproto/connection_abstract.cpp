@@ -7,10 +7,6 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "mtproto/connection_abstract.h"
 
-#include "mtproto/connection_tcp.h"
-#include "mtproto/connection_http.h"
-#include "mtproto/connection_resolving.h"
-#include "mtproto/session.h"
 #include "base/unixtime.h"
 #include "base/random.h"
 
@@ -168,32 +164,6 @@ AbstractConnection::AbstractConnection(
 	moveToThread(thread);
 }
 
-ConnectionPointer AbstractConnection::Create(
-		not_null<Instance*> instance,
-		DcOptions::Variants::Protocol protocol,
-		QThread *thread,
-		const bytes::vector &secret,
-		const ProxyData &proxy) {
-	auto result = [&] {
-		if (protocol == DcOptions::Variants::Tcp) {
-			return ConnectionPointer::New<TcpConnection>(
-				instance,
-				thread,
-				proxy);
-		} else {
-			return ConnectionPointer::New<HttpConnection>(thread, proxy);
-		}
-	}();
-	if (proxy.tryCustomResolve()) {
-		return ConnectionPointer::New<ResolvingConnection>(
-			instance,
-			thread,
-			proxy,
-			std::move(result));
-	}
-	return result;
-}
-
 QString AbstractConnection::ProtocolDcDebugId(int16 protocolDcId) {
 	const auto postfix = (protocolDcId < 0) ? "_media" : "";
 	protocolDcId = (protocolDcId < 0) ? (-protocolDcId) : protocolDcId;
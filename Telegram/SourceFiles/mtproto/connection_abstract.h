@@ -67,7 +67,8 @@ public:
 	AbstractConnection &operator=(const AbstractConnection &other) = delete;
 	virtual ~AbstractConnection() = default;
 
-	// virtual constructor
+	// virtual constructor, defined in connection_resolving.cpp,
+	// because td_mtproto doesn't have the http and resolving connections.
 	[[nodiscard]] static ConnectionPointer Create(
 		not_null<Instance*> instance,
 		DcOptions::Variants::Protocol protocol,
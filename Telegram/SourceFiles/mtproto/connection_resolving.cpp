@@ -7,6 +7,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "mtproto/connection_resolving.h"
 
+#include "mtproto/connection_http.h"
+#include "mtproto/connection_tcp.h"
 #include "mtproto/mtp_instance.h"
 
 namespace MTP {
@@ -17,6 +19,29 @@ constexpr auto kOneConnectionTimeout = 4000;
 
 } // namespace
 
+ConnectionPointer AbstractConnection::Create(
+		not_null<Instance*> instance,
+		DcOptions::Variants::Protocol protocol,
+		QThread *thread,
+		const bytes::vector &secret,
+		const ProxyData &proxy) {
+	auto result = [&] {
+		if (protocol == DcOptions::Variants::Tcp) {
+			return ConnectionPointer::New<TcpConnection>(thread, proxy);
+		} else {
+			return ConnectionPointer::New<HttpConnection>(thread, proxy);
+		}
+	}();
+	if (proxy.tryCustomResolve()) {
+		return ConnectionPointer::New<ResolvingConnection>(
+			instance,
+			thread,
+			proxy,
+			std::move(result));
+	}
+	return result;
+}
+
 ResolvingConnection::ResolvingConnection(
 	not_null<Instance*> instance,
 	QThread *thread,
@@ -244,17 +244,13 @@ auto TcpConnection::Protocol::Create(bytes::const_span secret)
 	Unexpected("Secret bytes in TcpConnection::Protocol::Create.");
 }
 
-TcpConnection::TcpConnection(
-	not_null<Instance*> instance,
-	QThread *thread,
-	const ProxyData &proxy)
+TcpConnection::TcpConnection(QThread *thread, const ProxyData &proxy)
 : AbstractConnection(thread, proxy)
-, _instance(instance)
 , _checkNonce(base::RandomValue<MTPint128>()) {
 }
 
 ConnectionPointer TcpConnection::clone(const ProxyData &proxy) {
-	return ConnectionPointer::New<TcpConnection>(_instance, thread(), proxy);
+	return ConnectionPointer::New<TcpConnection>(thread(), proxy);
 }
 
 void TcpConnection::ensureAvailableInBuffer(int amount) {
@@ -17,10 +17,7 @@ class AbstractSocket;
 
 class TcpConnection : public AbstractConnection {
 public:
-	TcpConnection(
-		not_null<Instance*> instance,
-		QThread *thread,
-		const ProxyData &proxy);
+	TcpConnection(QThread *thread, const ProxyData &proxy);
 
 	ConnectionPointer clone(const ProxyData &proxy) override;
 
@@ -67,7 +64,6 @@ private:
 		return *reinterpret_cast<uint32*>(ch);
 	}
 
-	const not_null<Instance*> _instance;
 	std::unique_ptr<AbstractSocket> _socket;
 	bool _connectionStarted = false;
 
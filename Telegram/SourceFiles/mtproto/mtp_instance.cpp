@@ -38,6 +38,213 @@ using namespace details;
 
 std::atomic<int> GlobalAtomicRequestId = 0;
 
+struct FoundRequest {
+	SerializedRequest request;
+
+	// dcWithShift for request to this dc or -dc for request to main dc.
+	ShiftedDcId shiftedDcId = 0;
+};
+
+// Everything we know about the requests in flight, looked up by a single
+// lock of one of the shards, so that different threads rarely contend.
+class RequestRegistry final {
+public:
+	void store(
+		mtpRequestId requestId,
+		const SerializedRequest &request,
+		ResponseHandler &&handler,
+		ShiftedDcId shiftedDcId);
+	void setShiftedDcId(mtpRequestId requestId, ShiftedDcId shiftedDcId);
+	FoundRequest changeDc(mtpRequestId requestId, DcId newdc);
+
+	[[nodiscard]] FoundRequest find(mtpRequestId requestId) const;
+	[[nodiscard]] SerializedRequest request(mtpRequestId requestId) const;
+	[[nodiscard]] std::optional<ShiftedDcId> shiftedDcId(
+		mtpRequestId requestId) const;
+
+	[[nodiscard]] bool hasHandler(mtpRequestId requestId) const;
+	[[nodiscard]] ResponseHandler takeHandler(mtpRequestId requestId);
+	void restoreHandler(mtpRequestId requestId, ResponseHandler &&handler);
+
+	[[nodiscard]] int nextResendDelay(mtpRequestId requestId);
+
+	// Forgets the request and its dc, the handler is kept.
+	void unregister(mtpRequestId requestId);
+
+	// Forgets everything about the request.
+	FoundRequest remove(mtpRequestId requestId);
+
+private:
+	struct Entry {
+		SerializedRequest request;
+		ResponseHandler handler;
+		ShiftedDcId shiftedDcId = 0;
+		int resendDelay = 0;
+	};
+	struct alignas(64) Shard {
+		mutable QReadWriteLock lock;
+		base::flat_map<mtpRequestId, Entry> entries;
+	};
+	static constexpr auto kShardsCount = 16;
+
+	[[nodiscard]] Shard &shard(mtpRequestId requestId);
+	[[nodiscard]] const Shard &shard(mtpRequestId requestId) const;
+	static void EraseIfEmpty(
+		Shard &shard,
+		base::flat_map<mtpRequestId, Entry>::iterator i);
+
+	std::array<Shard, kShardsCount> _shards;
+
+};
+
+void RequestRegistry::store(
+		mtpRequestId requestId,
+		const SerializedRequest &request,
+		ResponseHandler &&handler,
+		ShiftedDcId shiftedDcId) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	auto &entry = shard.entries[requestId];
+	entry.request = request;
+	entry.handler = std::move(handler);
+	entry.shiftedDcId = shiftedDcId;
+}
+
+void RequestRegistry::setShiftedDcId(
+		mtpRequestId requestId,
+		ShiftedDcId shiftedDcId) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	shard.entries[requestId].shiftedDcId = shiftedDcId;
+}
+
+FoundRequest RequestRegistry::changeDc(mtpRequestId requestId, DcId newdc) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	if (i == end(shard.entries)) {
+		return {};
+	}
+	auto &entry = i->second;
+	if (entry.shiftedDcId < 0) {
+		entry.shiftedDcId = -newdc;
+	} else if (entry.shiftedDcId > 0) {
+		entry.shiftedDcId = ShiftDcId(newdc, GetDcIdShift(entry.shiftedDcId));
+	}
+	return { entry.request, entry.shiftedDcId };
+}
+
+FoundRequest RequestRegistry::find(mtpRequestId requestId) const {
+	const auto &shard = this->shard(requestId);
+	QReadLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	return (i != end(shard.entries))
+		? FoundRequest{ i->second.request, i->second.shiftedDcId }
+		: FoundRequest();
+}
+
+SerializedRequest RequestRegistry::request(mtpRequestId requestId) const {
+	return find(requestId).request;
+}
+
+std::optional<ShiftedDcId> RequestRegistry::shiftedDcId(
+		mtpRequestId requestId) const {
+	if (const auto result = find(requestId).shiftedDcId) {
+		return result;
+	}
+	return std::nullopt;
+}
+
+bool RequestRegistry::hasHandler(mtpRequestId requestId) const {
+	const auto &shard = this->shard(requestId);
+	QReadLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	return (i != end(shard.entries))
+		&& (i->second.handler.done || i->second.handler.fail);
+}
+
+ResponseHandler RequestRegistry::takeHandler(mtpRequestId requestId) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	if (i == end(shard.entries)) {
+		return {};
+	}
+	auto result = base::take(i->second.handler);
+	EraseIfEmpty(shard, i);
+	return result;
+}
+
+void RequestRegistry::restoreHandler(
+		mtpRequestId requestId,
+		ResponseHandler &&handler) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	shard.entries[requestId].handler = std::move(handler);
+}
+
+int RequestRegistry::nextResendDelay(mtpRequestId requestId) {
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	if (i == end(shard.entries)) {
+		return 1;
+	}
+	auto &delay = i->second.resendDelay;
+	return !delay ? (delay = 1) : (delay > 60) ? delay : (delay *= 2);
+}
+
+void RequestRegistry::unregister(mtpRequestId requestId) {
+	auto request = SerializedRequest();
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	if (i != end(shard.entries)) {
+		// Destroy the request outside of the lock.
+		request = base::take(i->second.request);
+		i->second.shiftedDcId = 0;
+		i->second.resendDelay = 0;
+		EraseIfEmpty(shard, i);
+	}
+	locker.unlock();
+}
+
+FoundRequest RequestRegistry::remove(mtpRequestId requestId) {
+	auto handler = ResponseHandler();
+	auto result = FoundRequest();
+	auto &shard = this->shard(requestId);
+	QWriteLocker locker(&shard.lock);
+	const auto i = shard.entries.find(requestId);
+	if (i != end(shard.entries)) {
+		// Destroy the handler outside of the lock.
+		handler = std::move(i->second.handler);
+		result = { std::move(i->second.request), i->second.shiftedDcId };
+		shard.entries.erase(i);
+	}
+	locker.unlock();
+	return result;
+}
+
+auto RequestRegistry::shard(mtpRequestId requestId) -> Shard& {
+	return _shards[uint32(requestId) % kShardsCount];
+}
+
+auto RequestRegistry::shard(mtpRequestId requestId) const -> const Shard& {
+	return _shards[uint32(requestId) % kShardsCount];
+}
+
+void RequestRegistry::EraseIfEmpty(
+		Shard &shard,
+		base::flat_map<mtpRequestId, Entry>::iterator i) {
+	const auto &entry = i->second;
+	if (!entry.request
+		&& !entry.handler.done
+		&& !entry.handler.fail
+		&& !entry.shiftedDcId) {
+		shard.entries.erase(i);
+	}
+}
+
 } // namespace
 
 namespace details {
@@ -129,12 +336,7 @@ public:
 		crl::time msCanWait,
 		bool needsLayer,
 		mtpRequestId afterRequestId);
-	void registerRequest(mtpRequestId requestId, ShiftedDcId shiftedDcId);
 	void unregisterRequest(mtpRequestId requestId);
-	void storeRequest(
-		mtpRequestId requestId,
-		const SerializedRequest &request,
-		ResponseHandler &&callbacks);
 	SerializedRequest getRequest(mtpRequestId requestId);
 	[[nodiscard]] bool hasCallback(mtpRequestId requestId) const;
 	void processCallback(const Response &response);
@@ -213,8 +415,7 @@ private:
 
 	std::optional<ShiftedDcId> queryRequestByDc(
 		mtpRequestId requestId) const;
-	std::optional<ShiftedDcId> changeRequestByDc(
-		mtpRequestId requestId, DcId newdc);
+	void resendDependentRequests(mtpRequestId requestId);
 
 	void checkDelayedRequests();
 
@@ -258,25 +459,15 @@ private:
 	rpl::event_stream<> _writeKeysRequests;
 	rpl::event_stream<> _allKeysDestroyed;
 
-	// holds dcWithShift for request to this dc or -dc for request to main dc
-	std::map<mtpRequestId, ShiftedDcId> _requestsByDc;
-	mutable QMutex _requestByDcLock;
+	RequestRegistry _requests;
 
 	// holds target dcWithShift for auth export request
 	std::map<mtpRequestId, ShiftedDcId> _authExportRequests;
 
-	std::map<mtpRequestId, ResponseHandler> _parserMap;
-	mutable QMutex _parserMapLock;
-
-	std::map<mtpRequestId, SerializedRequest> _requestMap;
-	QReadWriteLock _requestMapLock;
-
 	std::deque<std::pair<mtpRequestId, crl::time>> _delayedRequests;
 	base::flat_map<mtpRequestId, mtpRequestId> _dependentRequests;
 	mutable QMutex _dependentRequestsLock;
 
-	std::map<mtpRequestId, int> _requestsDelays;
-
 	std::set<mtpRequestId> _badGuestDcRequests;
 
 	std::map<DcId, std::vector<mtpRequestId>> _authWaiters;
@@ -655,24 +846,15 @@ void Instance::Private::cancel(mtpRequestId requestId) {
 	if (!requestId) return;
 
 	DEBUG_LOG(("MTP Info: Cancel request %1.").arg(requestId));
-	const auto shiftedDcId = queryRequestByDc(requestId);
-	auto msgId = mtpMsgId(0);
-	{
-		QWriteLocker locker(&_requestMapLock);
-		auto it = _requestMap.find(requestId);
-		if (it != _requestMap.end()) {
-			msgId = *(mtpMsgId*)(it->second->constData() + 4);
-			_requestMap.erase(it);
-		}
-	}
-	unregisterRequest(requestId);
-	if (shiftedDcId) {
-		const auto session = getSession(qAbs(*shiftedDcId));
+	const auto removed = _requests.remove(requestId);
+	const auto msgId = removed.request
+		? *(mtpMsgId*)(removed.request->constData() + 4)
+		: mtpMsgId(0);
+	resendDependentRequests(requestId);
+	if (removed.shiftedDcId) {
+		const auto session = getSession(qAbs(removed.shiftedDcId));
 		session->cancel(requestId, msgId);
 	}
-
-	QMutexLocker locker(&_parserMapLock);
-	_parserMap.erase(requestId);
 }
 
 // result < 0 means waiting for such count of ms.
@@ -946,28 +1128,7 @@ bool Instance::Private::configLoadFail(const Error &error) {
 
 std::optional<ShiftedDcId> Instance::Private::queryRequestByDc(
 		mtpRequestId requestId) const {
-	QMutexLocker locker(&_requestByDcLock);
-	auto it = _requestsByDc.find(requestId);
-	if (it != _requestsByDc.cend()) {
-		return it->second;
-	}
-	return std::nullopt;
-}
-
-std::optional<ShiftedDcId> Instance::Private::changeRequestByDc(
-		mtpRequestId requestId,
-		DcId newdc) {
-	QMutexLocker locker(&_requestByDcLock);
-	auto it = _requestsByDc.find(requestId);
-	if (it != _requestsByDc.cend()) {
-		if (it->second < 0) {
-			it->second = -newdc;
-		} else {
-			it->second = ShiftDcId(newdc, GetDcIdShift(it->second));
-		}
-		return it->second;
-	}
-	return std::nullopt;
+	return _requests.shiftedDcId(requestId);
 }
 
 void Instance::Private::checkDelayedRequests() {
@@ -976,26 +1137,16 @@ void Instance::Private::checkDelayedRequests() {
 		auto requestId = _delayedRequests.front().first;
 		_delayedRequests.pop_front();
 
-		auto dcWithShift = ShiftedDcId(0);
-		if (const auto shiftedDcId = queryRequestByDc(requestId)) {
-			dcWithShift = *shiftedDcId;
-		} else {
+		const auto found = _requests.find(requestId);
+		if (!found.shiftedDcId) {
 			LOG(("MTP Error: could not find request dc for delayed resend, requestId %1").arg(requestId));
 			continue;
+		} else if (!found.request) {
+			DEBUG_LOG(("MTP Error: could not find request %1").arg(requestId));
+			continue;
 		}
-
-		auto request = SerializedRequest();
-		{
-			QReadLocker locker(&_requestMapLock);
-			auto it = _requestMap.find(requestId);
-			if (it == _requestMap.cend()) {
-				DEBUG_LOG(("MTP Error: could not find request %1").arg(requestId));
-				continue;
-			}
-			request = it->second;
-		}
-		const auto session = getSession(qAbs(dcWithShift));
-		session->sendPrepared(request);
+		const auto session = getSession(qAbs(found.shiftedDcId));
+		session->sendPrepared(found.request);
 	}
 
 	if (!_delayedRequests.empty()) {
@@ -1014,12 +1165,11 @@ void Instance::Private::sendRequest(
 	const auto session = getSession(shiftedDcId);
 
 	request->requestId = requestId;
-	storeRequest(requestId, request, std::move(callbacks));
 
 	const auto toMainDc = (shiftedDcId == 0);
 	const auto realShiftedDcId = session->getDcWithShift();
 	const auto signedDcId = toMainDc ? -realShiftedDcId : realShiftedDcId;
-	registerRequest(requestId, signedDcId);
+	_requests.store(requestId, request, std::move(callbacks), signedDcId);
 
 	if (afterRequestId) {
 		request->after = getRequest(afterRequestId);
@@ -1030,26 +1180,14 @@ void Instance::Private::sendRequest(
 	session->sendPrepared(request, msCanWait);
 }
 
-void Instance::Private::registerRequest(
-		mtpRequestId requestId,
-		ShiftedDcId shiftedDcId) {
-	QMutexLocker locker(&_requestByDcLock);
-	_requestsByDc[requestId] = shiftedDcId;
-}
-
 void Instance::Private::unregisterRequest(mtpRequestId requestId) {
 	DEBUG_LOG(("MTP Info: unregistering request %1.").arg(requestId));
 
-	_requestsDelays.erase(requestId);
+	_requests.unregister(requestId);
+	resendDependentRequests(requestId);
+}
 
-	{
-		QWriteLocker locker(&_requestMapLock);
-		_requestMap.erase(requestId);
-	}
-	{
-		QMutexLocker locker(&_requestByDcLock);
-		_requestsByDc.erase(requestId);
-	}
+void Instance::Private::resendDependentRequests(mtpRequestId requestId) {
 	{
 		auto toRemove = base::flat_set<mtpRequestId>();
 		auto toResend = base::flat_set<mtpRequestId>();
@@ -1075,69 +1213,33 @@ void Instance::Private::unregisterRequest(mtpRequestId requestId) {
 		locker.unlock();
 
 		for (const auto resendingId : toResend) {
-			if (const auto shiftedDcId = queryRequestByDc(resendingId)) {
-				SerializedRequest request;
-				{
-					QReadLocker locker(&_requestMapLock);
-					auto it = _requestMap.find(resendingId);
-					if (it == _requestMap.cend()) {
-						LOG(("MTP Error: could not find dependent request %1").arg(resendingId));
-						return;
-					}
-					request = it->second;
+			const auto found = _requests.find(resendingId);
+			if (found.shiftedDcId) {
+				if (!found.request) {
+					LOG(("MTP Error: could not find dependent request %1").arg(resendingId));
+					return;
 				}
-				getSession(qAbs(*shiftedDcId))->sendPrepared(request);
+				getSession(qAbs(found.shiftedDcId))->sendPrepared(
+					found.request);
 			}
 		}
 	}
 }
 
-void Instance::Private::storeRequest(
-		mtpRequestId requestId,
-		const SerializedRequest &request,
-		ResponseHandler &&callbacks) {
-	if (callbacks.done || callbacks.fail) {
-		QMutexLocker locker(&_parserMapLock);
-		_parserMap.emplace(requestId, std::move(callbacks));
-	}
-	{
-		QWriteLocker locker(&_requestMapLock);
-		_requestMap.emplace(requestId, request);
-	}
-}
-
 SerializedRequest Instance::Private::getRequest(mtpRequestId requestId) {
-	auto result = SerializedRequest();
-	{
-		QReadLocker locker(&_requestMapLock);
-		auto it = _requestMap.find(requestId);
-		if (it != _requestMap.cend()) {
-			result = it->second;
-		}
-	}
-	return result;
+	return _requests.request(requestId);
 }
 
 bool Instance::Private::hasCallback(mtpRequestId requestId) const {
-	QMutexLocker locker(&_parserMapLock);
-	auto it = _parserMap.find(requestId);
-	return (it != _parserMap.cend());
+	return _requests.hasHandler(requestId);
 }
 
 void Instance::Private::processCallback(const Response &response) {
 	const auto requestId = response.requestId;
-	ResponseHandler handler;
-	{
-		QMutexLocker locker(&_parserMapLock);
-		auto it = _parserMap.find(requestId);
-		if (it != _parserMap.cend()) {
-			handler = std::move(it->second);
-			_parserMap.erase(it);
-
-			DEBUG_LOG(("RPC Info: found parser for request %1, trying to parse response...").arg(requestId));
-		}
-	}
+	auto handler = _requests.takeHandler(requestId);
 	if (handler.done || handler.fail) {
+		DEBUG_LOG(("RPC Info: found parser for request %1, trying to parse response...").arg(requestId));
+
 		const auto handleError = [&](const Error &error) {
 			DEBUG_LOG(("RPC Info: "
 				"error received, code %1, type %2, description: %3").arg(
@@ -1148,8 +1250,7 @@ void Instance::Private::processCallback(const Response &response) {
 			if (rpcErrorOccured(response, handler, error) && guard) {
 				unregisterRequest(requestId);
 			} else if (guard) {
-				QMutexLocker locker(&_parserMapLock);
-				_parserMap.emplace(requestId, std::move(handler));
+				_requests.restoreHandler(requestId, std::move(handler));
 			}
 		};
 
@@ -1260,23 +1361,20 @@ void Instance::Private::importDone(
 
 	auto &waiters = _authWaiters[newdc];
 	if (waiters.size()) {
-		QReadLocker locker(&_requestMapLock);
 		for (auto waitedRequestId : waiters) {
-			auto it = _requestMap.find(waitedRequestId);
-			if (it == _requestMap.cend()) {
+			const auto found = _requests.changeDc(waitedRequestId, newdc);
+			if (!found.request) {
 				LOG(("MTP Error: could not find request %1 for resending").arg(waitedRequestId));
 				continue;
-			}
-			const auto shiftedDcId = changeRequestByDc(waitedRequestId, newdc);
-			if (!shiftedDcId) {
+			} else if (!found.shiftedDcId) {
 				LOG(("MTP Error: could not find request %1 by dc for resending").arg(waitedRequestId));
 				continue;
-			} else if (*shiftedDcId < 0) {
+			} else if (found.shiftedDcId < 0) {
 				_instance->setMainDcId(newdc);
 			}
-			DEBUG_LOG(("MTP Info: resending request %1 to dc %2 after import auth").arg(waitedRequestId).arg(*shiftedDcId));
-			const auto session = getSession(*shiftedDcId);
-			session->sendPrepared(it->second);
+			DEBUG_LOG(("MTP Info: resending request %1 to dc %2 after import auth").arg(waitedRequestId).arg(found.shiftedDcId));
+			const auto session = getSession(found.shiftedDcId);
+			session->sendPrepared(found.request);
 		}
 		waiters.clear();
 	}
@@ -1415,42 +1513,32 @@ bool Instance::Private::onErrorDefault(
 			newdcWithShift = ShiftDcId(newdcWithShift, GetDcIdShift(dcWithShift));
 		}
 
-		auto request = SerializedRequest();
-		{
-			QReadLocker locker(&_requestMapLock);
-			auto it = _requestMap.find(requestId);
-			if (it == _requestMap.cend()) {
-				LOG(("MTP Error: could not find request %1").arg(requestId));
-				return false;
-			}
-			request = it->second;
+		const auto request = _requests.request(requestId);
+		if (!request) {
+			LOG(("MTP Error: could not find request %1").arg(requestId));
+			return false;
 		}
 		const auto session = getSession(newdcWithShift);
-		registerRequest(
+		_requests.setShiftedDcId(
 			requestId,
 			(dcWithShift < 0) ? -newdcWithShift : newdcWithShift);
 		session->sendPrepared(request);
 		return true;
 	} else if (type == u"MSG_WAIT_TIMEOUT"_q || type == u"MSG_WAIT_FAILED"_q) {
-		SerializedRequest request;
-		{
-			QReadLocker locker(&_requestMapLock);
-			auto it = _requestMap.find(requestId);
-			if (it == _requestMap.cend()) {
-				LOG(("MTP Error: could not find MSG_WAIT_* request %1").arg(requestId));
-				return false;
-			}
-			request = it->second;
-		}
-		if (!request->after) {
+		const auto found = _requests.find(requestId);
+		const auto &request = found.request;
+		if (!request) {
+			LOG(("MTP Error: could not find MSG_WAIT_* request %1").arg(requestId));
+			return false;
+		} else if (!request->after) {
 			LOG(("MTP Error: MSG_WAIT_* for not dependent request %1").arg(requestId));
 			return false;
 		}
 		auto dcWithShift = ShiftedDcId(0);
-		if (const auto shiftedDcId = queryRequestByDc(requestId)) {
-			dcWithShift = *shiftedDcId;
+		if (const auto shiftedDcId = found.shiftedDcId) {
+			dcWithShift = shiftedDcId;
 			if (const auto afterDcId = queryRequestByDc(request->after->requestId)) {
-				if (*shiftedDcId != *afterDcId) {
+				if (shiftedDcId != *afterDcId) {
 					request->after = SerializedRequest();
 				}
 			} else {
@@ -1483,12 +1571,7 @@ bool Instance::Private::onErrorDefault(
 		auto secs = 1;
 		auto nonPremiumDelay = false;
 		if (code < 0 || code >= 500) {
-			const auto it = _requestsDelays.find(requestId);
-			if (it != _requestsDelays.cend()) {
-				secs = (it->second > 60) ? it->second : (it->second *= 2);
-			} else {
-				_requestsDelays.emplace(requestId, secs);
-			}
+			secs = _requests.nextResendDelay(requestId);
 		} else if (m1.hasMatch()) {
 			secs = m1.captured(1).toInt();
 //			if (secs >= 60) return false;
@@ -1556,23 +1639,17 @@ bool Instance::Private::onErrorDefault(
 		return true;
 	} else if (type == u"CONNECTION_NOT_INITED"_q
 		|| type == u"CONNECTION_LAYER_INVALID"_q) {
-		SerializedRequest request;
-		{
-			QReadLocker locker(&_requestMapLock);
-			auto it = _requestMap.find(requestId);
-			if (it == _requestMap.cend()) {
-				LOG(("MTP Error: could not find request %1").arg(requestId));
-				return false;
-			}
-			request = it->second;
+		const auto found = _requests.find(requestId);
+		const auto &request = found.request;
+		if (!request) {
+			LOG(("MTP Error: could not find request %1").arg(requestId));
+			return false;
 		}
-		auto dcWithShift = ShiftedDcId(0);
-		if (const auto shiftedDcId = queryRequestByDc(requestId)) {
-			dcWithShift = *shiftedDcId;
-		} else {
+		const auto dcWithShift = found.shiftedDcId;
+		if (!dcWithShift) {
 			LOG(("MTP Error: could not find request %1 for resending with init connection").arg(requestId));
+			return false;
 		}
-		if (!dcWithShift) return false;
 
 		const auto session = getSession(qAbs(dcWithShift));
 		request->needsLayer = true;
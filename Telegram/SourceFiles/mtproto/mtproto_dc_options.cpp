@@ -18,7 +18,10 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace MTP {
 namespace {
 
-constexpr auto kVersion = 2;
+constexpr auto kVersion = 3;
+constexpr auto kConnectionHistoryMaxCount = 1024;
+constexpr auto kConnectionHistoryPerDc = 8;
+constexpr auto kConnectionDurationMax = 60 * crl::time(1000);
 
 using namespace details;
 
@@ -127,6 +130,8 @@ DcOptions::DcOptions(const DcOptions &other)
 , _publicKeys(other._publicKeys)
 , _cdnPublicKeys(other._cdnPublicKeys)
 , _immutable(other._immutable) {
+	QMutexLocker lock(&other._connectionHistoryMutex);
+	_connectionHistory = other._connectionHistory;
 }
 
 DcOptions::~DcOptions() = default;
@@ -438,6 +443,16 @@ QByteArray DcOptions::serialize() const {
 		}
 	}
 
+	QMutexLocker historyLock(&_connectionHistoryMutex);
+	size += sizeof(qint32);
+	for (const auto &[key, list] : _connectionHistory) {
+		for (const auto &entry : list) {
+			// dcId + type + protocol + port + duration + counts
+			size += 7 * sizeof(qint32);
+			size += sizeof(qint32) + entry.endpoint.ip.size();
+		}
+	}
+
 	auto result = QByteArray();
 	result.reserve(size);
 	{
@@ -471,6 +486,27 @@ QByteArray DcOptions::serialize() const {
 				<< Serialize::bytes(key.n)
 				<< Serialize::bytes(key.e);
 		}
+
+		// Connections history.
+		auto historyCount = 0;
+		for (const auto &[key, list] : _connectionHistory) {
+			historyCount += list.size();
+		}
+		stream << qint32(historyCount);
+		for (const auto &[key, list] : _connectionHistory) {
+			for (const auto &entry : list) {
+				const auto &endpoint = entry.endpoint;
+				stream << qint32(key.first)
+					<< qint32(key.second)
+					<< qint32(endpoint.protocol)
+					<< qint32(endpoint.port)
+					<< qint32(endpoint.ip.size());
+				stream.writeRawData(endpoint.ip.data(), endpoint.ip.size());
+				stream << qint32(entry.duration)
+					<< qint32(entry.successes)
+					<< qint32(entry.failures);
+			}
+		}
 	}
 	return result;
 }
@@ -566,6 +602,65 @@ bool DcOptions::constructFromSerialized(const QByteArray &serialized) {
 			}
 		}
 	}
+
+	// Read connections history.
+	if (!stream.atEnd() && version > 2) {
+		auto count = qint32(0);
+		stream >> count;
+		if (stream.status() != QDataStream::Ok
+			|| count < 0
+			|| count > kConnectionHistoryMaxCount) {
+			LOG(("MTP Error: Bad data for connections history "
+				"in DcOptions::constructFromSerialized()"));
+			return false;
+		}
+
+		auto history = base::flat_map<
+			ConnectionHistoryKey,
+			std::vector<ConnectionHistory>>();
+		for (auto i = 0; i != count; ++i) {
+			qint32 dcId = 0, type = 0, protocol = 0, port = 0, ipSize = 0;
+			stream >> dcId >> type >> protocol >> port >> ipSize;
+
+			constexpr auto kMaxIpSize = 45;
+			if (ipSize <= 0 || ipSize > kMaxIpSize) {
+				LOG(("MTP Error: Bad data for connections history "
+					"inside DcOptions::constructFromSerialized()"));
+				return false;
+			}
+			auto ip = std::string(ipSize, ' ');
+			stream.readRawData(ip.data(), ipSize);
+
+			qint32 duration = 0, successes = 0, failures = 0;
+			stream >> duration >> successes >> failures;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("MTP Error: Bad data for connections history "
+					"inside DcOptions::constructFromSerialized()"));
+				return false;
+			} else if ((protocol != Variants::Tcp
+					&& protocol != Variants::Http)
+				|| (type != int(DcType::Regular)
+					&& type != int(DcType::MediaCluster)
+					&& type != int(DcType::Cdn))) {
+				continue;
+			}
+			history[{ DcId(dcId), DcType(type) }].push_back({
+				.endpoint = {
+					.protocol = Variants::Protocol(protocol),
+					.ip = std::move(ip),
+					.port = port,
+				},
+				.duration = std::clamp(
+					crl::time(duration),
+					crl::time(0),
+					kConnectionDurationMax),
+				.successes = std::max(successes, 0),
+				.failures = std::max(failures, 0),
+			});
+		}
+		QMutexLocker lock(&_connectionHistoryMutex);
+		_connectionHistory = std::move(history);
+	}
 	return true;
 }
 
@@ -610,6 +705,128 @@ DcType DcOptions::dcType(ShiftedDcId shiftedDcId) const {
 	return DcType::Regular;
 }
 
+void DcOptions::connectionSucceeded(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint,
+		crl::time duration) {
+	duration = std::clamp(duration, crl::time(0), kConnectionDurationMax);
+	updateConnectionHistory(dcId, type, endpoint, [&](
+			ConnectionHistory &entry) {
+		entry.duration = entry.successes
+			? ((entry.duration * 3 + duration) / 4)
+			: duration;
+		++entry.successes;
+	});
+}
+
+void DcOptions::connectionFailed(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint) {
+	updateConnectionHistory(dcId, type, endpoint, [&](
+			ConnectionHistory &entry) {
+		++entry.failures;
+	});
+}
+
+auto DcOptions::rememberedEndpoint(DcId dcId, DcType type) const
+-> std::optional<RememberedEndpoint> {
+	QMutexLocker lock(&_connectionHistoryMutex);
+	const auto i = _connectionHistory.find({ dcId, type });
+	if (i == end(_connectionHistory)) {
+		return std::nullopt;
+	} else if (const auto chosen = ChooseRemembered(i->second)) {
+		return RememberedEndpoint{ chosen->endpoint, chosen->duration };
+	}
+	return std::nullopt;
+}
+
+rpl::producer<> DcOptions::rememberedEndpointsChanged() const {
+	return _rememberedEndpointsChanged.events();
+}
+
+auto DcOptions::connectionStats() const -> std::vector<ConnectionStats> {
+	auto result = std::vector<ConnectionStats>();
+	QMutexLocker lock(&_connectionHistoryMutex);
+	for (const auto &[key, list] : _connectionHistory) {
+		const auto chosen = ChooseRemembered(list);
+		for (const auto &entry : list) {
+			result.push_back({
+				.dcId = key.first,
+				.type = key.second,
+				.endpoint = entry.endpoint,
+				.duration = entry.duration,
+				.successes = entry.successes,
+				.failures = entry.failures,
+				.chosen = (&entry == chosen),
+			});
+		}
+	}
+	return result;
+}
+
+auto DcOptions::ChooseRemembered(const std::vector<ConnectionHistory> &list)
+-> const ConnectionHistory* {
+	auto result = (const ConnectionHistory*)nullptr;
+	for (const auto &entry : list) {
+		if (entry.successes <= entry.failures) {
+			continue;
+		} else if (!result || entry.duration < result->duration) {
+			result = &entry;
+		}
+	}
+	return result;
+}
+
+void DcOptions::updateConnectionHistory(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint,
+		Fn<void(ConnectionHistory&)> update) {
+	if (_immutable || endpoint.ip.empty()) {
+		return;
+	}
+	QMutexLocker lock(&_connectionHistoryMutex);
+	auto &list = _connectionHistory[{ dcId, type }];
+	const auto was = ChooseRemembered(list);
+	const auto wasEndpoint = was ? was->endpoint : ConnectionEndpoint();
+	auto i = ranges::find(list, endpoint, &ConnectionHistory::endpoint);
+	if (i == end(list)) {
+		list.push_back({ .endpoint = endpoint });
+		i = end(list) - 1;
+	}
+	update(*i);
+
+	// Forget old results gradually, so that a changed network is noticed.
+	constexpr auto kForgetAfter = 16;
+	if (i->successes + i->failures > kForgetAfter) {
+		i->successes = (i->successes + 1) / 2;
+		i->failures /= 2;
+	}
+
+	if (list.size() > kConnectionHistoryPerDc) {
+		const auto worst = ranges::min_element(
+			list,
+			std::less<>(),
+			[&](const ConnectionHistory &entry) {
+				return (entry.endpoint == endpoint)
+					? std::numeric_limits<int>::max()
+					: (entry.successes - entry.failures);
+			});
+		list.erase(worst);
+	}
+
+	const auto now = ChooseRemembered(list);
+	const auto changed = (now ? now->endpoint : ConnectionEndpoint())
+		!= wasEndpoint;
+	lock.unlock();
+
+	if (changed) {
+		_rememberedEndpointsChanged.fire({});
+	}
+}
+
 void DcOptions::setCDNConfig(const MTPDcdnConfig &config) {
 	WriteLocker lock(this);
 	_cdnPublicKeys.clear();
@@ -105,6 +105,48 @@ public:
 		bool throughProxy) const;
 	[[nodiscard]] DcType dcType(ShiftedDcId shiftedDcId) const;
 
+	struct ConnectionEndpoint {
+		Variants::Protocol protocol = Variants::Tcp;
+		std::string ip;
+		int port = 0;
+
+		friend inline bool operator==(
+			const ConnectionEndpoint &a,
+			const ConnectionEndpoint &b) = default;
+	};
+	struct RememberedEndpoint {
+		ConnectionEndpoint endpoint;
+		crl::time duration = 0;
+	};
+
+	// Direct connections history, so that the next time we connect
+	// straight to the endpoint that worked best, racing the rest only
+	// if it doesn't respond. Must be updated from the main thread.
+	void connectionSucceeded(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint,
+		crl::time duration);
+	void connectionFailed(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint);
+	[[nodiscard]] std::optional<RememberedEndpoint> rememberedEndpoint(
+		DcId dcId,
+		DcType type) const;
+	[[nodiscard]] rpl::producer<> rememberedEndpointsChanged() const;
+
+	struct ConnectionStats {
+		DcId dcId = 0;
+		DcType type = DcType::Regular;
+		ConnectionEndpoint endpoint;
+		crl::time duration = 0; // Average time to connect.
+		int successes = 0;
+		int failures = 0;
+		bool chosen = false; // Tried first on the next connect.
+	};
+	[[nodiscard]] std::vector<ConnectionStats> connectionStats() const;
+
 	void setCDNConfig(const MTPDcdnConfig &config);
 	[[nodiscard]] bool hasCDNKeysForDc(DcId dcId) const;
 	[[nodiscard]] details::RSAPublicKey getDcRSAKey(
@@ -141,6 +183,21 @@ private:
 
 	void readBuiltInPublicKeys();
 
+	struct ConnectionHistory {
+		ConnectionEndpoint endpoint;
+		crl::time duration = 0;
+		int successes = 0;
+		int failures = 0;
+	};
+	using ConnectionHistoryKey = std::pair<DcId, DcType>;
+	[[nodiscard]] static const ConnectionHistory *ChooseRemembered(
+		const std::vector<ConnectionHistory> &list);
+	void updateConnectionHistory(
+		DcId dcId,
+		DcType type,
+		const ConnectionEndpoint &endpoint,
+		Fn<void(ConnectionHistory&)> update);
+
 	class WriteLocker;
 	friend class WriteLocker;
 
@@ -156,8 +213,14 @@ private:
 		base::flat_map<uint64, details::RSAPublicKey>> _cdnPublicKeys;
 	mutable QReadWriteLock _useThroughLockers;
 
+	base::flat_map<
+		ConnectionHistoryKey,
+		std::vector<ConnectionHistory>> _connectionHistory;
+	mutable QMutex _connectionHistoryMutex;
+
 	rpl::event_stream<DcId> _changed;
 	rpl::event_stream<> _cdnConfigChanged;
+	rpl::event_stream<> _rememberedEndpointsChanged;
 
 	// True when we have overriden options from a .tdesktop-endpoints file.
 	bool _immutable = false;
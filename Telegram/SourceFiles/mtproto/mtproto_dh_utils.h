@@ -22,6 +22,8 @@ struct ModExpFirst {
 	bytes::vector randomPower;
 };
 
+// The prime the servers send in server_DH_inner_data, used with g = 3.
+[[nodiscard]] bytes::const_span KnownGoodPrime();
 [[nodiscard]] bool IsPrimeAndGood(bytes::const_span primeBytes, int g);
 [[nodiscard]] bool IsGoodModExpFirst(
 	const openssl::BigNum &modexp,
@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_response.h"
 #include "mtproto/mtproto_dc_options.h"
 #include "mtproto/connection_abstract.h"
+#include "core/core_trace.h"
 #include "base/random.h"
 #include "base/qthelp_url.h"
 #include "base/openssl_help.h"
@@ -30,6 +31,7 @@ namespace {
 
 constexpr auto kIntSize = static_cast<int>(sizeof(mtpPrime));
 constexpr auto kWaitForBetterTimeout = crl::time(2000);
+constexpr auto kRememberedFallbackMin = crl::time(300);
 constexpr auto kMinConnectedTimeout = crl::time(1000);
 constexpr auto kMaxConnectedTimeout = crl::time(8000);
 constexpr auto kMinReceiveTimeout = crl::time(4000);
@@ -154,6 +156,7 @@ SessionPrivate::SessionPrivate(
 , _waitForConnectedTimer(thread, [=] { waitConnectedFailed(); })
 , _waitForReceivedTimer(thread, [=] { waitReceivedFailed(); })
 , _waitForBetterTimer(thread, [=] { waitBetterFailed(); })
+, _startTestConnectionsTimer(thread, [=] { startTestConnections(); })
 , _waitForReceived(kMinReceiveTimeout)
 , _waitForConnected(kMinConnectedTimeout)
 , _pingSender(thread, [=] { sendPingByTimer(); })
@@ -189,13 +192,19 @@ void SessionPrivate::appendTestConnection(
 		+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
 		+ (protocolSecret.empty() ? 0 : 1);
 	_testConnections.push_back({
-		AbstractConnection::Create(
+		.data = AbstractConnection::Create(
 			_instance,
 			protocol,
 			thread(),
 			protocolSecret,
 			_options->proxy),
-		priority
+		.priority = priority,
+		.endpoint = {
+			.protocol = protocol,
+			.ip = ip.toStdString(),
+			.port = port,
+		},
+		.protocolSecret = protocolSecret,
 	});
 	const auto weak = _testConnections.back().data.get();
 	connect(weak, &AbstractConnection::error, [=](int errorCode) {
@@ -221,12 +230,23 @@ void SessionPrivate::appendTestConnection(
 			instance->syncHttpUnixtime();
 		});
 	});
+}
+
+void SessionPrivate::startTestConnection(TestConnection &test) {
+	if (test.startedAt) {
+		return;
+	}
+	test.startedAt = crl::now();
 
 	const auto protocolForFiles = isMediaClusterDcId(_shiftedDcId)
 		//|| isUploadDcId(_shiftedDcId)
 		|| (_realDcType == DcType::Cdn);
 	const auto protocolDcId = getProtocolDcId();
-	InvokeQueued(_testConnections.back().data, [=] {
+	const auto weak = test.data.get();
+	const auto ip = QString::fromStdString(test.endpoint.ip);
+	const auto port = test.endpoint.port;
+	const auto protocolSecret = test.protocolSecret;
+	InvokeQueued(test.data, [=] {
 		weak->connectToServer(
 			ip,
 			port,
@@ -236,6 +256,13 @@ void SessionPrivate::appendTestConnection(
 	});
 }
 
+void SessionPrivate::startTestConnections() {
+	_startTestConnectionsTimer.cancel();
+	for (auto &test : _testConnections) {
+		startTestConnection(test);
+	}
+}
+
 int16 SessionPrivate::getProtocolDcId() const {
 	const auto dcId = BareDcId(_shiftedDcId);
 	const auto simpleDcId = isTemporaryDcId(dcId)
@@ -325,6 +352,7 @@ void SessionPrivate::destroyAllConnections() {
 	_waitForBetterTimer.cancel();
 	_waitForReceivedTimer.cancel();
 	_waitForConnectedTimer.cancel();
+	_startTestConnectionsTimer.cancel();
 	_testConnections.clear();
 	_connection = nullptr;
 }
@@ -1054,6 +1082,34 @@ void SessionPrivate::connectToServer(bool afterConfig) {
 		).arg(_shiftedDcId
 		).arg(_testConnections.size()));
 
+	// Try the endpoint that worked best the last time first,
+	// the rest are raced only if it doesn't connect fast enough.
+	_rememberConnections = (_options->proxy.type == ProxyData::Type::None)
+		&& (_currentDcType != DcType::Temporary)
+		&& !_instance->isKeysDestroyer();
+	const auto remembered = _rememberConnections
+		? _instance->dcOptions().rememberedEndpoint(bareDc, _currentDcType)
+		: std::nullopt;
+	const auto i = remembered
+		? ranges::find(
+			_testConnections,
+			remembered->endpoint,
+			&TestConnection::endpoint)
+		: end(_testConnections);
+	if (i != end(_testConnections) && _testConnections.size() > 1) {
+		DEBUG_LOG(("MTP Info: trying remembered %1 first, %2 ms last time."
+			).arg(i->data->tag()
+			).arg(remembered->duration));
+		i->remembered = true;
+		startTestConnection(*i);
+		_startTestConnectionsTimer.callOnce(std::clamp(
+			remembered->duration * 2,
+			kRememberedFallbackMin,
+			kWaitForBetterTimeout));
+	} else {
+		startTestConnections();
+	}
+
 	if (!_startedConnectingAt) {
 		_startedConnectingAt = crl::now();
 	} else if (crl::now() - _startedConnectingAt > kRequestConfigTimeout) {
@@ -1217,6 +1273,7 @@ void SessionPrivate::waitBetterFailed() {
 
 void SessionPrivate::connectingTimedOut() {
 	for (const auto &connection : _testConnections) {
+		rememberConnectionFailed(connection);
 		connection.data->timedOut();
 	}
 	doDisconnect();
@@ -1236,6 +1293,8 @@ void SessionPrivate::requestCDNConfig() {
 void SessionPrivate::handleReceived() {
 	Expects(_encryptionKey != nullptr);
 
+	const auto trace = Core::Trace::Scope("SessionPrivate::handleReceived");
+
 	onReceivedSome();
 
 	while (!_connection->received().empty()) {
@@ -2279,7 +2338,12 @@ void SessionPrivate::onConnected(
 	const auto j = ranges::find_if(
 		_testConnections,
 		[&](const TestConnection &test) { return test.priority > my; });
-	if (j != end(_testConnections)) {
+	if (i->remembered) {
+		DEBUG_LOG(("MTP Info: remembered connection %1 succeed."
+			).arg(i->data->tag()));
+		_waitForBetterTimer.cancel();
+		useTestConnection(*i);
+	} else if (j != end(_testConnections)) {
 		DEBUG_LOG(("MTP Info: connection %1 succeed, waiting for %2.").arg(
 			i->data->tag(),
 			j->data->tag()));
@@ -2287,9 +2351,7 @@ void SessionPrivate::onConnected(
 	} else {
 		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
 		_waitForBetterTimer.cancel();
-		_connection = std::move(i->data);
-		_testConnections.clear();
-		checkAuthKey();
+		useTestConnection(*i);
 	}
 }
 
@@ -2323,7 +2385,26 @@ void SessionPrivate::confirmBestConnection() {
 	DEBUG_LOG(("MTP Info: can't connect through better, using %1."
 		).arg(i->data->tag()));
 
-	_connection = std::move(i->data);
+	useTestConnection(*i);
+}
+
+void SessionPrivate::useTestConnection(TestConnection &test) {
+	if (_rememberConnections) {
+		const auto instance = _instance;
+		const auto dcId = BareDcId(_shiftedDcId);
+		const auto type = _currentDcType;
+		const auto endpoint = test.endpoint;
+		const auto duration = crl::now() - test.startedAt;
+		InvokeQueued(instance, [=] {
+			instance->dcOptions().connectionSucceeded(
+				dcId,
+				type,
+				endpoint,
+				duration);
+		});
+	}
+	_connection = std::move(test.data);
+	_startTestConnectionsTimer.cancel();
 	_testConnections.clear();
 
 	checkAuthKey();
@@ -2331,12 +2412,34 @@ void SessionPrivate::confirmBestConnection() {
 
 void SessionPrivate::removeTestConnection(
 		not_null<AbstractConnection*> connection) {
-	_testConnections.erase(
-		ranges::remove(
-			_testConnections,
-			connection.get(),
-			[](const TestConnection &test) { return test.data.get(); }),
-		end(_testConnections));
+	const auto i = ranges::find(
+		_testConnections,
+		connection.get(),
+		[](const TestConnection &test) { return test.data.get(); });
+	if (i == end(_testConnections)) {
+		return;
+	}
+	rememberConnectionFailed(*i);
+	const auto remembered = i->remembered;
+	_testConnections.erase(i);
+
+	if (remembered) {
+		// Don't wait for the fallback timer, race the rest right away.
+		startTestConnections();
+	}
+}
+
+void SessionPrivate::rememberConnectionFailed(const TestConnection &test) {
+	if (!_rememberConnections || !test.startedAt) {
+		return;
+	}
+	const auto instance = _instance;
+	const auto dcId = BareDcId(_shiftedDcId);
+	const auto type = _currentDcType;
+	const auto endpoint = test.endpoint;
+	InvokeQueued(instance, [=] {
+		instance->dcOptions().connectionFailed(dcId, type, endpoint);
+	});
 }
 
 void SessionPrivate::checkAuthKey() {
@@ -56,6 +56,10 @@ private:
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
+		DcOptions::ConnectionEndpoint endpoint;
+		bytes::vector protocolSecret;
+		crl::time startedAt = 0;
+		bool remembered = false;
 	};
 	struct SentContainer {
 		crl::time sent = 0;
@@ -90,12 +94,15 @@ private:
 	void waitConnectedFailed();
 	void waitReceivedFailed();
 	void waitBetterFailed();
+	void startTestConnections();
 	void markConnectionOld();
 	void sendPingByTimer();
 	void destroyAllConnections();
 
 	void confirmBestConnection();
+	void useTestConnection(TestConnection &test);
 	void removeTestConnection(not_null<AbstractConnection*> connection);
+	void rememberConnectionFailed(const TestConnection &test);
 	[[nodiscard]] int16 getProtocolDcId() const;
 
 	void checkSentRequests();
@@ -144,6 +151,7 @@ private:
 		const QString &ip,
 		int port,
 		const bytes::vector &protocolSecret);
+	void startTestConnection(TestConnection &test);
 
 	// if badTime received - search for ids in sessionData->haveSent and sessionData->wereAcked and sync time/salt, return true if found
 	bool requestsFixTimeSalt(const QVector<MTPlong> &ids, const OuterInfo &info);
@@ -204,6 +212,8 @@ private:
 	base::Timer _waitForConnectedTimer;
 	base::Timer _waitForReceivedTimer;
 	base::Timer _waitForBetterTimer;
+	base::Timer _startTestConnectionsTimer;
+	bool _rememberConnections = false;
 	crl::time _waitForReceived = 0;
 	crl::time _waitForConnected = 0;
 	crl::time _firstSentAt = -1;
@@ -49,6 +49,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "styles/style_chat_helpers.h"
 #include "styles/style_overview.h"
 
+#include <crl/crl_async.h>
+
 namespace Overview {
 namespace Layout {
 namespace {
@@ -100,6 +102,24 @@ constexpr auto kStoryRatio = 1.46;
 	}
 }
 
+// Blurs, crops and scales a preview on a worker thread.
+void CropMediaFrameAsync(
+		QImage image,
+		int width,
+		int height,
+		bool blur,
+		Fn<void(QImage)> done) {
+	crl::async([=, image = std::move(image)]() mutable {
+		if (blur) {
+			image = Images::Blur(std::move(image));
+		}
+		auto result = CropMediaFrame(std::move(image), width, height);
+		crl::on_main([=, result = std::move(result)]() mutable {
+			done(std::move(result));
+		});
+	});
+}
+
 } // namespace
 
 class Checkbox {
@@ -365,34 +385,13 @@ int32 Photo::resizeGetHeight(int32 width) {
 
 void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const PaintContext *context) {
 	const auto selected = (selection == FullSelection);
-	const auto widthChanged = (_pix.width()
-		!= (_width * style::DevicePixelRatio()));
-	if (!_goodLoaded || widthChanged) {
-		ensureDataMediaCreated();
-		const auto good = !_spoiler
-			&& (_dataMedia->loaded()
-				|| _dataMedia->image(Data::PhotoSize::Thumbnail));
-		if ((good && !_goodLoaded) || widthChanged) {
-			_goodLoaded = good;
-			_pix = QPixmap();
-			if (_goodLoaded) {
-				setPixFrom(_dataMedia->image(Data::PhotoSize::Large)
-					? _dataMedia->image(Data::PhotoSize::Large)
-					: _dataMedia->image(Data::PhotoSize::Thumbnail));
-			} else if (const auto small = _spoiler
-				? nullptr
-				: _dataMedia->image(Data::PhotoSize::Small)) {
-				setPixFrom(small);
-			} else if (const auto blurred = _dataMedia->thumbnailInline()) {
-				setPixFrom(blurred);
-			}
-		}
-	}
+	validatePix();
 
 	if (_pix.isNull()) {
 		p.fillRect(0, 0, _width, _height, st::overviewPhotoBg);
 	} else {
-		p.drawPixmap(0, 0, _pix);
+		// Until the new size is prepared the old one is scaled.
+		p.drawPixmap(QRect(0, 0, _width, _height), _pix);
 	}
 
 	if (_spoiler) {
@@ -413,15 +412,61 @@ void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const
 	paintCheckbox(p, { checkLeft, checkTop }, selected, context);
 }
 
+void Photo::preparePreview() {
+	if (_width > 0 && _height > 0) {
+		validatePix();
+	}
+}
+
+void Photo::validatePix() {
+	const auto widthChanged = (_pixWidth != _width)
+		|| (_pix.isNull() && !_pixPending);
+	if (_goodLoaded && !widthChanged) {
+		return;
+	}
+	ensureDataMediaCreated();
+	const auto good = !_spoiler
+		&& (_dataMedia->loaded()
+			|| _dataMedia->image(Data::PhotoSize::Thumbnail));
+	if ((good && !_goodLoaded) || widthChanged) {
+		_goodLoaded = good;
+		_pixWidth = _width;
+		if (_goodLoaded) {
+			setPixFrom(_dataMedia->image(Data::PhotoSize::Large)
+				? _dataMedia->image(Data::PhotoSize::Large)
+				: _dataMedia->image(Data::PhotoSize::Thumbnail));
+		} else if (const auto small = _spoiler
+			? nullptr
+			: _dataMedia->image(Data::PhotoSize::Small)) {
+			setPixFrom(small);
+		} else if (const auto blurred = _dataMedia->thumbnailInline()) {
+			setPixFrom(blurred);
+		} else {
+			_pix = QPixmap();
+			_pixPending = false;
+			++_pixRequestId;
+		}
+	}
+}
+
 void Photo::setPixFrom(not_null<Image*> image) {
 	Expects(_width > 0 && _height > 0);
 
-	auto img = image->original();
-	if (!_goodLoaded) {
-		img = Images::Blur(std::move(img));
-	}
-	_pix = Ui::PixmapFromImage(
-		CropMediaFrame(std::move(img), _width, _height));
+	const auto requestId = ++_pixRequestId;
+	_pixPending = true;
+	CropMediaFrameAsync(
+		image->original(),
+		_width,
+		_height,
+		!_goodLoaded,
+		crl::guard(this, [=](QImage result) {
+			if (_pixRequestId != requestId) {
+				return;
+			}
+			_pixPending = false;
+			_pix = Ui::PixmapFromImage(std::move(result));
+			delegate()->repaintItem(this);
+		}));
 
 	// In case we have inline thumbnail we can unload all images and we still
 	// won't get a blank image in the media viewer when the photo is opened.
@@ -447,6 +492,8 @@ void Photo::clearSpoiler() {
 	if (_spoiler) {
 		_spoiler = nullptr;
 		_pix = QPixmap();
+		_pixPending = false;
+		++_pixRequestId;
 		delegate()->repaintItem(this);
 	}
 }
@@ -500,9 +547,7 @@ void Video::paint(Painter &p, const QRect &clip, TextSelection selection, const
 	ensureDataMediaCreated();
 
 	const auto selected = (selection == FullSelection);
-	const auto blurred = _dataMedia->thumbnailInline();
-	const auto thumbnail = _spoiler ? nullptr : _dataMedia->thumbnail();
-	const auto good = _spoiler ? nullptr : _dataMedia->goodThumbnail();
+	validatePix();
 
 	bool loaded = dataLoaded(), displayLoading = _data->displayLoading();
 	if (displayLoading) {
@@ -515,23 +560,11 @@ void Video::paint(Painter &p, const QRect &clip, TextSelection selection, const
 	const auto radial = isRadialAnimation();
 	const auto radialOpacity = radial ? _radial->opacity() : 0.;
 
-	if ((blurred || thumbnail || good)
-		&& ((_pix.width() != _width * style::DevicePixelRatio())
-			|| (_pixBlurred && (thumbnail || good)))) {
-		auto img = good
-			? good->original()
-			: thumbnail
-			? thumbnail->original()
-			: Images::Blur(blurred->original());
-		_pix = Ui::PixmapFromImage(
-			CropMediaFrame(std::move(img), _width, _height));
-		_pixBlurred = !(thumbnail || good);
-	}
-
 	if (_pix.isNull()) {
 		p.fillRect(0, 0, _width, _height, st::overviewPhotoBg);
 	} else {
-		p.drawPixmap(0, 0, _pix);
+		// Until the new size is prepared the old one is scaled.
+		p.drawPixmap(QRect(0, 0, _width, _height), _pix);
 	}
 
 	if (_spoiler) {
@@ -602,6 +635,42 @@ void Video::paint(Painter &p, const QRect &clip, TextSelection selection, const
 	paintCheckbox(p, { checkLeft, checkTop }, selected, context);
 }
 
+void Video::preparePreview() {
+	if (_width > 0 && _height > 0) {
+		ensureDataMediaCreated();
+		validatePix();
+	}
+}
+
+void Video::validatePix() {
+	const auto blurred = _dataMedia->thumbnailInline();
+	const auto thumbnail = _spoiler ? nullptr : _dataMedia->thumbnail();
+	const auto good = _spoiler ? nullptr : _dataMedia->goodThumbnail();
+	const auto widthChanged = (_pixWidth != _width)
+		|| (_pix.isNull() && !_pixPending);
+	if (!(blurred || thumbnail || good)
+		|| (!widthChanged && !(_pixBlurred && (thumbnail || good)))) {
+		return;
+	}
+	const auto requestId = ++_pixRequestId;
+	_pixWidth = _width;
+	_pixPending = true;
+	_pixBlurred = !(thumbnail || good);
+	CropMediaFrameAsync(
+		(good ? good : thumbnail ? thumbnail : blurred)->original(),
+		_width,
+		_height,
+		_pixBlurred,
+		crl::guard(this, [=](QImage result) {
+			if (_pixRequestId != requestId) {
+				return;
+			}
+			_pixPending = false;
+			_pix = Ui::PixmapFromImage(std::move(result));
+			delegate()->repaintItem(this);
+		}));
+}
+
 void Video::ensureDataMediaCreated() const {
 	if (_dataMedia) {
 		return;
@@ -616,6 +685,8 @@ void Video::clearSpoiler() {
 	if (_spoiler) {
 		_spoiler = nullptr;
 		_pix = QPixmap();
+		_pixPending = false;
+		++_pixRequestId;
 		delegate()->repaintItem(this);
 	}
 }
@@ -74,6 +74,10 @@ public:
 	virtual void clearHeavyPart() {
 	}
 
+	// Called for items near the visible area to prepare their previews.
+	virtual void preparePreview() {
+	}
+
 protected:
 	[[nodiscard]] not_null<HistoryItem*> parent() const {
 		return _parent;
@@ -205,9 +209,11 @@ public:
 		StateRequest request) const override;
 
 	void clearHeavyPart() override;
+	void preparePreview() override;
 
 private:
 	void ensureDataMediaCreated() const;
+	void validatePix();
 	void setPixFrom(not_null<Image*> image);
 	void clearSpoiler();
 
@@ -217,6 +223,9 @@ private:
 	std::unique_ptr<Ui::SpoilerAnimation> _spoiler;
 
 	QPixmap _pix;
+	int _pixWidth = 0;
+	int _pixRequestId = 0;
+	bool _pixPending = false;
 	bool _goodLoaded = false;
 	bool _story = false;
 
@@ -298,6 +307,7 @@ public:
 
 	void clearHeavyPart() override;
 	void clearSpoiler() override;
+	void preparePreview() override;
 
 protected:
 	float64 dataProgress() const override;
@@ -307,6 +317,7 @@ protected:
 
 private:
 	void ensureDataMediaCreated() const;
+	void validatePix();
 	void updateStatusText();
 
 	const not_null<DocumentData*> _data;
@@ -317,6 +328,9 @@ private:
 	std::unique_ptr<Ui::SpoilerAnimation> _spoiler;
 
 	QPixmap _pix;
+	int _pixWidth = 0;
+	int _pixRequestId = 0;
+	bool _pixPending = false;
 	bool _pixBlurred = true;
 	bool _story = false;
 
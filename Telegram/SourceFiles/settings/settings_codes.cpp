@@ -21,6 +21,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "mtproto/mtp_instance.h"
 #include "mtproto/mtproto_dc_options.h"
+#include "core/core_trace.h"
 #include "core/file_utilities.h"
 #include "core/update_checker.h"
 #include "window/themes/window_theme.h"
@@ -29,6 +30,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/audio/media_audio_track.h"
 #include "settings/settings_folders.h"
 #include "api/api_updates.h"
+#include "api/api_updates_recorder.h"
 #include "base/qt/qt_common_adapters.h"
 #include "base/custom_app_icon.h"
 #include "boxes/abstract_box.h" // Ui::show().
@@ -84,6 +86,13 @@ auto GenerateCodes() {
 	codes.emplace(u"viewlogs"_q, [](SessionController *window) {
 		File::ShowInFolder(cWorkingDir() + "log.txt");
 	});
+	codes.emplace(u"tracedump"_q, [](SessionController *window) {
+		if (!Core::Trace::Enabled()) {
+			Ui::Toast::Show(u"Enable main thread tracing first."_q);
+		} else if (const auto path = Core::Trace::Dump(); !path.isEmpty()) {
+			File::ShowInFolder(path);
+		}
+	});
 	if (!Core::UpdaterDisabled()) {
 		codes.emplace(u"testupdate"_q, [](SessionController *window) {
 			Core::UpdateChecker().test();
@@ -140,6 +149,74 @@ auto GenerateCodes() {
 			}
 		});
 	});
+	codes.emplace(u"recordupdates"_q, [](SessionController *window) {
+		if (!window) {
+			return;
+		}
+		if (window->session().updates().recording()) {
+			window->session().updates().stopRecording();
+			Ui::Toast::Show(u"Updates recording stopped."_q);
+			return;
+		}
+		const auto weak = base::make_weak(window);
+		FileDialog::GetWritePath(Core::App().getFileDialogParent(), "Record updates", "Recorded updates (*.tdupdates)", filedialogDefaultName(u"updates"_q, u".tdupdates"_q), [=](const QString &path) {
+			const auto strong = weak.get();
+			if (strong
+				&& !path.isEmpty()
+				&& strong->session().updates().startRecording(path)) {
+				Ui::Toast::Show(u"Updates recording started."_q);
+			}
+		});
+	});
+	codes.emplace(u"replayupdates"_q, [](SessionController *window) {
+		if (!Core::App().domain().started()) {
+			return;
+		}
+		FileDialog::GetOpenPath(Core::App().getFileDialogParent(), "Open recorded updates", "Recorded updates (*.tdupdates)", [](const FileDialog::OpenResult &result) {
+			if (result.paths.isEmpty()) {
+				return;
+			}
+			const auto report = Api::ReplayInThrowawaySession(
+				result.paths.front());
+			LOG(("Updates Replay:\n%1").arg(report));
+			Ui::show(Ui::MakeInformBox(report));
+		});
+	});
+	codes.emplace(u"connectionstats"_q, [](SessionController *window) {
+		if (!window) {
+			return;
+		}
+		using Options = MTP::DcOptions;
+		const auto &options = window->session().account().mtp().dcOptions();
+		auto lines = QStringList();
+		for (const auto &entry : options.connectionStats()) {
+			const auto type = (entry.type == MTP::DcType::MediaCluster)
+				? u"media"_q
+				: (entry.type == MTP::DcType::Cdn)
+				? u"cdn"_q
+				: u"regular"_q;
+			const auto protocol = (entry.endpoint.protocol
+				== Options::Variants::Tcp)
+				? u"tcp"_q
+				: u"http"_q;
+			lines.push_back(u"DC %1 %2: %3 %4:%5, %6 ms, "
+				"succeeded %7, failed %8%9"_q
+				.arg(entry.dcId)
+				.arg(type)
+				.arg(protocol)
+				.arg(QString::fromStdString(entry.endpoint.ip))
+				.arg(entry.endpoint.port)
+				.arg(entry.duration)
+				.arg(entry.successes)
+				.arg(entry.failures)
+				.arg(entry.chosen ? u", tried first"_q : QString()));
+		}
+		const auto text = lines.isEmpty()
+			? u"No direct connections remembered."_q
+			: lines.join('\n');
+		LOG(("Connection Stats:\n%1").arg(text));
+		Ui::show(Ui::MakeInformBox(text));
+	});
 	codes.emplace(u"testmode"_q, [](SessionController *window) {
 		auto &domain = Core::App().domain();
 		if (domain.started()
@@ -30,8 +30,15 @@ struct WriteEntry {
 	QString base;
 	QByteArray data;
 	QByteArray md5;
+	bool remove = false;
 };
 
+void RemoveFiles(const QString &base) {
+	QFile::remove(base + '0');
+	QFile::remove(base + '1');
+	QFile::remove(base + 's');
+}
+
 class WriteManager final {
 public:
 	explicit WriteManager(crl::weak_on_thread<WriteManager> weak);
@@ -63,6 +70,7 @@ class AsyncWriteManager final {
 public:
 	void write(WriteEntry &&entry);
 	void writeSync(WriteEntry &&entry);
+	void remove(const QString &base);
 	void sync();
 	void stop();
 
@@ -95,6 +103,10 @@ void WriteManager::writeSync(WriteEntry &&entry) {
 }
 
 void WriteManager::writeNow(WriteEntry &&entry) {
+	if (entry.remove) {
+		RemoveFiles(entry.base);
+		return;
+	}
 	const auto path = [&](char postfix) {
 		return this->path(entry, postfix);
 	};
@@ -218,6 +230,17 @@ void AsyncWriteManager::writeSync(WriteEntry &&entry) {
 	});
 }
 
+void AsyncWriteManager::remove(const QString &base) {
+	if (_finished || !_manager) {
+		// Nothing can be scheduled for this file, remove it right away.
+		RemoveFiles(base);
+		return;
+	}
+	// Go through the queue, so that a pending write of the same file
+	// is dropped instead of resurrecting it after the removal.
+	write(WriteEntry{ .base = base, .remove = true });
+}
+
 void AsyncWriteManager::sync() {
 	if (_manager) {
 		_manager->with_sync([](WriteManager &manager) {
@@ -280,14 +303,7 @@ FileKey GenerateKey(const QString &basePath) {
 }
 
 void ClearKey(const FileKey &key, const QString &basePath) {
-	QString name;
-	name.reserve(basePath.size() + 0x11);
-	name.append(basePath).append(ToFilePart(key)).append('0');
-	QFile::remove(name);
-	name[name.size() - 1] = '1';
-	QFile::remove(name);
-	name[name.size() - 1] = 's';
-	QFile::remove(name);
+	Manager.remove(basePath + ToFilePart(key));
 }
 
 bool CheckStreamStatus(QDataStream &stream) {
@@ -71,7 +71,7 @@ void DownloadManagerMtproto::Queue::resetGeneration() {
 	const auto from = ranges::find(_tasks, 0, &Enqueued::priority);
 	for (auto &task : ranges::make_subrange(from, end(_tasks))) {
 		if (task.priority) {
-			Assert(task.priority == -1);
+			Assert(task.priority < 0);
 			break;
 		}
 		task.priority = -1;
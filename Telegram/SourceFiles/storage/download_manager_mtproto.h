@@ -25,6 +25,9 @@ namespace Storage {
 // fixed part size download for hash checking.
 constexpr auto kDownloadPartSize = 128 * 1024;
 
+// Tasks with this priority get parts only when no other task is ready.
+constexpr auto kBackgroundDownloadPriority = -2;
+
 class DownloadMtprotoTask;
 
 class DownloadManagerMtproto final : public base::has_weak_ptr {
@@ -35,6 +35,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/export_settings.h"
 #include "window/themes/window_theme.h"
 
+#include <xxhash.h> // XXH64.
+
 namespace Storage {
 namespace {
 
@@ -48,6 +50,9 @@ constexpr auto kStickersSerializeVersion = 4;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 
+// Journal is replaced by a new snapshot when it becomes a quarter of it.
+constexpr auto kStickersJournalMaxPart = 4;
+
 constexpr auto kSinglePeerTypeUserOld = qint32(1);
 constexpr auto kSinglePeerTypeChatOld = qint32(2);
 constexpr auto kSinglePeerTypeChannelOld = qint32(3);
@@ -87,6 +92,7 @@ enum { // Local Storage Keys
 	lskSelfSerialized = 0x15, // serialized self
 	lskMasksKeys = 0x16, // no data
 	lskCustomEmojiKeys = 0x17, // no data
+	lskStickersJournalKeys = 0x18, // no data
 };
 
 auto EmptyMessageDraftSources()
@@ -146,6 +152,10 @@ Account::~Account() {
 	}
 }
 
+QString Account::basePath() const {
+	return _basePath;
+}
+
 QString Account::tempDirectory() const {
 	return _tempPath;
 }
@@ -209,6 +219,8 @@ base::flat_set<QString> Account::collectGoodNames() const {
 		_installedCustomEmojiKey,
 		_featuredCustomEmojiKey,
 		_archivedCustomEmojiKey,
+		_installedStickersJournal.key,
+		_installedCustomEmojiJournal.key,
 	};
 	auto result = base::flat_set<QString>{
 		"map0",
@@ -291,6 +303,7 @@ Account::ReadMapResult Account::readMapWith(
 	quint64 installedStickersKey = 0, featuredStickersKey = 0, recentStickersKey = 0, favedStickersKey = 0, archivedStickersKey = 0;
 	quint64 installedMasksKey = 0, recentMasksKey = 0, archivedMasksKey = 0;
 	quint64 installedCustomEmojiKey = 0, featuredCustomEmojiKey = 0, archivedCustomEmojiKey = 0;
+	quint64 installedStickersJournalKey = 0, installedCustomEmojiJournalKey = 0;
 	quint64 savedGifsKey = 0;
 	quint64 legacyBackgroundKeyDay = 0, legacyBackgroundKeyNight = 0;
 	quint64 userSettingsKey = 0, recentHashtagsAndBotsKey = 0, exportSettingsKey = 0;
@@ -399,6 +412,11 @@ Account::ReadMapResult Account::readMapWith(
 				>> featuredCustomEmojiKey
 				>> archivedCustomEmojiKey;
 		} break;
+		case lskStickersJournalKeys: {
+			map.stream
+				>> installedStickersJournalKey
+				>> installedCustomEmojiJournalKey;
+		} break;
 		default:
 			LOG(("App Error: unknown key type in encrypted map: %1").arg(keyType));
 			return ReadMapResult::Failed;
@@ -429,6 +447,8 @@ Account::ReadMapResult Account::readMapWith(
 	_installedCustomEmojiKey = installedCustomEmojiKey;
 	_featuredCustomEmojiKey = featuredCustomEmojiKey;
 	_archivedCustomEmojiKey = archivedCustomEmojiKey;
+	_installedStickersJournal.key = installedStickersJournalKey;
+	_installedCustomEmojiJournal.key = installedCustomEmojiJournalKey;
 	_legacyBackgroundKeyDay = legacyBackgroundKeyDay;
 	_legacyBackgroundKeyNight = legacyBackgroundKeyNight;
 	_settingsKey = userSettingsKey;
@@ -474,7 +494,12 @@ void Account::writeMapDelayed() {
 
 void Account::writeMapQueued() {
 	_mapChanged = true;
+	if (_writeMapQueued) {
+		return;
+	}
+	_writeMapQueued = true;
 	crl::on_main(_owner, [=] {
+		_writeMapQueued = false;
 		writeMap();
 	});
 }
@@ -539,6 +564,9 @@ void Account::writeMap() {
 	if (_installedCustomEmojiKey || _featuredCustomEmojiKey || _archivedCustomEmojiKey) {
 		mapSize += sizeof(quint32) + 3 * sizeof(quint64);
 	}
+	if (_installedStickersJournal.key || _installedCustomEmojiJournal.key) {
+		mapSize += sizeof(quint32) + 2 * sizeof(quint64);
+	}
 
 	EncryptedDescriptor mapData(mapSize);
 	if (!self.isEmpty()) {
@@ -598,6 +626,12 @@ void Account::writeMap() {
 			<< quint64(_featuredCustomEmojiKey)
 			<< quint64(_archivedCustomEmojiKey);
 	}
+	if (_installedStickersJournal.key || _installedCustomEmojiJournal.key) {
+		mapData.stream << quint32(lskStickersJournalKeys);
+		mapData.stream
+			<< quint64(_installedStickersJournal.key)
+			<< quint64(_installedCustomEmojiJournal.key);
+	}
 	map.writeEncrypted(mapData, _localKey);
 
 	_mapChanged = false;
@@ -622,6 +656,8 @@ void Account::reset() {
 	_installedCustomEmojiKey = 0;
 	_featuredCustomEmojiKey = 0;
 	_archivedCustomEmojiKey = 0;
+	_installedStickersJournal = StickerSetsJournal();
+	_installedCustomEmojiJournal = StickerSetsJournal();
 	_legacyBackgroundKeyDay = _legacyBackgroundKeyNight = 0;
 	_settingsKey = _recentHashtagsAndBotsKey = _exportSettingsKey = 0;
 	_oldMapVersion = 0;
@@ -1714,6 +1750,18 @@ void Account::writeStickerSet(
 	}
 }
 
+QByteArray Account::serializeStickerSet(const Data::StickersSet &set) {
+	auto result = QByteArray();
+	{
+		QBuffer buffer(&result);
+		buffer.open(QIODevice::WriteOnly);
+		QDataStream stream(&buffer);
+		stream.setVersion(QDataStream::Qt_5_1);
+		writeStickerSet(stream, set);
+	}
+	return result;
+}
+
 // In generic method _writeStickerSets() we look through all the sets and call a
 // callback on each set to see, if we write it, skip it or abort the whole write.
 enum class StickerSetCheckResult {
@@ -1727,17 +1775,48 @@ template <typename CheckSet>
 void Account::writeStickerSets(
 		FileKey &stickersKey,
 		CheckSet checkSet,
-		const Data::StickersSetsOrder &order) {
+		const Data::StickersSetsOrder &order,
+		StickerSetsJournal *journal) {
 	using SetFlag = Data::StickersSetFlag;
 
 	const auto &sets = _owner->session().data().stickers().sets();
 	if (sets.empty()) {
+		if (journal) {
+			clearStickerSetsJournal(*journal);
+		}
 		if (stickersKey) {
 			ClearKey(stickersKey, _basePath);
 			stickersKey = 0;
 			writeMapDelayed();
 		}
 		return;
+	} else if (journal) {
+		auto serialized = std::vector<SerializedStickerSet>();
+		serialized.reserve(sets.size());
+		for (const auto &[id, set] : sets) {
+			const auto result = checkSet(*set);
+			if (result == StickerSetCheckResult::Abort) {
+				return;
+			} else if (result == StickerSetCheckResult::Skip) {
+				continue;
+			}
+			auto bytes = serializeStickerSet(*set);
+			if (bytes.isEmpty()) {
+				continue;
+			}
+			const auto hash = XXH64(bytes.constData(), bytes.size(), 0);
+			serialized.push_back({
+				.id = id,
+				.hash = uint64(hash),
+				.bytes = std::move(bytes),
+			});
+		}
+		writeStickerSetsJournaled(
+			stickersKey,
+			*journal,
+			std::move(serialized),
+			order);
+		return;
 	}
 
 	// versionTag + version + count
@@ -1826,6 +1905,138 @@ void Account::writeStickerSets(
 	file.writeEncrypted(data, _localKey);
 }
 
+void Account::writeStickerSetsJournaled(
+		FileKey &stickersKey,
+		StickerSetsJournal &journal,
+		std::vector<SerializedStickerSet> &&sets,
+		const Data::StickersSetsOrder &order) {
+	if (sets.empty() && order.isEmpty()) {
+		clearStickerSetsJournal(journal);
+		if (stickersKey) {
+			ClearKey(stickersKey, _basePath);
+			stickersKey = 0;
+			writeMapDelayed();
+		}
+		return;
+	}
+	auto all = std::vector<not_null<const SerializedStickerSet*>>();
+	auto changed = std::vector<not_null<const SerializedStickerSet*>>();
+	auto fullSize = int64();
+	auto changedSize = int64();
+	all.reserve(sets.size());
+	for (const auto &set : sets) {
+		all.push_back(&set);
+		fullSize += set.bytes.size();
+		const auto i = journal.snapshot.find(set.id);
+		if (i == end(journal.snapshot) || i->second != set.hash) {
+			changed.push_back(&set);
+			changedSize += set.bytes.size();
+		}
+	}
+	const auto journaled = stickersKey
+		&& !journal.snapshot.empty()
+		&& (changedSize * kStickersJournalMaxPart <= fullSize);
+	if (journaled) {
+		if (!journal.key) {
+			journal.key = GenerateKey(_basePath);
+			writeMapQueued();
+		}
+		writeStickerSetsFile(journal.key, changed, order);
+		return;
+	}
+
+	// The journal is cleared before the snapshot is rewritten, so that
+	// it never gets applied on top of a snapshot it wasn't made for.
+	clearStickerSetsJournal(journal);
+	if (!stickersKey) {
+		stickersKey = GenerateKey(_basePath);
+		writeMapQueued();
+	}
+	writeStickerSetsFile(stickersKey, all, order);
+	for (const auto &set : sets) {
+		journal.snapshot.emplace(set.id, set.hash);
+	}
+}
+
+void Account::writeStickerSetsFile(
+		FileKey &key,
+		const std::vector<not_null<const SerializedStickerSet*>> &sets,
+		const Data::StickersSetsOrder &order) {
+	// versionTag + version + count + sets + order
+	auto size = quint32(sizeof(quint32) + sizeof(qint32) * 2);
+	for (const auto set : sets) {
+		size += set->bytes.size();
+	}
+	size += sizeof(qint32) + (order.size() * sizeof(quint64));
+
+	EncryptedDescriptor data(size);
+	data.stream
+		<< quint32(kStickersVersionTag)
+		<< qint32(kStickersSerializeVersion)
+		<< qint32(sets.size());
+	for (const auto set : sets) {
+		data.stream.writeRawData(set->bytes.constData(), set->bytes.size());
+	}
+	data.stream << order;
+
+	FileWriteDescriptor file(key, _basePath);
+	file.writeEncrypted(data, _localKey);
+}
+
+void Account::clearStickerSetsJournal(StickerSetsJournal &journal) {
+	journal.snapshot.clear();
+	if (journal.key) {
+		ClearKey(journal.key, _basePath);
+		journal.key = 0;
+		writeMapDelayed();
+	}
+}
+
+void Account::readStickerSets(
+		FileKey &stickersKey,
+		StickerSetsJournal &journal,
+		Data::StickersSetsOrder *outOrder,
+		Data::StickersSetFlags readingFlags) {
+	Expects(outOrder != nullptr);
+
+	if (!journal.key) {
+		readStickerSets(stickersKey, outOrder, readingFlags);
+		return;
+	}
+
+	// Sets from the journal are read first, so that their older versions
+	// from the snapshot don't fill them. The order is always the journal's.
+	auto order = Data::StickersSetsOrder();
+	readStickerSets(journal.key, &order);
+	if (!journal.key) {
+		readStickerSets(stickersKey, outOrder, readingFlags);
+		return;
+	}
+	auto snapshotOrder = Data::StickersSetsOrder();
+	readStickerSets(stickersKey, &snapshotOrder);
+	*outOrder = std::move(order);
+	applyStickerSetsOrderFlags(*outOrder, readingFlags);
+}
+
+void Account::applyStickerSetsOrderFlags(
+		const Data::StickersSetsOrder &order,
+		Data::StickersSetFlags readingFlags) {
+	using SetFlag = Data::StickersSetFlag;
+
+	auto &sets = _owner->session().data().stickers().setsRef();
+	for (const auto setId : order) {
+		auto it = sets.find(setId);
+		if (it != sets.cend()) {
+			const auto set = it->second.get();
+			set->flags |= readingFlags;
+			if ((readingFlags == SetFlag::Installed)
+				&& !set->installDate) {
+				set->installDate = kDefaultStickerInstallDate;
+			}
+		}
+	}
+}
+
 void Account::readStickerSets(
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder,
@@ -2080,17 +2291,7 @@ void Account::readStickerSets(
 
 	// Set flags that we dropped above from the order.
 	if (readingFlags && outOrder) {
-		for (const auto setId : std::as_const(*outOrder)) {
-			auto it = sets.find(setId);
-			if (it != sets.cend()) {
-				const auto set = it->second.get();
-				set->flags |= readingFlags;
-				if ((readingFlags == SetFlag::Installed)
-					&& !set->installDate) {
-					set->installDate = kDefaultStickerInstallDate;
-				}
-			}
-		}
+		applyStickerSetsOrderFlags(*outOrder, readingFlags);
 	}
 }
 
@@ -2118,7 +2319,7 @@ void Account::writeInstalledStickers() {
 			return StickerSetCheckResult::Skip;
 		}
 		return StickerSetCheckResult::Write;
-	}, _owner->session().data().stickers().setsOrder());
+	}, _owner->session().data().stickers().setsOrder(), &_installedStickersJournal);
 }
 
 void Account::writeFeaturedStickers() {
@@ -2243,7 +2444,7 @@ void Account::writeInstalledCustomEmoji() {
 			return StickerSetCheckResult::Skip;
 		}
 		return StickerSetCheckResult::Write;
-	}, _owner->session().data().stickers().emojiSetsOrder());
+	}, _owner->session().data().stickers().emojiSetsOrder(), &_installedCustomEmojiJournal);
 }
 
 void Account::importOldRecentStickers() {
@@ -2374,6 +2575,7 @@ void Account::readInstalledStickers() {
 	_owner->session().data().stickers().setsRef().clear();
 	readStickerSets(
 		_installedStickersKey,
+		_installedStickersJournal,
 		&_owner->session().data().stickers().setsOrderRef(),
 		Data::StickersSetFlag::Installed);
 }
@@ -2448,6 +2650,7 @@ void Account::readInstalledMasks() {
 void Account::readInstalledCustomEmoji() {
 	readStickerSets(
 		_installedCustomEmojiKey,
+		_installedCustomEmojiJournal,
 		&_owner->session().data().stickers().emojiSetsOrderRef(),
 		Data::StickersSetFlag::Installed);
 }
@@ -2698,6 +2901,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 		&& settings.path == check.path
 		&& settings.format == check.format
 		&& settings.availableAt == check.availableAt
+		&& settings.delta == check.delta
 		&& !settings.onlySinglePeer()) {
 		if (_exportSettingsKey) {
 			ClearKey(_exportSettingsKey, _basePath);
@@ -2712,7 +2916,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 	}
 	quint32 size = sizeof(quint32) * 6
 		+ Serialize::stringSize(settings.path)
-		+ sizeof(qint32) * 2 + sizeof(quint64);
+		+ sizeof(qint32) * 3 + sizeof(quint64);
 	EncryptedDescriptor data(size);
 	data.stream
 		<< quint32(settings.types)
@@ -2745,6 +2949,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 	});
 	data.stream << qint32(settings.singlePeerFrom);
 	data.stream << qint32(settings.singlePeerTill);
+	data.stream << qint32(settings.delta ? 1 : 0);
 
 	FileWriteDescriptor file(_exportSettingsKey, _basePath);
 	file.writeEncrypted(data, _localKey);
@@ -2767,6 +2972,7 @@ Export::Settings Account::readExportSettings() {
 	quint64 singlePeerBareId = 0;
 	quint64 singlePeerAccessHash = 0;
 	qint32 singlePeerFrom = 0, singlePeerTill = 0;
+	qint32 delta = 0;
 	file.stream
 		>> types
 		>> fullChats
@@ -2797,6 +3003,9 @@ Export::Settings Account::readExportSettings() {
 	if (!file.stream.atEnd()) {
 		file.stream >> singlePeerFrom >> singlePeerTill;
 	}
+	if (!file.stream.atEnd()) {
+		file.stream >> delta;
+	}
 	auto result = Export::Settings();
 	result.types = Export::Settings::Types::from_raw(types);
 	result.fullChats = Export::Settings::Types::from_raw(fullChats);
@@ -2837,6 +3046,7 @@ Export::Settings Account::readExportSettings() {
 	}();
 	result.singlePeerFrom = singlePeerFrom;
 	result.singlePeerTill = singlePeerTill;
+	result.delta = (delta == 1);
 	return (file.stream.status() == QDataStream::Ok && result.validate())
 		? result
 		: Export::Settings();
@@ -74,6 +74,7 @@ public:
 		return _oldMapVersion;
 	}
 
+	[[nodiscard]] QString basePath() const;
 	[[nodiscard]] QString tempDirectory() const;
 
 	[[nodiscard]] MTP::AuthKeyPtr peekLegacyLocalKey() const {
@@ -227,18 +228,51 @@ private:
 		details::FileReadDescriptor &draft,
 		quint64 draftPeerSerialized);
 
+	// Big collections are written as a snapshot plus a journal file with
+	// the sets changed since that snapshot and the current order.
+	struct StickerSetsJournal {
+		FileKey key = 0;
+		base::flat_map<uint64, uint64> snapshot; // set id -> content hash
+	};
+	struct SerializedStickerSet {
+		uint64 id = 0;
+		uint64 hash = 0;
+		QByteArray bytes;
+	};
+
 	void writeStickerSet(
 		QDataStream &stream,
 		const Data::StickersSet &set);
+	[[nodiscard]] QByteArray serializeStickerSet(
+		const Data::StickersSet &set);
 	template <typename CheckSet>
 	void writeStickerSets(
 		FileKey &stickersKey,
 		CheckSet checkSet,
+		const Data::StickersSetsOrder &order,
+		StickerSetsJournal *journal = nullptr);
+	void writeStickerSetsJournaled(
+		FileKey &stickersKey,
+		StickerSetsJournal &journal,
+		std::vector<SerializedStickerSet> &&sets,
+		const Data::StickersSetsOrder &order);
+	void writeStickerSetsFile(
+		FileKey &key,
+		const std::vector<not_null<const SerializedStickerSet*>> &sets,
 		const Data::StickersSetsOrder &order);
+	void clearStickerSetsJournal(StickerSetsJournal &journal);
 	void readStickerSets(
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder = nullptr,
 		Data::StickersSetFlags readingFlags = 0);
+	void readStickerSets(
+		FileKey &stickersKey,
+		StickerSetsJournal &journal,
+		Data::StickersSetsOrder *outOrder,
+		Data::StickersSetFlags readingFlags);
+	void applyStickerSetsOrderFlags(
+		const Data::StickersSetsOrder &order,
+		Data::StickersSetFlags readingFlags);
 	void importOldRecentStickers();
 
 	void readTrustedBots();
@@ -291,6 +325,8 @@ private:
 	FileKey _installedCustomEmojiKey = 0;
 	FileKey _featuredCustomEmojiKey = 0;
 	FileKey _archivedCustomEmojiKey = 0;
+	StickerSetsJournal _installedStickersJournal;
+	StickerSetsJournal _installedCustomEmojiJournal;
 
 	qint64 _cacheTotalSizeLimit = 0;
 	qint64 _cacheBigFileTotalSizeLimit = 0;
@@ -307,6 +343,7 @@ private:
 	base::Timer _writeMapTimer;
 	base::Timer _writeLocationsTimer;
 	bool _mapChanged = false;
+	bool _writeMapQueued = false;
 	bool _locationsChanged = false;
 
 };
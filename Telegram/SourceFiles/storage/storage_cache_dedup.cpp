@@ -0,0 +1,75 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_cache_dedup.h"
+
+#include <xxhash.h> // XXH64.
+
+namespace Storage {
+namespace {
+
+constexpr auto kMaxRemembered = 16384;
+
+} // namespace
+
+size_t CacheDeduplicator::KeyHash::operator()(
+		const Cache::Key &key) const {
+	return size_t(key.high ^ (key.low * 0x9E3779B97F4A7C15ULL));
+}
+
+CacheDeduplicator::CacheDeduplicator(QString name)
+: _name(std::move(name)) {
+}
+
+CacheDeduplicator::~CacheDeduplicator() {
+	if (!_stats.writes) {
+		return;
+	}
+	DEBUG_LOG(("Cache Info: %1 writes %2 (%3 bytes), "
+		"repeated %4 (%5 bytes), "
+		"same content under other keys %6 (%7 bytes)."
+		).arg(_name
+		).arg(_stats.writes
+		).arg(_stats.writtenBytes
+		).arg(_stats.repeated
+		).arg(_stats.repeatedBytes
+		).arg(_stats.shared
+		).arg(_stats.sharedBytes));
+}
+
+void CacheDeduplicator::put(
+		Cache::Database &database,
+		Cache::Key key,
+		Cache::Database::TaggedValue &&value) {
+	const auto size = int(value.bytes.size());
+	const auto hash = uint64(XXH64(value.bytes.constData(), size, 0));
+
+	++_stats.writes;
+	_stats.writtenBytes += size;
+
+	const auto i = _byKey.find(key);
+	if (i != end(_byKey) && i->second.hash == hash && i->second.size == size) {
+		++_stats.repeated;
+		_stats.repeatedBytes += size;
+		database.putIfEmpty(key, std::move(value));
+		return;
+	}
+	const auto j = _byHash.find(hash);
+	if (j != end(_byHash) && !(j->second == key)) {
+		++_stats.shared;
+		_stats.sharedBytes += size;
+	}
+	if (_byKey.size() >= kMaxRemembered) {
+		_byKey.clear();
+		_byHash.clear();
+	}
+	_byKey[key] = Written{ .hash = hash, .size = size };
+	_byHash[hash] = key;
+	database.put(key, std::move(value));
+}
+
+} // namespace Storage
@@ -0,0 +1,56 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_database.h"
+
+#include <unordered_map>
+
+namespace Storage {
+
+struct CacheDedupStats {
+	int64 writes = 0;
+	int64 writtenBytes = 0;
+	int64 repeated = 0;
+	int64 repeatedBytes = 0;
+	int64 shared = 0;
+	int64 sharedBytes = 0;
+};
+
+// Remembers content hashes of the entries written to a cache database
+// during this session. A write of the same bytes under the same key is
+// turned into putIfEmpty, so the database skips it unless the entry was
+// evicted. Same bytes under another key are only counted, the database
+// has no way to share one stored block between several keys.
+class CacheDeduplicator final {
+public:
+	explicit CacheDeduplicator(QString name);
+	~CacheDeduplicator();
+
+	void put(
+		Cache::Database &database,
+		Cache::Key key,
+		Cache::Database::TaggedValue &&value);
+
+private:
+	struct KeyHash {
+		size_t operator()(const Cache::Key &key) const;
+	};
+	struct Written {
+		uint64 hash = 0;
+		int size = 0;
+	};
+
+	const QString _name;
+	std::unordered_map<Cache::Key, Written, KeyHash> _byKey;
+	std::unordered_map<uint64, Cache::Key> _byHash;
+	CacheDedupStats _stats;
+
+};
+
+} // namespace Storage
@@ -10,22 +10,163 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/empty_userpic.h"
 #include "ui/image/image_prepare.h"
 
+#include <crl/crl_async.h>
+
 namespace Ui {
+namespace {
 
-float64 ForumUserpicRadiusMultiplier() {
-	return 0.3;
+// Scaled userpics of all peers together shouldn't take more than that.
+constexpr auto kSharedCacheLimit = 24 * 1024 * 1024;
+
+struct SharedKey {
+	qint64 image = 0;
+	int size = 0;
+	bool forum = false;
+
+	friend inline auto operator<=>(SharedKey, SharedKey) = default;
+	friend inline bool operator==(SharedKey, SharedKey) = default;
+};
+
+class SharedUserpicCache final : public base::has_weak_ptr {
+public:
+	[[nodiscard]] QImage lookup(const QImage &cloud, int size, bool forum);
+
+	// Returns a null image and prepares it in the background on a miss.
+	[[nodiscard]] QImage request(const QImage &cloud, int size, bool forum);
+
+	[[nodiscard]] rpl::producer<> prepared() const;
+
+private:
+	struct Entry {
+		QImage image;
+		uint64 used = 0;
+	};
+
+	[[nodiscard]] QImage find(SharedKey key);
+	void insert(SharedKey key, QImage image);
+	void evict();
+
+	base::flat_map<SharedKey, Entry> _entries;
+	base::flat_set<SharedKey> _preparing;
+	rpl::event_stream<> _prepared;
+	uint64 _counter = 0;
+	int64 _bytes = 0;
+
+};
+
+[[nodiscard]] QImage GenerateUserpic(
+		const QImage &cloud,
+		int size,
+		bool forum,
+		Qt::TransformationMode mode = Qt::SmoothTransformation) {
+	auto result = cloud.scaled(
+		QSize(size, size),
+		Qt::IgnoreAspectRatio,
+		mode);
+	if (forum) {
+		return Images::Round(
+			std::move(result),
+			Images::CornersMask(size
+				* ForumUserpicRadiusMultiplier()
+				/ style::DevicePixelRatio()));
+	}
+	return Images::Circle(std::move(result));
 }
 
-bool PeerUserpicLoading(const PeerUserpicView &view) {
-	return view.cloud && view.cloud->isNull();
+[[nodiscard]] int64 ImageBytes(const QImage &image) {
+	return int64(image.bytesPerLine()) * image.height();
 }
 
-void ValidateUserpicCache(
+QImage SharedUserpicCache::find(SharedKey key) {
+	if (const auto i = _entries.find(key); i != end(_entries)) {
+		i->second.used = ++_counter;
+		return i->second.image;
+	}
+	return QImage();
+}
+
+QImage SharedUserpicCache::lookup(
+		const QImage &cloud,
+		int size,
+		bool forum) {
+	const auto key = SharedKey{ cloud.cacheKey(), size, forum };
+	if (auto result = find(key); !result.isNull()) {
+		return result;
+	}
+	auto result = GenerateUserpic(cloud, size, forum);
+	insert(key, result);
+	return result;
+}
+
+QImage SharedUserpicCache::request(
+		const QImage &cloud,
+		int size,
+		bool forum) {
+	const auto key = SharedKey{ cloud.cacheKey(), size, forum };
+	if (auto result = find(key); !result.isNull()) {
+		return result;
+	} else if (!_preparing.emplace(key).second) {
+		return QImage();
+	}
+	crl::async([=, weak = base::make_weak(this)] {
+		auto image = GenerateUserpic(cloud, size, forum);
+		crl::on_main(weak, [=, image = std::move(image)]() mutable {
+			_preparing.remove(key);
+			insert(key, std::move(image));
+			_prepared.fire({});
+		});
+	});
+	return QImage();
+}
+
+rpl::producer<> SharedUserpicCache::prepared() const {
+	return _prepared.events();
+}
+
+void SharedUserpicCache::insert(SharedKey key, QImage image) {
+	_bytes += ImageBytes(image);
+	const auto i = _entries.find(key);
+	if (i != end(_entries)) {
+		_bytes -= ImageBytes(i->second.image);
+		i->second = Entry{ std::move(image), ++_counter };
+	} else {
+		_entries.emplace(key, Entry{ std::move(image), ++_counter });
+	}
+	if (_bytes > kSharedCacheLimit) {
+		evict();
+	}
+}
+
+void SharedUserpicCache::evict() {
+	auto order = std::vector<std::pair<uint64, SharedKey>>();
+	order.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		order.emplace_back(entry.used, key);
+	}
+	ranges::sort(order);
+	const auto till = kSharedCacheLimit * 3 / 4;
+	for (const auto &[used, key] : order) {
+		if (_bytes <= till) {
+			break;
+		}
+		const auto i = _entries.find(key);
+		_bytes -= ImageBytes(i->second.image);
+		_entries.erase(i);
+	}
+}
+
+[[nodiscard]] SharedUserpicCache &SharedCache() {
+	static auto result = SharedUserpicCache();
+	return result;
+}
+
+void ValidateCache(
 		PeerUserpicView &view,
 		const QImage *cloud,
 		const EmptyUserpic *empty,
 		int size,
-		bool forum) {
+		bool forum,
+		bool allowDraft) {
 	Expects(cloud != nullptr || empty != nullptr);
 
 	const auto full = QSize(size, size);
@@ -36,7 +177,7 @@ void ValidateUserpicCache(
 		|| (cloud && !view.empty.null())
 		|| (empty && empty != view.empty.get())
 		|| (empty && view.paletteVersion != version);
-	if (!regenerate) {
+	if (!regenerate && !view.draft) {
 		return;
 	}
 	view.empty = empty;
@@ -44,20 +185,23 @@ void ValidateUserpicCache(
 	view.paletteVersion = version;
 
 	if (cloud) {
-		view.cached = cloud->scaled(
-			full,
-			Qt::IgnoreAspectRatio,
-			Qt::SmoothTransformation);
-		if (forum) {
-			view.cached = Images::Round(
-				std::move(view.cached),
-				Images::CornersMask(size
-					* Ui::ForumUserpicRadiusMultiplier()
-					/ style::DevicePixelRatio()));
-		} else {
-			view.cached = Images::Circle(std::move(view.cached));
+		auto scaled = allowDraft
+			? SharedCache().request(*cloud, size, forum)
+			: SharedCache().lookup(*cloud, size, forum);
+		if (!scaled.isNull()) {
+			view.cached = std::move(scaled);
+			view.draft = 0;
+		} else if (regenerate) {
+			// Shown until the smooth one is prepared in the background.
+			view.cached = GenerateUserpic(
+				*cloud,
+				size,
+				forum,
+				Qt::FastTransformation);
+			view.draft = 1;
 		}
 	} else {
+		view.draft = 0;
 		if (view.cached.size() != full) {
 			view.cached = QImage(full, QImage::Format_ARGB32_Premultiplied);
 		}
@@ -78,4 +222,40 @@ void ValidateUserpicCache(
 	}
 }
 
+} // namespace
+
+float64 ForumUserpicRadiusMultiplier() {
+	return 0.3;
+}
+
+bool PeerUserpicLoading(const PeerUserpicView &view) {
+	return view.cloud && view.cloud->isNull();
+}
+
+void ValidateUserpicCache(
+		PeerUserpicView &view,
+		const QImage *cloud,
+		const EmptyUserpic *empty,
+		int size,
+		bool forum) {
+	ValidateCache(view, cloud, empty, size, forum, false);
+}
+
+void ValidateUserpicCacheDraft(
+		PeerUserpicView &view,
+		const QImage *cloud,
+		const EmptyUserpic *empty,
+		int size,
+		bool forum) {
+	ValidateCache(view, cloud, empty, size, forum, true);
+}
+
+QImage SharedUserpicImage(const QImage &cloud, int size, bool forum) {
+	return SharedCache().lookup(cloud, size, forum);
+}
+
+rpl::producer<> SharedUserpicsPrepared() {
+	return SharedCache().prepared();
+}
+
 } // namespace Ui
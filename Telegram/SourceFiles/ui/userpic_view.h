@@ -25,8 +25,9 @@ struct PeerUserpicView {
 	QImage cached;
 	std::shared_ptr<QImage> cloud;
 	base::weak_ptr<const EmptyUserpic> empty;
-	uint32 paletteVersion : 31 = 0;
+	uint32 paletteVersion : 30 = 0;
 	uint32 forum : 1 = 0;
+	uint32 draft : 1 = 0;
 };
 
 [[nodiscard]] bool PeerUserpicLoading(const PeerUserpicView &view);
@@ -38,4 +39,24 @@ void ValidateUserpicCache(
 	int size,
 	bool forum);
 
+// Same, but if the scaled image is not in the shared cache yet, puts a
+// roughly scaled draft to the view and scales the image in the background.
+// Only for painting right to the screen, the view should be repainted
+// when SharedUserpicsPrepared() fires.
+void ValidateUserpicCacheDraft(
+	PeerUserpicView &view,
+	const QImage *cloud,
+	const EmptyUserpic *empty,
+	int size,
+	bool forum);
+
+// Scaled and rounded cloud userpic, shared by all views of the same image.
+[[nodiscard]] QImage SharedUserpicImage(
+	const QImage &cloud,
+	int size,
+	bool forum);
+
+// Fires when a userpic requested by ValidateUserpicCacheDraft is ready.
+[[nodiscard]] rpl::producer<> SharedUserpicsPrepared();
+
 } // namespace Ui
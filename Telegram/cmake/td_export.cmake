@@ -15,6 +15,8 @@ PRIVATE
     export/export_api_wrap.h
     export/export_controller.cpp
     export/export_controller.h
+    export/export_manifest.cpp
+    export/export_manifest.h
     export/export_pch.h
     export/export_settings.cpp
     export/export_settings.h
@@ -22,6 +24,8 @@ PRIVATE
     export/data/export_data_types.h
     export/output/export_output_abstract.cpp
     export/output/export_output_abstract.h
+    export/output/export_output_escape.cpp
+    export/output/export_output_escape.h
     export/output/export_output_file.cpp
     export/output/export_output_file.h
     export/output/export_output_html.cpp
@@ -8,6 +8,8 @@ add_library(td_mtproto OBJECT)
 init_non_host_target(td_mtproto)
 add_library(tdesktop::td_mtproto ALIAS td_mtproto)
 
+set_target_properties(td_mtproto PROPERTIES AUTOMOC ON)
+
 target_precompile_headers(td_mtproto PRIVATE ${src_loc}/mtproto/mtproto_pch.h)
 nice_target_sources(td_mtproto ${src_loc}
 PRIVATE
@@ -35,10 +37,12 @@ PRIVATE
     mtproto/details/mtproto_tcp_socket.h
     mtproto/details/mtproto_tls_socket.cpp
     mtproto/details/mtproto_tls_socket.h
+    mtproto/connection_abstract.cpp
+    mtproto/connection_abstract.h
+    mtproto/connection_tcp.cpp
+    mtproto/connection_tcp.h
     mtproto/mtproto_auth_key.cpp
     mtproto/mtproto_auth_key.h
-    mtproto/mtproto_concurrent_sender.cpp
-    mtproto/mtproto_concurrent_sender.h
     mtproto/mtproto_config.cpp
     mtproto/mtproto_config.h
     mtproto/mtproto_dc_options.cpp
@@ -63,3 +67,34 @@ PUBLIC
 PRIVATE
     desktop-app::external_zlib
 )
+
+option(TDESKTOP_BUILD_MTPROTO_BENCHMARK "Build the MTProto benchmark against a local fake DC." OFF)
+
+if (TDESKTOP_BUILD_MTPROTO_BENCHMARK)
+    add_executable(td_mtproto_benchmark)
+    init_non_host_target(td_mtproto_benchmark)
+
+    set_target_properties(td_mtproto_benchmark PROPERTIES AUTOMOC ON)
+
+    target_precompile_headers(td_mtproto_benchmark PRIVATE ${src_loc}/mtproto/mtproto_pch.h)
+    nice_target_sources(td_mtproto_benchmark ${src_loc}
+    PRIVATE
+        mtproto/benchmark/mtproto_benchmark_client.cpp
+        mtproto/benchmark/mtproto_benchmark_client.h
+        mtproto/benchmark/mtproto_benchmark_fake_dc.cpp
+        mtproto/benchmark/mtproto_benchmark_fake_dc.h
+        mtproto/benchmark/mtproto_benchmark_main.cpp
+    )
+
+    target_link_libraries(td_mtproto_benchmark
+    PRIVATE
+        tdesktop::td_mtproto
+        tdesktop::td_scheme
+        desktop-app::lib_base
+        desktop-app::lib_crl
+        desktop-app::lib_tl
+        desktop-app::external_openssl
+        desktop-app::external_zlib
+        desktop-app::external_qt
+    )
+endif()